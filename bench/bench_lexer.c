@@ -0,0 +1,87 @@
+// 词法分析器吞吐量基准测试 (make bench-lexer)
+//
+// 把输入文件反复拼接成一个大缓冲区 (默认 64 MB)，然后完整地跑几遍
+// get_next_token() 直到 EOF，报告最快一遍的 MB/s 和 token 数。
+//
+// 用法: bench_lexer [file] [size_mb] [rounds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lexer.h"
+
+static char* read_file(const char* filename, long* length) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open file '%s'\n", filename);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* buffer = (char*)malloc(*length + 1);
+    if (!buffer || fread(buffer, 1, *length, file) != (size_t)*length) {
+        fprintf(stderr, "Error: Could not read file '%s'\n", filename);
+        exit(1);
+    }
+    buffer[*length] = '\0';
+    fclose(file);
+    return buffer;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    const char* filename = argc >= 2 ? argv[1] : "tests/test.c";
+    long size_mb = argc >= 3 ? atol(argv[2]) : 64;
+    int rounds = argc >= 4 ? atoi(argv[3]) : 5;
+
+    long unit_length;
+    char* unit = read_file(filename, &unit_length);
+    if (unit_length == 0) {
+        fprintf(stderr, "Error: '%s' is empty\n", filename);
+        return 1;
+    }
+
+    // 1. 拼出一个大输入：每份之间用换行隔开，避免 token 粘连
+    long target = size_mb * 1024 * 1024;
+    long copies = target / (unit_length + 1) + 1;
+    long total = copies * (unit_length + 1);
+    char* source = (char*)malloc(total + 1);
+    if (!source) {
+        fprintf(stderr, "Error: Could not allocate %ld bytes\n", total + 1);
+        return 1;
+    }
+    for (long i = 0; i < copies; i++) {
+        memcpy(source + i * (unit_length + 1), unit, unit_length);
+        source[i * (unit_length + 1) + unit_length] = '\n';
+    }
+    source[total] = '\0';
+
+    // 2. 跑若干遍，取最快的一遍
+    double best = 1e30;
+    long tokens = 0;
+    for (int r = 0; r < rounds; r++) {
+        lexer_init(source);
+        long count = 0;
+        double start = now_seconds();
+        while (get_next_token().type != TOKEN_EOF) {
+            count++;
+        }
+        double elapsed = now_seconds() - start;
+        if (elapsed < best) best = elapsed;
+        tokens = count;
+    }
+
+    double mb = total / (1024.0 * 1024.0);
+    printf("lexer: %.1f MB, %ld tokens, best of %d: %.3f s, %.1f MB/s, %.1f Mtok/s\n",
+           mb, tokens, rounds, best, mb / best, tokens / best / 1e6);
+
+    free(source);
+    free(unit);
+    return 0;
+}
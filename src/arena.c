@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+// 每次向系统要的内存块大小。超过它的大对象单独占一块。
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+    ArenaBlock* next;   // 上一个 (更早的) 块
+    size_t capacity;    // data 的总大小
+    size_t offset;      // 下一次分配从 data[offset] 开始
+    // 块头后面紧跟着真正的数据区
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+static ArenaBlock* new_block(size_t min_size) {
+    size_t capacity = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + capacity);
+    if (!block) {
+        fprintf(stderr, "Error: Out of memory (arena)\n");
+        exit(1);
+    }
+    block->next = NULL;
+    block->capacity = capacity;
+    block->offset = 0;
+    return block;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->offset + size > block->capacity) {
+        // 当前块放不下了，换一个新块。
+        // 如果是一个超大对象，就让它独占一块，并挂在当前块后面，
+        // 这样当前块剩余的空间还可以继续给后面的小对象用。
+        ArenaBlock* fresh = new_block(size);
+        if (block != NULL && size > ARENA_BLOCK_SIZE / 4) {
+            fresh->next = block->next;
+            block->next = fresh;
+        } else {
+            fresh->next = block;
+            arena->head = fresh;
+        }
+        block = fresh;
+    }
+
+    void* ptr = block->data + block->offset;
+    block->offset += size;
+    arena->used += size;
+    return ptr;
+}
+
+void* arena_grow(Arena* arena, void* old, size_t old_count, size_t new_count, size_t elem_size) {
+    void* fresh = arena_alloc(arena, new_count * elem_size);
+    if (old != NULL && old_count > 0) {
+        memcpy(fresh, old, old_count * elem_size);
+    }
+    return fresh;
+}
+
+char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    char* copy = (char*)arena_alloc(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->used = 0;
+}
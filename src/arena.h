@@ -0,0 +1,28 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// --- 区域分配器 (Arena / Bump-Pointer Allocator) ---
+// 一次编译中产生的大量小对象 (AST 节点、名字、子节点数组) 生命周期完全相同：
+// 一起出生，一起死亡。所以没必要一个个 malloc/free，
+// 而是从大块内存里 "顺着往后切"，最后整个 arena 一次性释放。
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;   // 当前正在切分的内存块 (块之间用链表串起来)
+    size_t used;        // 所有块里已经分配出去的字节数 (统计用)
+} Arena;
+
+// 从 arena 中分配 size 字节 (16 字节对齐，内容未初始化)
+void* arena_alloc(Arena* arena, size_t size);
+// 把一个数组扩容到 new_count 个元素：在 arena 中分配新数组并拷贝旧内容。
+// 旧数组不会单独释放，而是随 arena 一起释放 (调用方应按倍数增长容量)。
+void* arena_grow(Arena* arena, void* old, size_t old_count, size_t new_count, size_t elem_size);
+// 复制一段长度为 len 的字符串 (不要求以 '\0' 结尾)，返回以 '\0' 结尾的副本
+char* arena_strndup(Arena* arena, const char* str, size_t len);
+// 一次性释放 arena 中的所有内存 (O(块数)，与对象个数无关)
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
@@ -3,9 +3,8 @@
 
 #include <stdlib.h> // 为了 size_t
 #include "lexer.h"
+#include "arena.h"
 
-#define MAX_MEMBERS 20
-#define MAX_STRUCTS 20
 
 typedef enum {
     NODE_NUMERIC_LITERAL,   // 数字字面量
@@ -37,6 +36,10 @@ typedef enum {
     // 未来可以在这里加 TYPE_VOID, TYPE_STRUCT 等
 } DataType;
 
+// 整个编译过程共用的 arena：所有 AST 节点、名字字符串、子节点数组都从这里分配，
+// 编译结束后调用 arena_free(&ast_arena) 一次性释放，不需要再递归遍历整棵树。
+extern Arena ast_arena;
+
 // AST 节点的通用结构体
 // 所有具体的节点都会包含这个作为头部，以便我们识别它的类型
 typedef struct ASTNode {
@@ -54,6 +57,7 @@ typedef struct {
     NodeType type;
     struct ASTNode** statements;
     int count;
+    int capacity;   // statements 数组的容量 (按 2 倍增长)
 } BlockStatementNode;
 
 
@@ -85,6 +89,7 @@ typedef struct {
     NodeType type; // 值为 NODE_PROGRAM
     struct ASTNode** declarations; // 存储程序中所有的函数声明
     int count; // 声明的数量
+    int capacity; // declarations 数组的容量 (按 2 倍增长)
 } ProgramNode;
 
 // 标识符节点 (e.g., 在 "return x;" 中的 x)
@@ -101,6 +106,7 @@ typedef struct {
     int array_size;  // 0 表示标量，>0 表示数组大小
     DataType var_type;
     char* struct_name; // 如果是结构体变量，记录是哪个结构体 (如 "Point")
+    int stack_offset;  // [代码生成用] scan_locals 为它分配的栈偏移 ([rbp-N] 中的 N)
 } VarDeclNode;
 
 // 二元运算符结点
@@ -170,17 +176,21 @@ typedef struct {
     int offset; // 成员相对于结构体起始位置的偏移量
 } MemberInfo;
 
+// 结构体定义。成员数量没有上限：members 按需增长，
+// member_index 是按成员名 (驻留指针) 哈希的开放寻址索引，槽位里存 下标+1，0 表示空
 typedef struct {
     char* name;
-    MemberInfo members[MAX_MEMBERS];
+    MemberInfo* members;
     int member_count;
+    int member_capacity;
+    int* member_index;
+    int member_index_capacity; // 总是 2 的幂
     int size;   // 总大小 (字节)
 } StructDef;
 
-extern StructDef struct_table[MAX_STRUCTS];
-extern int struct_count;
-
 // 辅助函数：定义结构体、查找结构体、查找成员
+// 结构体表本身是按名字哈希的可增长表，结构体个数也没有上限；
+// 所有 StructDef 都从 ast_arena 分配，指针在整个编译过程中有效
 StructDef* define_struct(char* name);
 void add_struct_member(StructDef* s, char* member_name, DataType type);
 StructDef* find_struct(char* name);
@@ -191,6 +201,9 @@ typedef struct {
     NodeType type;      // NODE_MEMBER_ACCESS
     char* struct_var_name; // 变量名 "p"
     char* member_name;     // 成员名 "x"
+    // 语法分析时就查好的成员信息，代码生成不用再查结构体表
+    int member_offset;     // 成员在结构体内的偏移量
+    DataType member_type;  // 成员类型
 } MemberAccessNode;
 
 // 原有工厂函数
@@ -215,6 +228,6 @@ ASTNode* create_break_node();
 ASTNode* create_continue_node();
 
 // 新工厂函数
-MemberAccessNode* create_member_access_node(char* var_name, char* member_name);
+MemberAccessNode* create_member_access_node(char* var_name, char* member_name, MemberInfo* member);
 
 #endif // AST_H
\ No newline at end of file
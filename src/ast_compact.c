@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ast_compact.h"
+
+// -----------
+// 池的分配
+// -----------
+
+static uint32_t next_capacity(uint32_t capacity) {
+    return capacity == 0 ? 64 : capacity * 2;
+}
+
+static void* resize_array(void* array, uint32_t capacity, size_t elem_size) {
+    array = realloc(array, capacity * elem_size);
+    if (!array) {
+        fprintf(stderr, "Error: Out of memory (compact AST)\n");
+        exit(1);
+    }
+    return array;
+}
+
+// 新建一个节点，返回它的下标 (a/b 先置 0，由调用方稍后填写)
+static NodeRef new_node(CompactAST* ast, NodeType kind) {
+    if (ast->node_count == ast->node_capacity) {
+        ast->node_capacity = next_capacity(ast->node_capacity);
+        ast->kind = resize_array(ast->kind, ast->node_capacity, sizeof(uint8_t));
+        ast->op = resize_array(ast->op, ast->node_capacity, sizeof(uint8_t));
+        ast->a = resize_array(ast->a, ast->node_capacity, sizeof(uint32_t));
+        ast->b = resize_array(ast->b, ast->node_capacity, sizeof(uint32_t));
+    }
+    NodeRef ref = ast->node_count++;
+    ast->kind[ref] = (uint8_t)kind;
+    ast->op[ref] = 0;
+    ast->a[ref] = 0;
+    ast->b[ref] = 0;
+    return ref;
+}
+
+// 在 extra 中预留 n 个连续位置，返回起始下标。
+// 注意：递归构建子节点时 extra 可能被扩容，所以只能保存下标，不能保存指针。
+static uint32_t reserve_extra(CompactAST* ast, uint32_t n) {
+    if (ast->extra_count + n > ast->extra_capacity) {
+        while (ast->extra_count + n > ast->extra_capacity) {
+            ast->extra_capacity = next_capacity(ast->extra_capacity);
+        }
+        ast->extra = resize_array(ast->extra, ast->extra_capacity, sizeof(uint32_t));
+    }
+    uint32_t start = ast->extra_count;
+    ast->extra_count += n;
+    return start;
+}
+
+static uint32_t add_string(CompactAST* ast, char* str) {
+    if (str == NULL) return STRING_REF_NONE;
+    if (ast->string_count == ast->string_capacity) {
+        ast->string_capacity = next_capacity(ast->string_capacity);
+        ast->strings = resize_array(ast->strings, ast->string_capacity, sizeof(char*));
+    }
+    ast->strings[ast->string_count] = str;
+    return ast->string_count++;
+}
+
+// -----------
+// 从指针 AST 转换
+// -----------
+
+// 前序编号：父节点总是排在子节点前面，遍历时基本是顺序访问内存
+static NodeRef build_node(CompactAST* ast, ASTNode* node) {
+    if (node == NULL) return NODE_REF_NONE;
+
+    NodeRef ref = new_node(ast, node->type);
+
+    switch (node->type) {
+        case NODE_PROGRAM: {
+            ProgramNode* prog = (ProgramNode*)node;
+            uint32_t start = reserve_extra(ast, prog->count);
+            for (int i = 0; i < prog->count; i++) {
+                NodeRef child = build_node(ast, prog->declarations[i]);
+                ast->extra[start + i] = child;
+            }
+            ast->a[ref] = start;
+            ast->b[ref] = prog->count;
+            break;
+        }
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            uint32_t start = reserve_extra(ast, block->count);
+            for (int i = 0; i < block->count; i++) {
+                NodeRef child = build_node(ast, block->statements[i]);
+                ast->extra[start + i] = child;
+            }
+            ast->a[ref] = start;
+            ast->b[ref] = block->count;
+            break;
+        }
+        case NODE_FUNCTION_DECL: {
+            FunctionDeclarationNode* func = (FunctionDeclarationNode*)node;
+            uint32_t start = reserve_extra(ast, 2 + func->arg_count);
+            ast->a[ref] = add_string(ast, func->name);
+            ast->b[ref] = start;
+            ast->extra[start + 1] = func->arg_count;
+            for (int i = 0; i < func->arg_count; i++) {
+                NodeRef arg = build_node(ast, func->args[i]);
+                ast->extra[start + 2 + i] = arg;
+            }
+            NodeRef body = build_node(ast, (ASTNode*)func->body);
+            ast->extra[start] = body;
+            break;
+        }
+        case NODE_RETURN_STATEMENT: {
+            ReturnStatementNode* ret = (ReturnStatementNode*)node;
+            NodeRef argument = build_node(ast, ret->argument);
+            ast->a[ref] = argument;
+            break;
+        }
+        case NODE_VAR_DECL: {
+            VarDeclNode* var = (VarDeclNode*)node;
+            uint32_t start = reserve_extra(ast, 4);
+            ast->a[ref] = add_string(ast, var->name);
+            ast->b[ref] = start;
+            NodeRef init = build_node(ast, var->initial_value);
+            ast->extra[start] = init;
+            ast->extra[start + 1] = (uint32_t)var->array_size;
+            ast->extra[start + 2] = (uint32_t)var->var_type;
+            ast->extra[start + 3] = add_string(ast, var->struct_name);
+            break;
+        }
+        case NODE_IDENTIFIER:
+            ast->a[ref] = add_string(ast, ((IdentifierNode*)node)->name);
+            break;
+        case NODE_NUMERIC_LITERAL:
+            ast->a[ref] = add_string(ast, ((NumericLiteralNode*)node)->value);
+            break;
+        case NODE_STRING_LITERAL:
+            ast->a[ref] = add_string(ast, ((StringLiteralNode*)node)->value);
+            break;
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            ast->op[ref] = (uint8_t)bin->op;
+            NodeRef left = build_node(ast, bin->left);
+            NodeRef right = build_node(ast, bin->right);
+            ast->a[ref] = left;
+            ast->b[ref] = right;
+            break;
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            ast->op[ref] = (uint8_t)unary->op;
+            NodeRef operand = build_node(ast, unary->operand);
+            ast->a[ref] = operand;
+            break;
+        }
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            uint32_t start = reserve_extra(ast, 2);
+            ast->b[ref] = start;
+            NodeRef cond = build_node(ast, stmt->condition);
+            NodeRef body = build_node(ast, stmt->body);
+            NodeRef else_branch = build_node(ast, stmt->else_branch);
+            ast->a[ref] = cond;
+            ast->extra[start] = body;
+            ast->extra[start + 1] = else_branch;
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            NodeRef cond = build_node(ast, stmt->condition);
+            NodeRef body = build_node(ast, stmt->body);
+            ast->a[ref] = cond;
+            ast->b[ref] = body;
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            uint32_t start = reserve_extra(ast, 4);
+            ast->a[ref] = start;
+            NodeRef init = build_node(ast, stmt->init);
+            NodeRef cond = build_node(ast, stmt->condition);
+            NodeRef inc = build_node(ast, stmt->increment);
+            NodeRef body = build_node(ast, stmt->body);
+            ast->extra[start] = init;
+            ast->extra[start + 1] = cond;
+            ast->extra[start + 2] = inc;
+            ast->extra[start + 3] = body;
+            break;
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            uint32_t start = reserve_extra(ast, 1 + call->arg_count);
+            ast->a[ref] = add_string(ast, call->name);
+            ast->b[ref] = start;
+            ast->extra[start] = call->arg_count;
+            for (int i = 0; i < call->arg_count; i++) {
+                NodeRef arg = build_node(ast, call->args[i]);
+                ast->extra[start + 1 + i] = arg;
+            }
+            break;
+        }
+        case NODE_ARRAY_ACCESS: {
+            ArrayAccessNode* access = (ArrayAccessNode*)node;
+            ast->a[ref] = add_string(ast, access->array_name);
+            NodeRef index = build_node(ast, access->index);
+            ast->b[ref] = index;
+            break;
+        }
+        case NODE_MEMBER_ACCESS: {
+            MemberAccessNode* access = (MemberAccessNode*)node;
+            ast->a[ref] = add_string(ast, access->struct_var_name);
+            ast->b[ref] = add_string(ast, access->member_name);
+            break;
+        }
+        default:
+            // BREAK / CONTINUE 没有任何字段
+            break;
+    }
+    return ref;
+}
+
+NodeRef compact_ast_build(CompactAST* ast, ASTNode* root) {
+    // 下标 0 保留给 "空节点" 和 "空字符串"
+    if (ast->node_count == 0) new_node(ast, NODE_PROGRAM);
+    if (ast->string_count == 0) add_string(ast, "");
+    return build_node(ast, root);
+}
+
+// -----------
+// 打印 (与 print_ast 的输出逐字节一致)
+// -----------
+
+static void print_indent(int indent) {
+    for (int i = 0; i < indent; i++) printf("  ");
+}
+
+void compact_ast_print(CompactAST* ast, NodeRef node, int indent) {
+    if (node == NODE_REF_NONE) return;
+
+    print_indent(indent);
+
+    uint32_t a = ast->a[node];
+    uint32_t b = ast->b[node];
+
+    switch ((NodeType)ast->kind[node]) {
+        case NODE_PROGRAM: {
+            printf("Program:\n");
+            for (uint32_t i = 0; i < b; i++) {
+                compact_ast_print(ast, ast->extra[a + i], indent + 1);
+            }
+            break;
+        }
+        case NODE_FUNCTION_DECL: {
+            printf("FunctionDeclaration: int %s()\n", ast->strings[a]);
+            uint32_t arg_count = ast->extra[b + 1];
+            if (arg_count > 0) {
+                print_indent(indent + 1);
+                printf("Args:\n");
+                for (uint32_t i = 0; i < arg_count; i++) {
+                    compact_ast_print(ast, ast->extra[b + 2 + i], indent + 2);
+                }
+            }
+            compact_ast_print(ast, ast->extra[b], indent + 1);
+            break;
+        }
+        case NODE_BLOCK_STATEMENT: {
+            printf("BlockStatement:\n");
+            for (uint32_t i = 0; i < b; i++) {
+                compact_ast_print(ast, ast->extra[a + i], indent + 1);
+            }
+            break;
+        }
+        case NODE_VAR_DECL: {
+            int array_size = (int)ast->extra[b + 1];
+            if (array_size > 0) {
+                printf("VarDecl: int %s[%d] (Array)\n", ast->strings[a], array_size);
+            } else {
+                printf("VarDecl: int %s\n", ast->strings[a]);
+            }
+            compact_ast_print(ast, ast->extra[b], indent + 1);
+            break;
+        }
+        case NODE_RETURN_STATEMENT: {
+            printf("ReturnStatement:\n");
+            compact_ast_print(ast, a, indent + 1);
+            break;
+        }
+        case NODE_IF_STATEMENT: {
+            printf("IfStatement:\n");
+            compact_ast_print(ast, a, indent + 1);
+            compact_ast_print(ast, ast->extra[b], indent + 1);
+            if (ast->extra[b + 1] != NODE_REF_NONE) {
+                print_indent(indent);
+                printf("Else:\n");
+                compact_ast_print(ast, ast->extra[b + 1], indent + 1);
+            }
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            printf("WhileStatement:\n");
+            compact_ast_print(ast, a, indent + 1);
+            compact_ast_print(ast, b, indent + 1);
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            printf("ForStatement:\n");
+            static const char* parts[] = {"Init:\n", "Condition:\n", "Increment:\n"};
+            for (int i = 0; i < 3; i++) {
+                if (ast->extra[a + i] != NODE_REF_NONE) {
+                    print_indent(indent + 1);
+                    printf("%s", parts[i]);
+                    compact_ast_print(ast, ast->extra[a + i], indent + 2);
+                }
+            }
+            print_indent(indent + 1);
+            printf("Body:\n");
+            compact_ast_print(ast, ast->extra[a + 3], indent + 2);
+            break;
+        }
+        case NODE_BINARY_OP: {
+            printf("BinaryOp (Token type: %d):\n", ast->op[node]);
+            compact_ast_print(ast, a, indent + 1);
+            compact_ast_print(ast, b, indent + 1);
+            break;
+        }
+        case NODE_UNARY_OP: {
+            printf("UnaryOp (Token type: %d):\n", ast->op[node]);
+            compact_ast_print(ast, a, indent + 1);
+            break;
+        }
+        case NODE_FUNCTION_CALL: {
+            printf("FunctionCall: %s(...)\n", ast->strings[a]);
+            uint32_t arg_count = ast->extra[b];
+            for (uint32_t i = 0; i < arg_count; i++) {
+                compact_ast_print(ast, ast->extra[b + 1 + i], indent + 1);
+            }
+            break;
+        }
+        case NODE_ARRAY_ACCESS: {
+            printf("ArrayAccess: %s[...]\n", ast->strings[a]);
+            compact_ast_print(ast, b, indent + 1);
+            break;
+        }
+        case NODE_IDENTIFIER:
+            printf("Identifier: %s\n", ast->strings[a]);
+            break;
+        case NODE_NUMERIC_LITERAL:
+            printf("NumericLiteral: %s\n", ast->strings[a]);
+            break;
+        case NODE_STRING_LITERAL:
+            printf("StringLiteral: \"%s\"\n", ast->strings[a]);
+            break;
+        default:
+            printf("Unknown Node (Type: %d)\n", ast->kind[node]);
+    }
+}
+
+size_t compact_ast_bytes(CompactAST* ast) {
+    return ast->node_count * (2 * sizeof(uint8_t) + 2 * sizeof(uint32_t))
+         + ast->extra_count * sizeof(uint32_t)
+         + ast->string_count * sizeof(char*);
+}
+
+void compact_ast_free(CompactAST* ast) {
+    free(ast->kind);
+    free(ast->op);
+    free(ast->a);
+    free(ast->b);
+    free(ast->extra);
+    free(ast->strings);
+    ast->kind = ast->op = NULL;
+    ast->a = ast->b = ast->extra = NULL;
+    ast->strings = NULL;
+    ast->node_count = ast->node_capacity = 0;
+    ast->extra_count = ast->extra_capacity = 0;
+    ast->string_count = ast->string_capacity = 0;
+}
@@ -0,0 +1,77 @@
+#ifndef AST_COMPACT_H
+#define AST_COMPACT_H
+
+#include <stdint.h>
+#include "ast.h"
+
+// --- 紧凑 AST (Compact AST) ---
+// 与 ast.h 中 "每个节点单独分配、用指针互相连接" 的表示不同，
+// 这里所有节点都放在几个连续的平行数组 (struct of arrays) 里：
+//
+//   kind[i]  节点类型 (NodeType)        1 字节
+//   op[i]    运算符 (TokenType)，仅运算节点使用  1 字节
+//   a[i]     第一个 32 位操作数
+//   b[i]     第二个 32 位操作数
+//
+// 子节点用 32 位下标 (NodeRef) 引用，而不是 8 字节指针。
+// 放不进 a/b 的数据 (子节点列表、if 的 else 分支、for 的四个部分...)
+// 放到公共的 extra 数组里，a 或 b 存它在 extra 中的起始下标。
+// 名字和字面量存在 strings 表里，a/b 存它的下标。
+//
+// 各类节点的字段布局：
+//   NUMERIC_LITERAL  a = 字面量字符串
+//   STRING_LITERAL   a = 字符串内容
+//   IDENTIFIER       a = 名字
+//   BLOCK/PROGRAM    a = extra 起始, b = 子节点个数 -> extra[a .. a+b)
+//   FUNCTION_DECL    a = 名字, b = extra 起始 -> [body, arg_count, args...]
+//   RETURN           a = 返回值表达式
+//   VAR_DECL         a = 名字, b = extra 起始 -> [初始值, array_size, var_type, struct_name]
+//   BINARY_OP        op, a = 左, b = 右
+//   UNARY_OP         op, a = 操作数
+//   IF               a = 条件, b = extra 起始 -> [body, else_branch]
+//   WHILE            a = 条件, b = 循环体
+//   FOR              a = extra 起始 -> [init, condition, increment, body]
+//   FUNCTION_CALL    a = 名字, b = extra 起始 -> [arg_count, args...]
+//   ARRAY_ACCESS     a = 数组名, b = 索引表达式
+//   MEMBER_ACCESS    a = 变量名, b = 成员名
+//   BREAK/CONTINUE   无
+//
+// 一个二元运算节点因此只占 10 字节，而指针版的 BinaryOpNode 在 64 位机器上是 32 字节。
+//
+// 目前只有 --dump-ast=compact 用它 (和 --dump-ast 的输出对照自检)，
+// 编译流程 (scan_locals、codegen_node、IR 构建) 仍然遍历指针 AST。
+
+typedef uint32_t NodeRef;
+#define NODE_REF_NONE 0     // 相当于 NULL；真正的节点从 1 开始编号
+#define STRING_REF_NONE 0   // 相当于 NULL 字符串；真正的字符串从 1 开始编号
+
+typedef struct {
+    // 节点池 (平行数组)
+    uint8_t*  kind;
+    uint8_t*  op;
+    uint32_t* a;
+    uint32_t* b;
+    uint32_t  node_count;
+    uint32_t  node_capacity;
+
+    // 额外数据池
+    uint32_t* extra;
+    uint32_t  extra_count;
+    uint32_t  extra_capacity;
+
+    // 字符串表 (字符串本身仍然归 ast_arena 所有，这里只记录指针)
+    char**    strings;
+    uint32_t  string_count;
+    uint32_t  string_capacity;
+} CompactAST;
+
+// 把指针形式的 AST 转换成紧凑形式，返回根节点的下标
+NodeRef compact_ast_build(CompactAST* ast, ASTNode* root);
+// 打印紧凑 AST，输出格式与 main.c 中的 print_ast 完全一致
+void compact_ast_print(CompactAST* ast, NodeRef node, int indent);
+// 节点池和额外数据池一共占用多少字节 (不含字符串本身)
+size_t compact_ast_bytes(CompactAST* ast);
+// 释放紧凑 AST 的所有池
+void compact_ast_free(CompactAST* ast);
+
+#endif // AST_COMPACT_H
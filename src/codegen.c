@@ -1,77 +1,956 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "codegen.h"
+#include "emit.h"
+#include "symtab.h"
+#include "strpool.h"
+#include "strength.h"
+#include "isel.h"
 #include <string.h>
 
-static void scan_locals(ASTNode* node, int* current_stack_offset);
+// 局部变量的栈位置按作用域分配 (栈槽着色)：作用域结束以后它的变量就都死了，
+// 后面的兄弟作用域 (if 和 else 两边、先后两个循环、内联展开出来的块) 从同一个位置接着分配，共用这段栈空间。
+// size 是分配到过的最大位置 (栈帧真正要留的大小)，unshared 是每个变量各占一块时的大小 (--frame-report 用)
+typedef struct {
+    int size;
+    int unshared;
+} FrameUsage;
+
+// offset 是 node 之前已经分配到的位置，返回 node 之后的位置 (声明让它变大，作用域结束又退回来)
+static int scan_locals(ASTNode* node, int offset, FrameUsage* usage);
 
-// 由于 C 语言处理字符串麻烦，我们还是存 ID 和 类型 吧。
+// 由于 C 语言处理字符串麻烦，我们还是存 ID 吧 (break/continue 用它拼出标签)。
 static int current_loop_id = -1;
-static int current_loop_type = 0; // 0: None, 1: While, 2: For
 
 // 一个全局计数器，用于生成唯一的标签
 static int label_counter = 0;
 
-// --- 简易符号表 ---
-typedef struct {
-    char* name;
-    int stack_offset; // 变量在栈上的偏移量
-    int type;   // 0: int, 1: char (对应 DataType 枚举)
-    char* struct_name;
-} Symbol;
+// 尾调用：当前函数、它的栈帧会不会被别人引用 (frame_escapes)，
+// 以及自递归尾调用跳回去的标签 (.L_tail_N，-1 表示函数里没有自递归尾调用)
+static FunctionDeclarationNode* current_function = NULL;
+static int frame_escapes = 0;
+static int tail_label = -1;
 
-Symbol symbol_table[100]; // 假设最多100个局部变量
-int symbol_count = 0;
+// --- 符号表 ---
+// 局部变量的查找见 symtab.h (哈希表 + 作用域栈)。
+// 栈偏移由 scan_locals 预先算好并记在 VarDeclNode 上，
+// 代码生成走到声明处时才把变量登记到当前作用域。
 
 // --- 字符串池 ---
-struct {
-    char* content;
-    int id;
-} string_pool[100]; // 假设最多100个字符串
-int string_count = 0;
+// 见 strpool.h (按驻留指针哈希去重，容量不限，输出到可合并的字符串段)
+
+// 声明我们将要使用的递归函数
+static void codegen_node(ASTNode* node);
+
+// --- 表达式代码生成：临时寄存器池 + Sethi–Ullman 求值顺序 ---
+//
+// 以前每个二元运算都是 "算右边 -> push -> 算左边 -> pop"，每一步都要走一趟内存。
+// 现在表达式的中间结果放在一组临时寄存器里：
+//   * 值栈 (value stack)：每个已经算出、还没被用掉的中间结果占一项，记录它在哪个寄存器；
+//   * 寄存器不够用时，把值栈里 "最老的" 那个值 push 到栈上 (溢出)，
+//     所以被溢出的值总是值栈底部连续的一段，用到它时按后进先出的顺序 pop 回来即可；
+//   * 二元运算先算 "需要寄存器更多" 的那棵子树 (Sethi–Ullman 编号)，
+//     这样另一棵子树算的时候占用的寄存器最少，基本不会溢出。
+// 函数调用会破坏所有临时寄存器 (都是 caller-saved)，所以调用前把参数以外的活值全部溢出；
+// 调用的编号记为 NUM_SCRATCH，保证它总是被先算，这时通常根本没有别的活值。
+
+enum {
+    REG_RAX, REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9, REG_R10, REG_R11,
+    NUM_SCRATCH
+};
+static const char* reg64[NUM_SCRATCH] = {"rax", "rdi", "rsi", "rdx", "rcx", "r8", "r9", "r10", "r11"};
+static const char* reg8[NUM_SCRATCH]  = {"al", "dil", "sil", "dl", "cl", "r8b", "r9b", "r10b", "r11b"};
+// 前 6 个整数参数依次放在 rdi, rsi, rdx, rcx, r8, r9
+static const int arg_regs[6] = {REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9};
+
+static int reg_owner[NUM_SCRATCH]; // 寄存器里放的是值栈里的第几项，-1 表示空闲
+
+static int* value_reg = NULL;   // 值栈：每一项所在的寄存器，-1 表示已经溢出到栈上
+static int value_count = 0;
+static int value_capacity = 0;
+static int spilled_count = 0;   // 值栈底部已经溢出的项数 (也就是表达式求值期间 push 了几次)
+
+// --- 栈帧 ---
+// 局部变量 x 离 "栈帧基址" 的距离是 x.stack_offset (scan_locals 算好的)，地址统一用 frame_addr 拼出来。
+// 默认不用 rbp (省略帧指针)，基址就是函数入口处的 rsp：
+//   * FRAME_RSP：序言只有一条 sub rsp, N (N ≡ 8 mod 16，调用时 rsp 正好 16 字节对齐)，
+//     变量在 [rsp + N - off]；表达式求值时每 push 一次 rsp 又往下走 8，偏移跟着 spilled_count 加；
+//   * FRAME_RED_ZONE：叶子函数 (不 call、也不 push) 的变量不超过 128 字节时，
+//     直接放在 rsp 下面的红区 (red zone) 里 [rsp - off]，没有序言，返回就是一条 ret；
+//   * FRAME_RBP：-fno-omit-frame-pointer，老样子 push rbp; mov rbp, rsp，变量在 [rbp - off]，
+//     profiler / 调试器可以顺着 rbp 链回溯调用栈。
+// 函数是不是叶子要生成完才知道：先按红区生成，中途碰到 call 或 push 就丢掉重来 (见 codegen_function_declaration)
+typedef enum {
+    FRAME_RBP,
+    FRAME_RSP,
+    FRAME_RED_ZONE,
+} FrameMode;
+
+int omit_frame_pointer = 1;
+static FrameMode frame_mode = FRAME_RBP;
+static int frame_size = 0;          // sub rsp 减掉的字节数
+static int red_zone_violated = 0;   // 红区模式下生成了 call 或 push
+static int locals_size = 0;         // 参数和局部变量一共占多少字节 (作用域不重叠的变量共用空间)
+static int locals_unshared = 0;     // 不共用时要占多少字节
+int frame_report = 0;
+
+static const char* frame_reg() {
+    return frame_mode == FRAME_RBP ? "rbp" : "rsp";
+}
+
+// 相对基址的位移 (变量 x 是 -x.stack_offset) 换算成相对 frame_reg() 的位移
+static long frame_disp(long disp) {
+    if (frame_mode == FRAME_RSP) return disp + frame_size + 8L * spilled_count;
+    return disp;
+}
+
+// 离基址 offset 字节的位置: "rbp-16"、"rsp+8"、"rsp"。
+// 两个缓冲区轮流用，一条指令里可以出现两个地址；rsp 相对的偏移和当前的 spilled_count 有关，拿到就要马上用
+static const char* frame_addr(int offset) {
+    static char buffers[2][32];
+    static int next = 0;
+    char* buf = buffers[next];
+    next ^= 1;
+    long disp = frame_disp(-(long)offset);
+    if (disp == 0) snprintf(buf, sizeof(buffers[0]), "%s", frame_reg());
+    else snprintf(buf, sizeof(buffers[0]), "%s%+ld", frame_reg(), disp);
+    return buf;
+}
+
+void print_frame_report(const char* name, int locals_unshared, int locals_shared, int frame) {
+    fprintf(stderr, "frame: %s: locals %d -> %d bytes, frame %d bytes\n", name, locals_unshared, locals_shared, frame);
+}
+
+// 拆掉栈帧，rsp 回到函数入口时的位置 (栈顶是返回地址)
+static void emit_frame_teardown() {
+    if (frame_mode == FRAME_RBP) {
+        emit("  mov rsp, rbp\n");
+        emit("  pop rbp\n");
+    } else if (frame_mode == FRAME_RSP) {
+        emit("  add rsp, %d\n", frame_size);
+    }
+}
+
+static void gen_expr(ASTNode* node);
+static void gen_lvalue(ASTNode* node);
 
-// 添加字符串到池中，返回其 ID
-int add_string_to_pool(char* content) {
-    // 简单的去重逻辑（可选）：如果内容一样，返回同一个ID
-    for(int i=0; i<string_count; i++) {
-        if (strcmp(string_pool[i].content, content) == 0) {
-            return string_pool[i].id;
+static void reset_registers() {
+    for (int i = 0; i < NUM_SCRATCH; i++) reg_owner[i] = -1;
+    value_count = 0;
+    spilled_count = 0;
+}
+
+// 把值栈里最老的、还在寄存器里的值 push 到栈上，腾出它的寄存器
+static void spill_oldest() {
+    int v = spilled_count;
+    int reg = value_reg[v];
+    if (frame_mode == FRAME_RED_ZONE) red_zone_violated = 1; // push 会覆盖红区里的变量
+    emit("  push %s\n", reg64[reg]);
+    reg_owner[reg] = -1;
+    value_reg[v] = -1;
+    spilled_count++;
+}
+
+static int find_free_reg() {
+    for (int i = 0; i < NUM_SCRATCH; i++) {
+        if (reg_owner[i] == -1) return i;
+    }
+    return -1;
+}
+
+// 取一个空闲寄存器；一个都没有时才溢出
+static int alloc_reg() {
+    int reg = find_free_reg();
+    while (reg == -1) {
+        spill_oldest();
+        reg = find_free_reg();
+    }
+    return reg;
+}
+
+// reg 里的新结果压到值栈顶
+static void push_value(int reg) {
+    if (value_count == value_capacity) {
+        value_capacity = value_capacity == 0 ? 64 : value_capacity * 2;
+        value_reg = (int*)realloc(value_reg, value_capacity * sizeof(int));
+        if (!value_reg) {
+            fprintf(stderr, "Error: Out of memory (codegen)\n");
+            exit(1);
         }
     }
-    
-    int id = string_count;
-    string_pool[id].content = content;
-    string_pool[id].id = id;
-    string_count++;
-    return id;
+    value_reg[value_count] = reg;
+    reg_owner[reg] = value_count;
+    value_count++;
+}
+
+// 保证值栈顶部的 n 项都在寄存器里。溢出的是底部连续的一段，
+// 所以从栈顶往下找到的第一个溢出项，正好就是最后 push 的那个
+static void ensure_top(int n) {
+    for (int i = value_count - 1; i >= value_count - n; i--) {
+        if (value_reg[i] != -1) continue;
+        int reg = alloc_reg();
+        emit("  pop %s\n", reg64[reg]);
+        value_reg[i] = reg;
+        reg_owner[reg] = i;
+        spilled_count--;
+    }
+}
+
+// 值栈顶往下第 depth 项 (0 是栈顶) 所在的寄存器，调用前先 ensure_top
+static int top_reg(int depth) {
+    return value_reg[value_count - 1 - depth];
+}
+
+// 弹出栈顶的值，返回它所在的寄存器。寄存器随即被释放，调用方要马上用掉它
+static int pop_value() {
+    ensure_top(1);
+    int reg = value_reg[--value_count];
+    reg_owner[reg] = -1;
+    return reg;
+}
+
+// 把占着 reg 的值挪到别的寄存器 (不会挪到 avoid 里的寄存器)，让 reg 空出来
+static void evict_reg(int reg, int avoid1, int avoid2) {
+    while (reg_owner[reg] != -1) {
+        int dest = -1;
+        for (int i = 0; i < NUM_SCRATCH; i++) {
+            if (reg_owner[i] == -1 && i != avoid1 && i != avoid2) { dest = i; break; }
+        }
+        if (dest == -1) {
+            spill_oldest(); // 寄存器全满：溢出一个 (可能正好就是 reg 里的值)
+            continue;
+        }
+        int v = reg_owner[reg];
+        emit("  mov %s, %s\n", reg64[dest], reg64[reg]);
+        value_reg[v] = dest;
+        reg_owner[dest] = v;
+        reg_owner[reg] = -1;
+    }
+}
+
+// 求值后把结果从值栈上取下来，返回它所在的寄存器 (语句层面用：条件、return、初始化)
+static int gen_expr_value(ASTNode* node) {
+    gen_expr(node);
+    return pop_value();
+}
+
+// 只有局部的 int 变量 (以及全局变量) 可以直接当内存操作数用，char 需要零扩展
+static Symbol* int_local(ASTNode* node) {
+    Symbol* sym = find_symbol(((IdentifierNode*)node)->name);
+    return (sym && sym->type != TYPE_CHAR) ? sym : NULL;
+}
+
+// 右操作数是否可以不占寄存器，直接写进指令里 (32 位立即数，或者 int 变量的内存操作数)
+static int is_direct_operand(ASTNode* node) {
+    if (node->type == NODE_NUMERIC_LITERAL) {
+        long value = strtol(((NumericLiteralNode*)node)->value, NULL, 10);
+        return value >= -2147483648L && value <= 2147483647L;
+    }
+    if (node->type == NODE_IDENTIFIER) {
+        return find_symbol(((IdentifierNode*)node)->name) == NULL || int_local(node) != NULL;
+    }
+    return 0;
+}
+
+static void emit_direct_operand(ASTNode* node) {
+    if (node->type == NODE_NUMERIC_LITERAL) {
+        emit_str(((NumericLiteralNode*)node)->value);
+        return;
+    }
+    IdentifierNode* ident = (IdentifierNode*)node;
+    Symbol* sym = find_symbol(ident->name);
+    if (sym) {
+        emit("qword ptr [%s]", frame_addr(sym->stack_offset));
+    } else {
+        emit("qword ptr [rip + %s]", ident->name);
+    }
+}
+
+// Sethi–Ullman 编号：不溢出地算完这棵子树最少需要几个寄存器
+static int reg_need(ASTNode* node) {
+    switch (node->type) {
+        case NODE_UNARY_OP:
+            return reg_need(((UnaryOpNode*)node)->operand);
+        case NODE_ARRAY_ACCESS:
+            return reg_need(((ArrayAccessNode*)node)->index);
+        case NODE_FUNCTION_CALL:
+            return NUM_SCRATCH; // 调用会破坏所有临时寄存器，让它最先算
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            if (bin->op == TOKEN_LOGIC_AND || bin->op == TOKEN_LOGIC_OR) {
+                return NUM_SCRATCH; // 短路求值前会把活值都溢出，同样让它最先算
+            }
+            int l = reg_need(bin->left);
+            int r = is_direct_operand(bin->right) ? 0 : reg_need(bin->right);
+            if (l == r) return l + 1;
+            return l > r ? l : r;
+        }
+        default:
+            return 1; // 数字、变量、字符串、p.x
+    }
+}
+
+static void gen_numeric_literal(NumericLiteralNode* node) {
+    int reg = alloc_reg();
+    emit_load_constant(reg64[reg], strtol(node->value, NULL, 10)); // xor / 32 位 mov
+    push_value(reg);
+}
+
+static void gen_identifier(IdentifierNode* node) {
+    int reg = alloc_reg();
+    Symbol* symbol = find_symbol(node->name);
+
+    if (symbol) {
+        if (symbol->type == TYPE_CHAR) {
+            // 读 1 字节并零扩展
+            emit("  movzx %s, byte ptr [%s]\n", reg64[reg], frame_addr(symbol->stack_offset));
+        } else {
+            // 读 8 字节
+            emit("  mov %s, [%s]\n", reg64[reg], frame_addr(symbol->stack_offset));
+        }
+    } else {
+        // 全局变量处理... 暂时假设全局只有 int，或者你也得给全局变量表加类型
+        emit("  mov %s, [rip + %s]\n", reg64[reg], node->name);
+    }
+    push_value(reg);
+}
+
+static void gen_string_literal(StringLiteralNode* node) {
+    // 1. 把它注册到全局池子，拿到一个唯一的 ID (例如 0)
+    int id = strpool_add(node->value);
+
+    // 2. 生成获取地址的指令
+    // 我们约定 .LC0, .LC1 作为字符串的标签
+    int reg = alloc_reg();
+    emit("  lea %s, [rip + .LC%d]\n", reg64[reg], id);
+    push_value(reg);
+}
+
+// 数组元素的寻址模式：一个 x86 内存操作数 [rbp + index*8 - disp]，
+// 不再先把地址算进寄存器再解引用。下标里的常量部分 (a[3]、a[i+1]) 折进位移
+typedef struct {
+    int has_index;  // 下标要用寄存器：算好后留在值栈上
+    long disp;      // 相对栈帧基址的位移 (输出时才换算成 rbp / rsp 相对的，见 frame_disp)
+} ArrayAddress;
+
+static ArrayAddress gen_array_address(ArrayAccessNode* access) {
+    Symbol* sym = find_symbol(access->array_name);
+    if (!sym) { fprintf(stderr, "Undefined array %s\n", access->array_name); exit(1); }
+
+    ArrayAddress addr = {0, -(long)sym->stack_offset};
+    ASTNode* index = access->index;
+    // 下标形如 "表达式 ± 常量"：常量部分 * 8 加到位移上
+    while (index->type == NODE_BINARY_OP) {
+        BinaryOpNode* bin = (BinaryOpNode*)index;
+        if ((bin->op != TOKEN_PLUS && bin->op != TOKEN_MINUS) || bin->right->type != NODE_NUMERIC_LITERAL) break;
+        long value = strtol(((NumericLiteralNode*)bin->right)->value, NULL, 10);
+        long disp = addr.disp + (bin->op == TOKEN_PLUS ? value : -value) * 8;
+        if (value < -(1L << 28) || value > (1L << 28) || disp < -2147483648L || disp > 2147483647L) break;
+        addr.disp = disp;
+        index = bin->left;
+    }
+    if (index->type == NODE_NUMERIC_LITERAL) {
+        long value = strtol(((NumericLiteralNode*)index)->value, NULL, 10);
+        long disp = addr.disp + value * 8;
+        if (value >= -(1L << 28) && value <= (1L << 28) && disp >= -2147483648L && disp <= 2147483647L) {
+            addr.disp = disp;
+            return addr;
+        }
+    }
+
+    gen_expr(index);
+    addr.has_index = 1;
+    return addr;
+}
+
+// 输出 "[rbp+r*8-disp]" (不用帧指针时是 rsp)，index_reg 是下标所在的寄存器 (has_index 时)
+static void emit_array_operand(ArrayAddress* addr, int index_reg) {
+    long disp = frame_disp(addr->disp);
+    emit("[%s", frame_reg());
+    if (addr->has_index) emit("+%s*8", reg64[index_reg]);
+    if (disp < 0) emit("-%ld", -disp);
+    else if (disp > 0) emit("+%ld", disp);
+    emit("]");
+}
+
+static void gen_branch(ASTNode* node, int jump_if_true, const char* target);
+
+// 逻辑与 / 逻辑或 (短路求值) 的值：整个条件当成跳转链生成 (gen_branch)，只在最后物化一次 0/1。
+// 两条路径汇合时寄存器的状态必须一样，所以开始前先把所有活值溢出，
+// 里面算出来的临时值都在各自的路径里用完
+static void gen_logical_op(BinaryOpNode* node) {
+    while (spilled_count < value_count) spill_oldest();
+
+    int label_id = label_counter++; // 申请一个唯一ID
+    char false_label[32];
+    snprintf(false_label, sizeof(false_label), ".L_false_%d", label_id);
+    gen_branch((ASTNode*)node, 0, false_label);
+
+    int result = alloc_reg();
+    emit_load_constant(reg64[result], 1);
+    emit("  jmp .L_end_%d\n", label_id);
+    emit("%s:\n", false_label);
+    emit_load_constant(reg64[result], 0);
+    emit(".L_end_%d:\n", label_id);
+    push_value(result);
+}
+
+// 赋值：先算右值，再写到左边。结果 (右值) 留在值栈上
+static void gen_assign(BinaryOpNode* node) {
+    gen_expr(node->right);
+
+    // 左边是变量或 p.x 时地址是常量，直接写内存，不用先算地址
+    if (node->left->type == NODE_IDENTIFIER) {
+        IdentifierNode* ident = (IdentifierNode*)node->left;
+        Symbol* sym = find_symbol(ident->name);
+        ensure_top(1);
+        int value = top_reg(0);
+        if (!sym) {
+            emit("  mov [rip + %s], %s\n", ident->name, reg64[value]);
+        } else if (sym->type == TYPE_CHAR) {
+            // char 类型赋值：只写 1 字节
+            emit("  mov [%s], %s\n", frame_addr(sym->stack_offset), reg8[value]);
+        } else {
+            emit("  mov [%s], %s\n", frame_addr(sym->stack_offset), reg64[value]);
+        }
+        return;
+    }
+    if (node->left->type == NODE_MEMBER_ACCESS) {
+        MemberAccessNode* access = (MemberAccessNode*)node->left;
+        Symbol* sym = find_symbol(access->struct_var_name);
+        ensure_top(1);
+        emit("  mov [%s], %s\n", frame_addr(sym->stack_offset - access->member_offset), reg64[top_reg(0)]);
+        return;
+    }
+
+    if (node->left->type == NODE_ARRAY_ACCESS) {
+        // a[i] = v：mov [rbp+i*8-off], v，不用先算地址
+        ArrayAddress addr = gen_array_address((ArrayAccessNode*)node->left);
+        ensure_top(addr.has_index ? 2 : 1);
+        int value = top_reg(addr.has_index ? 1 : 0);
+        emit("  mov qword ptr ");
+        emit_array_operand(&addr, addr.has_index ? top_reg(0) : -1);
+        emit(", %s\n", reg64[value]);
+        if (addr.has_index) pop_value(); // 下标用完了
+        return;
+    }
+
+    gen_lvalue(node->left);
+    ensure_top(2);
+    int address = top_reg(0);
+    int value = top_reg(1);
+    emit("  mov [%s], %s\n", reg64[address], reg64[value]);
+    pop_value(); // 地址用完了
 }
 
-// 在符号表中查找一个变量
-Symbol* find_symbol(char* name) {
-    for (int i = 0; i < symbol_count; i++) {
-        if (strcmp(symbol_table[i].name, name) == 0) {
-            return &symbol_table[i];
+// 能直接当 8 字节内存操作数用的位置 (int 局部变量、全局变量、int 成员 p.x)，写进 buf。
+// 同一个位置得到的字符串相同，可以直接比较
+static int scalar_memory_operand(ASTNode* node, char* buf, size_t size) {
+    if (node->type == NODE_IDENTIFIER) {
+        IdentifierNode* ident = (IdentifierNode*)node;
+        Symbol* sym = find_symbol(ident->name);
+        if (!sym) {
+            snprintf(buf, size, "qword ptr [rip + %s]", ident->name);
+        } else if (sym->type == TYPE_INT) {
+            snprintf(buf, size, "qword ptr [%s]", frame_addr(sym->stack_offset));
+        } else {
+            return 0;
+        }
+        return 1;
+    }
+    if (node->type == NODE_MEMBER_ACCESS) {
+        MemberAccessNode* access = (MemberAccessNode*)node;
+        if (access->member_type != TYPE_INT) return 0;
+        Symbol* sym = find_symbol(access->struct_var_name);
+        snprintf(buf, size, "qword ptr [%s]", frame_addr(sym->stack_offset - access->member_offset));
+        return 1;
+    }
+    return 0;
+}
+
+// 结果不用的赋值语句 (x = 5; x = x + 1; x = x - y; ...) 直接对内存操作，
+// 不用 "读进寄存器 -> 运算 -> 写回" 三条指令。不适用时返回 0，什么都不生成
+static int gen_assign_in_place(BinaryOpNode* node) {
+    char target[64];
+    if (node->op != TOKEN_ASSIGN || !scalar_memory_operand(node->left, target, sizeof(target))) return 0;
+
+    long value;
+    if (node->right->type == NODE_NUMERIC_LITERAL) {
+        value = strtol(((NumericLiteralNode*)node->right)->value, NULL, 10);
+        if (!fits_imm32(value)) return 0;
+        emit("  mov %s, %ld\n", target, value);
+        return 1;
+    }
+    if (node->right->type != NODE_BINARY_OP) return 0;
+    BinaryOpNode* bin = (BinaryOpNode*)node->right;
+    if (bin->op != TOKEN_PLUS && bin->op != TOKEN_MINUS) return 0;
+
+    // x = x + e、x = x - e、x = e + x
+    char operand[64];
+    ASTNode* other;
+    if (scalar_memory_operand(bin->left, operand, sizeof(operand)) && strcmp(operand, target) == 0) {
+        other = bin->right;
+    } else if (bin->op == TOKEN_PLUS && scalar_memory_operand(bin->right, operand, sizeof(operand)) &&
+               strcmp(operand, target) == 0) {
+        other = bin->left;
+    } else {
+        return 0;
+    }
+
+    if (other->type == NODE_NUMERIC_LITERAL) {
+        value = strtol(((NumericLiteralNode*)other)->value, NULL, 10);
+        if (bin->op == TOKEN_MINUS) value = -value;
+        if (fits_imm32(value)) {
+            emit_add_to_memory(target, value); // inc / dec / add qword ptr [...], imm
+            return 1;
+        }
+    }
+    int reg = gen_expr_value(other);
+    emit("  %s %s, %s\n", bin->op == TOKEN_PLUS ? "add" : "sub", target, reg64[reg]);
+    return 1;
+}
+
+// 除法：idiv 的被除数固定在 rdx:rax，商在 rax，rdx 会被覆盖，除数不能在这两个寄存器里。
+// 所以先把别的值从 rax/rdx 里请出去
+static void gen_division(int left_index, int right_index) {
+    int left = value_reg[left_index];
+    if (left != REG_RAX) {
+        evict_reg(REG_RAX, REG_RDX, -1);
+        emit("  mov rax, %s\n", reg64[left]);
+        reg_owner[left] = -1;
+        value_reg[left_index] = REG_RAX;
+        reg_owner[REG_RAX] = left_index;
+    }
+    evict_reg(REG_RDX, REG_RAX, -1);
+    emit("  cqo\n");
+    emit("  idiv %s\n", reg64[value_reg[right_index]]);
+}
+
+// operand * c 或 operand / c (c 是字面量)。不能削弱时返回 0，什么都不生成
+static int gen_by_constant(TokenType op, ASTNode* operand, ASTNode* constant) {
+    long c = strtol(((NumericLiteralNode*)constant)->value, NULL, 10);
+    if (op == TOKEN_STAR ? !can_mul_by_constant(c) : !can_div_by_constant(c)) return 0;
+
+    gen_expr(operand);
+    ensure_top(1);
+    if (op == TOKEN_STAR) {
+        emit_mul_by_constant(reg64[top_reg(0)], c);
+    } else if (!div_needs_magic(c)) {
+        int tmp = alloc_reg(); // 只在这几条指令里用，不压到值栈上
+        emit_div_by_pow2(reg64[top_reg(0)], c, reg64[tmp]);
+    } else {
+        // 魔数乘法的结果在 rdx，rax 也会被覆盖：和 idiv 一样先把这两个寄存器腾出来
+        evict_reg(REG_RAX, REG_RDX, -1);
+        evict_reg(REG_RDX, REG_RAX, -1);
+        emit_div_by_magic(reg64[top_reg(0)], c);
+        pop_value();
+        push_value(REG_RDX);
+    }
+    return 1;
+}
+
+static int is_comparison(TokenType op) {
+    return op == TOKEN_EQ || op == TOKEN_NEQ || op == TOKEN_LT ||
+           op == TOKEN_LE || op == TOKEN_GT || op == TOKEN_GE;
+}
+
+// 比较运算对应的条件码 (setCC / jCC 的 CC)，negate 时取反
+static const char* condition_code(TokenType op, int negate) {
+    switch (op) {
+        case TOKEN_EQ:  return negate ? "ne" : "e";  // Equal
+        case TOKEN_NEQ: return negate ? "e" : "ne";  // Not Equal
+        case TOKEN_LT:  return negate ? "ge" : "l";  // Less
+        case TOKEN_LE:  return negate ? "g" : "le";  // Less or Equal
+        case TOKEN_GT:  return negate ? "le" : "g";  // Greater
+        case TOKEN_GE:  return negate ? "l" : "ge";  // Greater or Equal
+        default:
+            fprintf(stderr, "Codegen: Unsupported binary operator\n");
+            exit(1);
+    }
+}
+
+// 算术运算：结果留在值栈顶。
+// 比较运算：只生成 cmp，结果在标志位里 (值栈顶是左操作数，调用方负责弹掉或改写它)
+static void gen_operation(BinaryOpNode* node) {
+    // 乘除常数：换成移位 / lea / 魔数乘法 (strength.c)
+    if (node->op == TOKEN_STAR || node->op == TOKEN_SLASH) {
+        ASTNode* operand = node->left;
+        ASTNode* constant = node->right;
+        if (node->op == TOKEN_STAR && constant->type != NODE_NUMERIC_LITERAL) {
+            operand = node->right; // 乘法可交换：3 * x 和 x * 3 一样
+            constant = node->left;
+        }
+        if (constant->type == NODE_NUMERIC_LITERAL && gen_by_constant(node->op, operand, constant)) return;
+    }
+
+    // 右边是立即数或 int 变量：只需要把左边算进寄存器，右边直接写进指令
+    if (node->op != TOKEN_SLASH && is_direct_operand(node->right)) {
+        gen_expr(node->left);
+        ensure_top(1);
+        const char* left = reg64[top_reg(0)];
+        if (node->right->type == NODE_NUMERIC_LITERAL) {
+            // 加减常数用 inc / dec / add，和 0 比较用 test
+            long value = strtol(((NumericLiteralNode*)node->right)->value, NULL, 10);
+            if (node->op == TOKEN_PLUS || (node->op == TOKEN_MINUS && value != -2147483648L)) {
+                emit_add_constant(left, left, node->op == TOKEN_PLUS ? value : -value);
+                return;
+            }
+            if (is_comparison(node->op) && value == 0) {
+                emit_test_zero(left);
+                return;
+            }
+        }
+        switch (node->op) {
+            case TOKEN_PLUS:  emit("  add %s, ", left); break;
+            case TOKEN_MINUS: emit("  sub %s, ", left); break;
+            case TOKEN_STAR:
+                // imul 的立即数形式是三操作数的
+                if (node->right->type == NODE_NUMERIC_LITERAL) emit("  imul %s, %s, ", left, left);
+                else emit("  imul %s, ", left);
+                break;
+            default:          emit("  cmp %s, ", left); break;
+        }
+        emit_direct_operand(node->right);
+        emit("\n");
+    } else {
+        // 先算需要寄存器多的一边；一样多时先算右边 (和以前的求值顺序一致)
+        int left_first = reg_need(node->left) > reg_need(node->right);
+        if (left_first) {
+            gen_expr(node->left);
+            gen_expr(node->right);
+        } else {
+            gen_expr(node->right);
+            gen_expr(node->left);
+        }
+        ensure_top(2);
+        int left_index = left_first ? value_count - 2 : value_count - 1;
+        int right_index = left_first ? value_count - 1 : value_count - 2;
+
+        if (node->op == TOKEN_SLASH) {
+            gen_division(left_index, right_index);
+            // 商在 rax 里
+            pop_value();
+            pop_value();
+            push_value(REG_RAX);
+            return;
+        }
+
+        const char* left = reg64[value_reg[left_index]];
+        const char* right = reg64[value_reg[right_index]];
+        switch (node->op) {
+            case TOKEN_PLUS:  emit("  add %s, %s\n", left, right); break;
+            case TOKEN_MINUS: emit("  sub %s, %s\n", left, right); break;
+            case TOKEN_STAR:  emit("  imul %s, %s\n", left, right); break; // 有符号乘法
+            case TOKEN_EQ: case TOKEN_NEQ: case TOKEN_LT:
+            case TOKEN_LE: case TOKEN_GT: case TOKEN_GE:
+                emit("  cmp %s, %s\n", left, right);
+                break;
+            default:
+                fprintf(stderr, "Codegen: Unsupported binary operator\n");
+                exit(1);
+        }
+        // 结果在左操作数的寄存器里，替换掉两个操作数
+        int result = value_reg[left_index];
+        pop_value();
+        pop_value();
+        push_value(result);
+    }
+}
+
+static void gen_binary_op(BinaryOpNode* node) {
+    if (node->op == TOKEN_LOGIC_AND || node->op == TOKEN_LOGIC_OR) {
+        gen_logical_op(node);
+        return;
+    }
+    if (node->op == TOKEN_ASSIGN) {
+        gen_assign(node);
+        return;
+    }
+
+    gen_operation(node);
+    if (!is_comparison(node->op)) return;
+
+    // 比较的结果要当值用：根据标志位设置低 8 位，再零扩展成 0 或 1
+    int result = top_reg(0);
+    emit("  set%s %s\n", condition_code(node->op, 0), reg8[result]);
+    emit("  movzx %s, %s\n", reg64[result], reg8[result]);
+}
+
+static void gen_unary_op(UnaryOpNode* node) {
+    switch (node->op) {
+        case TOKEN_AMPERSAND: // 取地址 (&x)：就是 x 的左值
+            gen_lvalue(node->operand);
+            return;
+        case TOKEN_STAR: { // 解引用 (*p)：先算出 p 的值(地址)，再读取该地址的内容
+            gen_expr(node->operand);
+            ensure_top(1);
+            const char* reg = reg64[top_reg(0)];
+            emit("  mov %s, [%s]\n", reg, reg);
+            return;
+        }
+        default:
+            break;
+    }
+
+    gen_expr(node->operand);
+    ensure_top(1);
+    int reg = top_reg(0);
+    switch (node->op) {
+        case TOKEN_MINUS: // 负号 (-x)
+            emit("  neg %s\n", reg64[reg]);
+            break;
+        case TOKEN_BANG:  // 逻辑非 (!x)：0 变成 1，非 0 变成 0
+            emit_test_zero(reg64[reg]);
+            emit("  sete %s\n", reg8[reg]);
+            emit("  movzx %s, %s\n", reg64[reg], reg8[reg]);
+            break;
+        case TOKEN_PLUS:  // 正号 (+x)：什么都不用做
+            break;
+        default:
+            fprintf(stderr, "Codegen Error: Unknown unary operator\n");
+            exit(1);
+    }
+}
+
+// 算出所有实参，放进各自的参数寄存器 (rdi, rsi, ...)。参数以外的活值都溢出到栈上
+static void gen_call_arguments(FunctionCallNode* node) {
+    if (node->arg_count > 6) {
+        fprintf(stderr, "Error: Function call to %s has more than 6 arguments.\n", node->name);
+        exit(1);
+    }
+
+    // 1. 从左到右算出所有参数，都留在值栈上
+    int base = value_count;
+    for (int i = 0; i < node->arg_count; i++) {
+        gen_expr(node->args[i]);
+    }
+
+    // 2. 调用会破坏所有临时寄存器：参数下面的活值全部溢出
+    while (spilled_count < base) spill_oldest();
+
+    // 3. 还在寄存器里的参数一次性搬到各自的参数寄存器；被溢出的参数在栈顶，最后 pop 回来
+    const char* from[6];
+    const char* to[6];
+    int moves = 0;
+    for (int i = 0; i < node->arg_count; i++) {
+        if (value_reg[base + i] != -1) {
+            from[moves] = reg64[value_reg[base + i]];
+            to[moves] = reg64[arg_regs[i]];
+            moves++;
+        }
+    }
+    emit_parallel_move(from, to, moves);
+    for (int i = spilled_count - base - 1; i >= 0; i--) {
+        emit("  pop %s\n", reg64[arg_regs[i]]);
+        spilled_count--;
+    }
+    value_count = base;
+    for (int i = 0; i < NUM_SCRATCH; i++) reg_owner[i] = -1;
+}
+
+static void gen_function_call(FunctionCallNode* node) {
+    gen_call_arguments(node);
+    if (frame_mode == FRAME_RED_ZONE) red_zone_violated = 1; // call 压返回地址，被调函数也会用这块栈
+
+
+    // 4. 调用时 rsp 必须 16 字节对齐：溢出的值个数是奇数时补 8 字节
+    int pad = spilled_count % 2;
+    if (pad) emit("  sub rsp, 8\n");
+
+    // ABI 要求：对于变长参数函数(printf)，al 记录向量寄存器数量
+    // 安全起见，我们在每次函数调用前都清零 rax (xor eax, eax 同时清掉高 32 位)
+    emit("  xor eax, eax\n");
+    emit("  call %s\n", node->name);
+    if (pad) emit("  add rsp, 8\n");
+
+    // 5. 结果在 rax 里
+    push_value(REG_RAX);
+}
+
+// 生成左值（计算变量或指针的内存地址），地址作为一个新值压到值栈上
+static void gen_lvalue(ASTNode* node) {
+    if (node->type == NODE_IDENTIFIER) {
+        IdentifierNode* ident = (IdentifierNode*)node;
+        int reg = alloc_reg();
+
+        // 1. 先在局部符号表找
+        Symbol* sym = find_symbol(ident->name);
+
+        if (sym) {
+            // 找到了 -> 局部变量 (栈地址)
+            // 结果: lea rax, [rbp-8]
+            emit("  lea %s, [%s]\n", reg64[reg], frame_addr(sym->stack_offset));
+        } else {
+            // 没找到 -> 默认为全局变量 (RIP 相对寻址)
+            // 结果: lea rax, [rip + g_val]
+            // 注意：这里直接使用 label，不用判断是否存在，交给汇编器报错（如果拼写错误的话）
+            emit("  lea %s, [rip + %s]\n", reg64[reg], ident->name);
+        }
+        push_value(reg);
+        return;
+    }
+
+    if (node->type == NODE_ARRAY_ACCESS) {
+        // &a[i]：一条 lea 算出 rbp + i*8 - offset
+        ArrayAddress addr = gen_array_address((ArrayAccessNode*)node);
+        int reg;
+        if (addr.has_index) {
+            ensure_top(1);
+            reg = top_reg(0);
+        } else {
+            reg = alloc_reg();
+            push_value(reg);
+        }
+        emit("  lea %s, ", reg64[reg]);
+        emit_array_operand(&addr, reg);
+        emit("\n");
+        return;
+    }
+
+    // 指针解引用 (*p = ...)：地址就是 p 的值
+    if (node->type == NODE_UNARY_OP) {
+        UnaryOpNode* unary = (UnaryOpNode*)node;
+        if (unary->op == TOKEN_STAR) {
+            gen_expr(unary->operand);
+            return;
+        }
+    }
+
+    if (node->type == NODE_MEMBER_ACCESS) {
+        MemberAccessNode* access = (MemberAccessNode*)node;
+
+        // 找结构体变量 p (成员偏移在语法分析时已经查好了)
+        Symbol* sym = find_symbol(access->struct_var_name);
+
+        // 计算地址
+        // Addr = rbp - sym->offset + member_offset
+        // 注意：栈是向下增长的。
+        // 如果 p 在 rbp-16 (size 16)，那么 p 的首地址其实是 rbp-16。
+        // p.x (offset 0) -> rbp-16
+        // p.y (offset 8) -> rbp-16 + 8 = rbp-8
+        int reg = alloc_reg();
+        emit("  lea %s, [%s]\n", reg64[reg], frame_addr(sym->stack_offset - access->member_offset));
+        push_value(reg);
+        return;
+    }
+
+    fprintf(stderr, "Error: Left side of assignment must be a variable or pointer dereference.\n");
+    exit(1);
+}
+
+// 表达式求值的分发器：结果作为一个新值压到值栈上
+static void gen_expr(ASTNode* node) {
+    switch (node->type) {
+        case NODE_NUMERIC_LITERAL:
+            gen_numeric_literal((NumericLiteralNode*)node);
+            break;
+        case NODE_IDENTIFIER:
+            gen_identifier((IdentifierNode*)node);
+            break;
+        case NODE_STRING_LITERAL:
+            gen_string_literal((StringLiteralNode*)node);
+            break;
+        case NODE_BINARY_OP:
+            gen_binary_op((BinaryOpNode*)node);
+            break;
+        case NODE_UNARY_OP:
+            gen_unary_op((UnaryOpNode*)node);
+            break;
+        case NODE_FUNCTION_CALL:
+            gen_function_call((FunctionCallNode*)node);
+            break;
+        case NODE_MEMBER_ACCESS: {
+            // 读取 p.x 的值：地址是常量，直接从栈上读
+            MemberAccessNode* access = (MemberAccessNode*)node;
+            Symbol* sym = find_symbol(access->struct_var_name);
+            int reg = alloc_reg();
+            emit("  mov %s, [%s]\n", reg64[reg], frame_addr(sym->stack_offset - access->member_offset));
+            push_value(reg);
+            break;
+        }
+        case NODE_ARRAY_ACCESS: {
+            // 读取数组的值: x = a[i]：下标直接写进内存操作数，mov rax, [rbp+rax*8-48]
+            ArrayAddress addr = gen_array_address((ArrayAccessNode*)node);
+            int reg;
+            if (addr.has_index) {
+                ensure_top(1);
+                reg = top_reg(0);
+            } else {
+                reg = alloc_reg();
+                push_value(reg);
+            }
+            emit("  mov %s, qword ptr ", reg64[reg]);
+            emit_array_operand(&addr, reg);
+            emit("\n");
+            break;
+        }
+        default:
+            fprintf(stderr, "Codegen Error: Unknown expression node type %d\n", node->type);
+            exit(1);
+    }
+}
+
+// 条件跳转：node 的真假等于 jump_if_true 时跳到 target，否则落到后面的代码。
+// 比较直接生成 cmp + jCC，&& / || 变成跳转链，! 只是把方向反过来，都不物化 0/1。
+// 每次跳转时值栈都回到了进入时的状态，所以跳转目标处寄存器的状态是确定的
+static void gen_branch(ASTNode* node, int jump_if_true, const char* target) {
+    if (node->type == NODE_NUMERIC_LITERAL) {
+        long value = strtol(((NumericLiteralNode*)node)->value, NULL, 10);
+        if ((value != 0) == jump_if_true) emit("  jmp %s\n", target);
+        return;
+    }
+    if (node->type == NODE_UNARY_OP && ((UnaryOpNode*)node)->op == TOKEN_BANG) {
+        gen_branch(((UnaryOpNode*)node)->operand, !jump_if_true, target);
+        return;
+    }
+    if (node->type == NODE_BINARY_OP) {
+        BinaryOpNode* bin = (BinaryOpNode*)node;
+        if (bin->op == TOKEN_LOGIC_AND || bin->op == TOKEN_LOGIC_OR) {
+            // a && b 为假 (a || b 为真) 时，两边任意一个满足就跳；
+            // 反过来的情况要两边都满足才跳，左边不满足时跳过右边
+            int is_and = bin->op == TOKEN_LOGIC_AND;
+            if (jump_if_true != is_and) {
+                gen_branch(bin->left, jump_if_true, target);
+                gen_branch(bin->right, jump_if_true, target);
+            } else {
+                char skip[32];
+                snprintf(skip, sizeof(skip), ".L_skip_%d", label_counter++);
+                gen_branch(bin->left, !jump_if_true, skip);
+                gen_branch(bin->right, jump_if_true, target);
+                emit("%s:\n", skip);
+            }
+            return;
+        }
+        if (is_comparison(bin->op)) {
+            // 变量和常数比较：cmp qword ptr [rbp-8], 10，不用先读进寄存器
+            char operand[64];
+            if (bin->right->type == NODE_NUMERIC_LITERAL &&
+                fits_imm32(strtol(((NumericLiteralNode*)bin->right)->value, NULL, 10)) &&
+                scalar_memory_operand(bin->left, operand, sizeof(operand))) {
+                emit("  cmp %s, %s\n", operand, ((NumericLiteralNode*)bin->right)->value);
+                emit("  j%s %s\n", condition_code(bin->op, !jump_if_true), target);
+                return;
+            }
+            gen_operation(bin);
+            pop_value(); // 左操作数用完了，结果在标志位里 (pop 不改标志位)
+            emit("  j%s %s\n", condition_code(bin->op, !jump_if_true), target);
+            return;
         }
     }
-    return NULL;
-}
-
-// 声明我们将要使用的递归函数
-static void codegen_node(ASTNode* node);
-static void gen_lvalue(ASTNode* node);
 
-// 辅助：重置符号表
-void reset_symbol_table() {
-    symbol_count = 0;
+    int reg = gen_expr_value(node);
+    emit_test_zero(reg64[reg]);
+    emit("  %s %s\n", jump_if_true ? "jne" : "je", target);
 }
 
 // --- AST 节点代码生成函数 ---
 
-// 为 "Program" 节点生成代码
-static void codegen_program(ProgramNode* node) {
+// 汇编文件头和全局变量的 .data 段 (IR 后端也用它)
+void codegen_globals(ProgramNode* node) {
     // 汇编程序的起点
-    printf(".intel_syntax noprefix\n"); // 使用更常见的 Intel 语法（可选，但对初学者更友好）
+    emit(".intel_syntax noprefix\n"); // 使用更常见的 Intel 语法（可选，但对初学者更友好）
 
-    printf(".data\n"); 
+    emit(".data\n"); 
     
     for (int i = 0; i < node->count; i++) {
         ASTNode* child = node->declarations[i];
@@ -80,34 +959,43 @@ static void codegen_program(ProgramNode* node) {
             VarDeclNode* var = (VarDeclNode*)child;
             
             // 生成标签: "g_val:"
-            printf("%s:\n", var->name);
+            emit("%s:\n", var->name);
             
-            // 生成初始值
-            if (var->initial_value != NULL && var->initial_value->type == NODE_NUMERIC_LITERAL) {
+            // 生成初始值 (fold_program 已经把常量表达式折叠成字面量了)
+            if (var->initial_value != NULL) {
+                if (var->initial_value->type != NODE_NUMERIC_LITERAL) {
+                    fprintf(stderr, "Error: initializer of global '%s' is not a constant expression\n", var->name);
+                    exit(1);
+                }
                 // 如果有初始值: .quad 10
                 NumericLiteralNode* val = (NumericLiteralNode*)var->initial_value;
-                printf("  .quad %s\n", val->value);
+                emit("  .quad %s\n", val->value);
             } else {
                 // 如果没有初始值: .quad 0
-                printf("  .quad 0\n");
+                emit("  .quad 0\n");
             }
         }
     }
-    printf("\n");
+    emit("\n");
+}
+
+// 为 "Program" 节点生成代码
+static void codegen_program(ProgramNode* node) {
+    codegen_globals(node);
 
-    printf(".text\n");
-    // printf(".globl _start\n"); // 声明 _start 为全局入口点
-    // printf("_start:\n");
-    // printf("  call main\n");    // 调用主角 main 函数
+    emit(".text\n");
+    // emit(".globl _start\n"); // 声明 _start 为全局入口点
+    // emit("_start:\n");
+    // emit("  call main\n");    // 调用主角 main 函数
 
     // // --- main 返回后，处理退出的逻辑 ---
-    // printf("  mov rdi, rax\n"); // 将 main 的返回值 (在rax) 放入 rdi，作为 exit 的参数
-    // printf("  mov rax, 60\n");  // 将 exit 的系统调用号 (60) 放入 rax
-    // printf("  syscall\n");     // 调用内核，退出程序
-    printf(".globl main\n"); // 声明 main
+    // emit("  mov rdi, rax\n"); // 将 main 的返回值 (在rax) 放入 rdi，作为 exit 的参数
+    // emit("  mov rax, 60\n");  // 将 exit 的系统调用号 (60) 放入 rax
+    // emit("  syscall\n");     // 调用内核，退出程序
+    emit(".globl main\n"); // 声明 main
 
     // --- 分隔线，下面是我们的函数实现 ---
-    printf("\n");
+    emit("\n");
     
     // 遍历并生成函数代码
     for (int i = 0; i < node->count; i++) {
@@ -120,24 +1008,117 @@ static void codegen_program(ProgramNode* node) {
 
     // --- 3. 只读数据段 (.rodata) ---
     // 这里非常关键：这时所有的函数代码都生成完了，字符串池里应该满了
-    printf("\n.section .rodata\n");
-    for (int i = 0; i < string_count; i++) {
-        printf(".LC%d:\n", string_pool[i].id);
-        printf("  .string \"%s\"\n", string_pool[i].content);
+    strpool_emit();
+    strpool_free();
+}
+
+// --- 尾调用 ---
+// return f(...); 的调用结束以后什么都不用做了，所以可以先拆掉自己的栈帧再 jmp 过去，
+// f 的 ret 直接回到我们的调用者：栈不会随递归深度增长，也省掉一对 call/ret。
+// 前提是栈帧里的东西不会再被用到：函数里取过地址 (&x)、有数组或结构体时不做。
+
+// 函数体里有没有可能把栈帧里的地址交出去
+static int frame_may_escape(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) {
+                if (frame_may_escape(block->statements[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_VAR_DECL: {
+            VarDeclNode* var = (VarDeclNode*)node;
+            return var->array_size > 0 || var->var_type == TYPE_STRUCT || frame_may_escape(var->initial_value);
+        }
+        case NODE_RETURN_STATEMENT:
+            return frame_may_escape(((ReturnStatementNode*)node)->argument);
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            return frame_may_escape(stmt->condition) || frame_may_escape(stmt->body) ||
+                   frame_may_escape(stmt->else_branch);
+        }
+        case NODE_WHILE_STATEMENT:
+            return frame_may_escape(((WhileStatementNode*)node)->condition) ||
+                   frame_may_escape(((WhileStatementNode*)node)->body);
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            return frame_may_escape(stmt->init) || frame_may_escape(stmt->condition) ||
+                   frame_may_escape(stmt->increment) || frame_may_escape(stmt->body);
+        }
+        case NODE_BINARY_OP:
+            return frame_may_escape(((BinaryOpNode*)node)->left) || frame_may_escape(((BinaryOpNode*)node)->right);
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            return unary->op == TOKEN_AMPERSAND || frame_may_escape(unary->operand);
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            for (int i = 0; i < call->arg_count; i++) {
+                if (frame_may_escape(call->args[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_ARRAY_ACCESS:
+            return frame_may_escape(((ArrayAccessNode*)node)->index);
+        default:
+            return 0;
     }
 }
 
-// 为 "Function Declaration" 节点生成代码
-static void codegen_function_declaration(FunctionDeclarationNode* node) {
-    reset_symbol_table();
+static int is_self_call(ASTNode* node) {
+    if (node == NULL || node->type != NODE_FUNCTION_CALL) return 0;
+    FunctionCallNode* call = (FunctionCallNode*)node;
+    return call->name == current_function->name && call->arg_count == current_function->arg_count;
+}
+
+static int has_self_tail_call(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_RETURN_STATEMENT:
+            return is_self_call(((ReturnStatementNode*)node)->argument);
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) {
+                if (has_self_tail_call(block->statements[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_IF_STATEMENT:
+            return has_self_tail_call(((IfStatementNode*)node)->body) ||
+                   has_self_tail_call(((IfStatementNode*)node)->else_branch);
+        case NODE_WHILE_STATEMENT:
+            return has_self_tail_call(((WhileStatementNode*)node)->body);
+        case NODE_FOR_STATEMENT:
+            return has_self_tail_call(((ForStatementNode*)node)->body);
+        default:
+            return 0;
+    }
+}
+
+// return call; 实参进参数寄存器以后：调用自己就跳回函数开头，否则拆掉栈帧 jmp 过去
+static void gen_tail_call(FunctionCallNode* call) {
+    gen_call_arguments(call);
+    if (tail_label != -1 && is_self_call((ASTNode*)call)) {
+        emit("  jmp .L_tail_%d\n", tail_label);
+        return;
+    }
+    emit_frame_teardown();
+    emit("  xor eax, eax\n"); // 和普通调用一样，变长参数函数需要 al = 0
+    emit("  jmp %s\n", call->name);
+}
+
+// 按 frame_mode 生成整个函数。红区模式下中途生成了 call 或 push 时返回 0，这次生成的代码作废
+static int gen_function(FunctionDeclarationNode* node) {
+    symtab_reset();
+    reset_registers();
+    red_zone_violated = 0;
+    symtab_push_scope(); // 参数所在的作用域
     // 声明一个全局可链接的函数标签
-    // printf(".globl %s\n", node->name);
+    // emit(".globl %s\n", node->name);
     // 函数不再需要是 .globl，因为只有 _start 是外部可见的
-    printf("%s:\n", node->name);    // 定义函数标签
-
-    // --- 函数序言 (Prologue) ---
-    printf("  push rbp\n");
-    printf("  mov rbp, rsp\n");
+    emit("%s:\n", node->name);    // 定义函数标签
 
     // --- 1. 计算栈空间 ---
     // 包含参数(node->args) 和 函数体内的变量(node->body中的VarDecl)
@@ -154,256 +1135,138 @@ static void codegen_function_declaration(FunctionDeclarationNode* node) {
         
         // 分配栈位置
         current_stack_offset += 8;
-        symbol_table[symbol_count].name = param->name;
-        symbol_table[symbol_count].stack_offset = current_stack_offset;
-        symbol_count++;
+        Symbol* sym = symtab_declare(param->name);
+        sym->stack_offset = current_stack_offset;
+        sym->type = param->var_type;
     }
 
-    // 1.2 再处理函数体内的局部变量
-    scan_locals((ASTNode*)node->body, &current_stack_offset);
+    // 1.2 再处理函数体内的局部变量 (只分配栈位置，登记到符号表要等走到声明处)
+    FrameUsage usage = {current_stack_offset, current_stack_offset};
+    scan_locals((ASTNode*)node->body, current_stack_offset, &usage);
+    current_stack_offset = usage.size;
+    locals_unshared = usage.unshared;
+    locals_size = usage.size;
 
-    // 1.3 分配栈空间 (16字节对齐)
+    // 1.3 函数序言 (Prologue)，分配栈空间：调用时 rsp 要 16 字节对齐
+    //     (入口处 rsp ≡ 8 mod 16，push rbp 以后正好对齐，不 push 就要多减 8)
+    if (frame_mode == FRAME_RED_ZONE && current_stack_offset > 128) frame_mode = FRAME_RSP;
     int stack_size = (current_stack_offset + 15) / 16 * 16;
-    if (stack_size > 0) printf("  sub rsp, %d\n", stack_size);
+    if (frame_mode == FRAME_RBP) {
+        emit("  push rbp\n");
+        emit("  mov rbp, rsp\n");
+        frame_size = stack_size;
+    } else {
+        frame_size = frame_mode == FRAME_RSP ? stack_size + 8 : 0;
+    }
+    if (frame_size > 0) emit("  sub rsp, %d\n", frame_size);
+
+    // 自递归的尾调用把新的实参放进参数寄存器以后跳回这里，重新存进参数的栈位置，变成循环
+    current_function = node;
+    frame_escapes = frame_may_escape((ASTNode*)node->body);
+    tail_label = -1;
+    if (!frame_escapes && has_self_tail_call((ASTNode*)node->body)) {
+        tail_label = label_counter++;
+        emit(".L_tail_%d:\n", tail_label);
+    }
 
     // --- 2. 将寄存器中的参数值，搬运到栈里 ---
-    // 因为参数是局部变量，代码中会通过 [rbp-N] 访问它们。
+    // 因为参数是局部变量，代码中会通过 [rbp-N] (或 rsp 相对的地址) 访问它们。
     // 但值现在在 rdi, rsi... 里，所以要搬进去。
     for (int i = 0; i < node->arg_count; i++) {
         VarDeclNode* param = (VarDeclNode*)node->args[i];
         // 查找它在栈里的位置
         Symbol* sym = find_symbol(param->name); 
         // 生成: mov [rbp-8], rdi
-        printf("  mov [rbp-%d], %s\n", sym->stack_offset, arg_regs[i]);
+        emit("  mov [%s], %s\n", frame_addr(sym->stack_offset), arg_regs[i]);
     }
 
     // --- 3. 生成函数体代码 ---
     codegen_node((ASTNode*)node->body);
+    symtab_pop_scope();
+    return !red_zone_violated;
+}
+
+// 为 "Function Declaration" 节点生成代码
+// 省略帧指针时先假定是叶子函数、用红区；不是的话回退到函数开头，按 sub rsp 的栈帧重新生成
+static void codegen_function_declaration(FunctionDeclarationNode* node) {
+    size_t start = emit_length();
+    frame_mode = omit_frame_pointer ? FRAME_RED_ZONE : FRAME_RBP;
+    if (!gen_function(node)) {
+        emit_truncate(start);
+        frame_mode = FRAME_RSP;
+        gen_function(node);
+    }
+    if (frame_report) {
+        // 栈帧：返回地址以下这个函数用到的字节数 (红区里的也算)
+        int frame = frame_mode == FRAME_RBP ? 8 + frame_size : frame_mode == FRAME_RSP ? frame_size : locals_size;
+        print_frame_report(node->name, locals_unshared, locals_size, frame);
+    }
 }
 
 // 为 "Variable Declaration" 节点生成代码
 static void codegen_variable_declaration(VarDeclNode* node) {
-    // 1. 计算右值 (rax)
-    codegen_node(node->initial_value);
+    // 1. 计算右值 (放在某个临时寄存器里)。没有初始值就什么都不用写；
+    //    int 变量的初始值是 32 位立即数时直接 mov qword ptr [rbp-N], imm
+    int value = -1;
+    long constant = 0;
+    int store_constant = node->initial_value && node->initial_value->type == NODE_NUMERIC_LITERAL &&
+                         node->var_type == TYPE_INT && node->array_size == 0;
+    if (store_constant) {
+        constant = strtol(((NumericLiteralNode*)node->initial_value)->value, NULL, 10);
+        store_constant = fits_imm32(constant);
+    }
+    if (node->initial_value && !store_constant) {
+        value = gen_expr_value(node->initial_value);
+    }
 
-    // 2. 找符号
-    Symbol* symbol = find_symbol(node->name);
-    // Error checking...
+    // 2. 在当前作用域登记这个变量 (它会遮蔽外层的同名变量)
+    Symbol* symbol = symtab_declare(node->name);
+    symbol->stack_offset = node->stack_offset;
+    symbol->type = node->var_type;
+    symbol->struct_name = node->struct_name;
 
     // 3. 根据类型存储
+    if (store_constant) {
+        emit("  mov qword ptr [%s], %ld\n", frame_addr(symbol->stack_offset), constant);
+        return;
+    }
+    if (value == -1) return;
     if (symbol->type == TYPE_CHAR) {
-        // [新增] 存 1 字节
-        printf("  mov byte ptr [rbp-%d], al\n", symbol->stack_offset);
+        // 存 1 字节
+        emit("  mov byte ptr [%s], %s\n", frame_addr(symbol->stack_offset), reg8[value]);
     } else {
-        // [原有] 存 8 字节
-        printf("  mov [rbp-%d], rax\n", symbol->stack_offset);
+        // 存 8 字节
+        emit("  mov [%s], %s\n", frame_addr(symbol->stack_offset), reg64[value]);
     }
 }
     
 
-// 为 "Identifier" (变量使用) 节点生成代码
-static void codegen_identifier(IdentifierNode* node) {
-    Symbol* symbol = find_symbol(node->name);
-    
-    if (symbol) {
-        if (symbol->type == TYPE_CHAR) {
-            // [新增] 读 1 字节并零扩展
-            printf("  movzx rax, byte ptr [rbp-%d]\n", symbol->stack_offset);
-        } else {
-            // [原有] 读 8 字节
-            printf("  mov rax, [rbp-%d]\n", symbol->stack_offset);
-        }
-    } else {
-        // 全局变量处理... 暂时假设全局只有 int，或者你也得给全局变量表加类型
-        printf("  mov rax, [rip + %s]\n", node->name);
-    }
-}
-
 // 为 "Block Statement" 节点生成代码
 static void codegen_block_statement(BlockStatementNode* node) {
     // 依次为代码块中的每个语句生成代码
+    symtab_push_scope();
     for (int i = 0; i < node->count; i++) {
         codegen_node(node->statements[i]);
     }
+    symtab_pop_scope();
 }
 
 // 为 "Return Statement" 节点生成代码
 static void codegen_return_statement(ReturnStatementNode* node) {
-    // 1. 为要返回的表达式生成代码，执行后，结果会在 eax 中。
-    codegen_node(node->argument);
-
-    // 2. 生成函数尾声 (Epilogue) 和返回指令。
-    //    注意：这里我们简单地用 mov rsp, rbp 来恢复栈指针，
-    //    这在没有动态栈分配（如alloca）的情况下是安全的。
-    printf("  mov rsp, rbp\n");
-    printf("  pop rbp\n");
-    printf("  ret\n");
-}
-
-// 为 "Numeric Literal" 节点生成代码
-static void codegen_numeric_literal(NumericLiteralNode* node) {
-    // TODO (2/2): 为数字字面量生成代码
-
-    // 思考一下：当 codegen_return_statement 调用我们时，我们的任务是什么？
-    // 任务是把这个数字的值放入返回值寄存器 %eax 中。
-    // 使用 movl 指令来完成这个任务。
-    // 提示：node->value 是一个字符串，所以你需要使用 %s 来打印它。
-    printf("  mov rax, %s\n", node->value);
-}
-
-// 为 "Binary Operation" 节点生成代码
-static void codegen_binary_op(BinaryOpNode* node) {
-    // --- 特殊处理逻辑与 (&&) ---
-    if (node->op == TOKEN_LOGIC_AND) {
-        int label_id = label_counter++; // 申请一个唯一ID
-        
-        // 1. 计算左边
-        codegen_node(node->left);
-        // 结果在 rax。如果 rax == 0 (False)，直接跳到 End，并且结果就是 0
-        printf("  cmp rax, 0\n");
-        printf("  je .L_false_%d\n", label_id); // 短路跳转
-        
-        // 2. 如果左边是 True，才计算右边
-        codegen_node(node->right);
-        printf("  cmp rax, 0\n");
-        printf("  je .L_false_%d\n", label_id);
-        
-        // 3. 如果两边都不跳，说明都是 True
-        printf("  mov rax, 1\n");
-        printf("  jmp .L_end_%d\n", label_id);
-        
-        // 4. False 标签
-        printf(".L_false_%d:\n", label_id);
-        printf("  mov rax, 0\n");
-        
-        // 5. End 标签
-        printf(".L_end_%d:\n", label_id);
-        return; // 处理完毕，直接返回
-    }
-
-    // --- 特殊处理逻辑或 (||) ---
-    if (node->op == TOKEN_LOGIC_OR) {
-        int label_id = label_counter++;
-        
-        // 1. 计算左边
-        codegen_node(node->left);
-        // 如果 rax != 0 (True)，直接跳到 True，结果就是 1
-        printf("  cmp rax, 0\n");
-        printf("  jne .L_true_%d\n", label_id); // 短路跳转
-        
-        // 2. 如果左边是 False，才计算右边
-        codegen_node(node->right);
-        printf("  cmp rax, 0\n");
-        printf("  jne .L_true_%d\n", label_id);
-        
-        // 3. 如果两边都没跳，说明都是 False
-        printf("  mov rax, 0\n");
-        printf("  jmp .L_end_%d\n", label_id);
-        
-        // 4. True 标签
-        printf(".L_true_%d:\n", label_id);
-        printf("  mov rax, 1\n");
-        
-        // 5. End 标签
-        printf(".L_end_%d:\n", label_id);
-        return;
-    }
-
-    if (node->op == TOKEN_ASSIGN) {
-        // 1. 生成右值 (value) -> rax
-        codegen_node(node->right);
-        printf("  push rax\n");
-
-        // 2. 生成左值 (address) -> rax
-        gen_lvalue(node->left); 
-        printf("  pop rdi\n"); // rdi = value, rax = address
-
-        // 3. 检查左值的类型
-        // 这里我们需要知道 node->left 是什么类型。
-        // 如果它是 IDENTIFIER，我们可以查符号表。
-        if (node->left->type == NODE_IDENTIFIER) {
-            IdentifierNode* ident = (IdentifierNode*)node->left;
-            Symbol* sym = find_symbol(ident->name);
-            if (sym && sym->type == TYPE_CHAR) {
-                // char 类型赋值：只写 1 字节
-                printf("  mov [rax], dil\n"); // dil 是 rdi 的低8位
-                return;
-            }
-        }
-        
-        // 默认 int 赋值
-        printf("  mov [rax], rdi\n");
+    // 返回值直接就是一个调用的结果：尾调用
+    if (node->argument->type == NODE_FUNCTION_CALL && !frame_escapes) {
+        gen_tail_call((FunctionCallNode*)node->argument);
         return;
     }
 
-    // 1. 生成右子树的代码 (计算 B)
-    codegen_node(node->right);
-    //    现在 B 的结果在 eax 中
-
-    // 2. 将 B 的结果压入栈中保存
-    printf("  push rax\n");
+    // 1. 为要返回的表达式生成代码，返回值要放在 rax 中。
+    int value = gen_expr_value(node->argument);
+    if (value != REG_RAX) emit("  mov rax, %s\n", reg64[value]);
 
-    // 3. 生成左子树的代码 (计算 A)
-    codegen_node(node->left);
-    //    现在 A 的结果在 eax 中
-
-    // 4. 将 B 的结果从栈中弹出到 rdi
-    printf("  pop rdi\n");
-
-    // 5. 根据操作符，生成对应的汇编指令
-    switch (node->op) {
-        case TOKEN_PLUS:
-            printf("  add rax, rdi\n");
-            break;
-        case TOKEN_MINUS:
-            printf("  sub rax, rdi\n");
-            break;
-        case TOKEN_STAR:
-            printf("  imul rax, rdi\n"); // 有符号乘法: rax = rax * rdi
-            break;
-        case TOKEN_SLASH:
-            // 除法比较特殊：
-            // 被除数在 rax 中 (来自 pop rdi 前的计算结果, 但这里 rax 是左操作数, rdi 是右操作数? 等等)
-            
-            // 让我们理一下栈：
-            // 1. 右操作数 B 计算完 -> push
-            // 2. 左操作数 A 计算完 -> 在 rax 中
-            // 3. pop rdi -> B 在 rdi 中
-            // 此时：rax = A (被除数), rdi = B (除数)
-
-            // idiv 指令是用 rdx:rax (128位) 除以操作数。
-            // 我们只有 64 位的 rax，所以需要把 rax 的符号位扩展到 rdx 中。
-            // cqo 指令就是做这个的 (Convert Quad-word to Oct-word)。
-            printf("  cqo\n"); 
-            printf("  idiv rdi\n"); // rax = rdx:rax / rdi
-            break;
-        case TOKEN_EQ:
-        case TOKEN_NEQ:
-        case TOKEN_LT:
-        case TOKEN_LE:
-        case TOKEN_GT:
-        case TOKEN_GE:
-            printf("  cmp rax, rdi\n"); // 比较 rax 和 rdi
-            
-            // 根据不同的操作符，设置 al 寄存器 (rax 的低8位)
-            switch (node->op) {
-                case TOKEN_EQ:  printf("  sete al\n"); break;  // Equal
-                case TOKEN_NEQ: printf("  setne al\n"); break; // Not Equal
-                case TOKEN_LT:  printf("  setl al\n"); break;  // Less
-                case TOKEN_LE:  printf("  setle al\n"); break; // Less or Equal
-                case TOKEN_GT:  printf("  setg al\n"); break;  // Greater
-                case TOKEN_GE:  printf("  setge al\n"); break; // Greater or Equal
-                default: break;
-            }
-
-            // 关键一步：将 8 位的 al 零扩展为 64 位的 rax
-            // 这样 rax 的值就变成了真正的 0 或 1
-            printf("  movzb rax, al\n");
-            break;
-        default:
-            fprintf(stderr, "Codegen: Unsupported binary operator\n");
-            exit(1);
-    }
+    // 2. 生成函数尾声 (Epilogue) 和返回指令。
+    //    没有动态栈分配 (如 alloca)，sub 掉多少就 add 回来多少 (或者 mov rsp, rbp)。
+    emit_frame_teardown();
+    emit("  ret\n");
 }
 
 // 为 "If Statement" 节点生成代码
@@ -411,24 +1274,19 @@ static void codegen_if_statement(IfStatementNode* node) {
     // 1. 为我们这个 if 语句创建一个唯一的标签 ID
     int label_id = label_counter++;
     
-    // 2. 为条件表达式生成代码
-    codegen_node(node->condition); // 执行后，比较结果会在 CPU 状态标志中
-
-    // 3. 生成条件跳转指令
-    //    我们生成的 BinaryOpNode (x > 2) 会比较 eax 和 edi
-    //    如果 x > 2 为假 (即 x <= 2)，我们就应该跳过 if 的 body
-    //    所以我们用 jle (Jump if Less or Equal)
-    printf("  cmp rax, 0\n");
-    printf("  je  _L_else_%d\n", label_id); // 如果是 0 (Equal)，跳转到 else
+    // 2. 条件为假时跳到 else (比较直接 cmp + jCC，不先算出 0/1)
+    char else_label[32];
+    snprintf(else_label, sizeof(else_label), "_L_else_%d", label_id);
+    gen_branch(node->condition, 0, else_label);
 
     // 4. 生成 if 为真时的代码
     codegen_node(node->body);
 
     // 如果执行完了 if 块，必须强制跳转到结束标签，跳过 else 块
-    printf("  jmp  _L_end_%d\n", label_id);
+    emit("  jmp  _L_end_%d\n", label_id);
 
     // 5. 生成 else 标签
-    printf("_L_else_%d:\n", label_id);
+    emit("_L_else_%d:\n", label_id);
 
     // 6. 如果存在 else 分支，生成它的代码
     if (node->else_branch != NULL) {
@@ -436,7 +1294,36 @@ static void codegen_if_statement(IfStatementNode* node) {
     }
 
     // 生成结束标签
-    printf("_L_end_%d:\n", label_id);
+    emit("_L_end_%d:\n", label_id);
+}
+
+// 循环都生成成 "有保护的 do-while" (loop rotation)，每轮只有一条向后的条件跳转：
+//       条件为假 -> .L_end_N     入口只测一次
+//   .L_start_N:                  循环头按 16 字节对齐
+//       循环体
+//   .L_inc_N:                    continue 跳到这里
+//       增量 (for)
+//       条件为真 -> .L_start_N
+//   .L_end_N:
+static void gen_loop_entry(ASTNode* condition, int label_id) {
+    if (condition) {
+        char end_label[32];
+        snprintf(end_label, sizeof(end_label), ".L_end_%d", label_id);
+        gen_branch(condition, 0, end_label);
+    }
+    emit("  .p2align 4\n");
+    emit(".L_start_%d:\n", label_id);
+}
+
+static void gen_loop_latch(ASTNode* condition, int label_id) {
+    char start_label[32];
+    snprintf(start_label, sizeof(start_label), ".L_start_%d", label_id);
+    if (condition) {
+        gen_branch(condition, 1, start_label); // 条件在循环尾部再算一遍
+    } else {
+        emit("  jmp %s\n", start_label);
+    }
+    emit(".L_end_%d:\n", label_id);
 }
 
 // 为 "while Statement" 节点生成代码
@@ -445,195 +1332,25 @@ static void codegen_while_statement(WhileStatementNode* node) {
     
     // 保存旧状态
     int old_id = current_loop_id;
-    int old_type = current_loop_type;
     
     // 设置新状态
     current_loop_id = label_id;
-    current_loop_type = 1; // While
     
-    printf(".L_start_%d:\n", label_id);
-    // ... 条件 ...
-    codegen_node(node->condition);
-    printf("  cmp rax, 0\n");
-    printf("  je .L_end_%d\n", label_id);
+    gen_loop_entry(node->condition, label_id);
 
     // ... 循环体 (内部可能遇到 break/continue) ...
     codegen_node(node->body);
 
-    printf("  jmp .L_start_%d\n", label_id);
-    printf(".L_end_%d:\n", label_id);
+    emit(".L_inc_%d:\n", label_id);
+    gen_loop_latch(node->condition, label_id);
     
     // 恢复旧状态
     current_loop_id = old_id;
-    current_loop_type = old_type;
-}
-
-// 处理一元节点的函数，并在分发器中注册
-static void codegen_unary_op(UnaryOpNode* node) {
-    // 1. 先计算操作数的值，结果会在 rax 中
-    codegen_node(node->operand);
-
-    // 2. 根据操作符处理 rax
-    switch (node->op) {
-        case TOKEN_AMPERSAND: // 取地址 (&x)
-            // &x 的值，就是 x 的 L-value (地址)
-            gen_lvalue(node->operand);
-            // 此时 rax 已经是地址了，直接返回
-            break;
-        case TOKEN_STAR: // 解引用 (*p)
-            // *p 的值，就是先算出 p 的值(地址)，再读取该地址的内容
-            codegen_node(node->operand); // 计算 p，rax = 地址
-            printf("  mov rax, [rax]\n"); // 读取地址里的值
-            break;
-        case TOKEN_MINUS: // 负号 (-x)
-            printf("  neg rax\n"); // rax = -rax
-            break;
-        case TOKEN_BANG:  // 逻辑非 (!x)
-            // 逻辑是：如果 rax 是 0，变成 1；如果是非 0，变成 0。
-            printf("  cmp rax, 0\n");
-            printf("  sete al\n");      // 如果相等(是0)，al=1
-            printf("  movzb rax, al\n");// 扩展到 64 位
-            break;
-        case TOKEN_PLUS:  // 正号 (+x)
-            // 什么都不用做，值不变
-            break;
-        default:
-            fprintf(stderr, "Codegen Error: Unknown unary operator\n");
-            exit(1);
-    }
-}
-
-static void codegen_function_call(FunctionCallNode* node) {
-    // 寄存器列表
-    char* arg_regs[] = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"};
-
-    // 1. 计算所有参数的值，并压栈保存
-    // 为什么要压栈？因为计算第2个参数时，可能会覆盖第1个参数用到的寄存器。
-    // 最安全的做法是：算出结果 -> push -> 算出下一个 -> push ... -> 最后 pop 到指定寄存器
-    
-    for (int i = 0; i < node->arg_count; i++) {
-        codegen_node(node->args[i]); // 结果在 rax
-        printf("  push rax\n");
-    }
-
-    // 2. 将参数弹出到对应的寄存器
-    // 注意：栈是后进先出 (LIFO)。
-    // 如果我们要赋给 rdi (第1个), rsi (第2个)...
-    // 我们 push 的顺序是 arg1, arg2...
-    // 栈顶是 argN。
-    // 所以 pop 的顺序必须是反的：先 pop 给最后一个参数，最后 pop 给 rdi。
-    
-    for (int i = node->arg_count - 1; i >= 0; i--) {
-        printf("  pop %s\n", arg_regs[i]);
-    }
-
-    // [新增] ABI 要求：对于变长参数函数(printf)，al 记录向量寄存器数量
-    // 安全起见，我们在每次函数调用前都清零 rax (或者只清零 al)
-    printf("  mov rax, 0\n"); 
-
-    // 3. 调用函数
-    printf("  call %s\n", node->name);
-    
-    // 4. 结果已经在 rax 里了，完美。
-}
-
-// 生成左值（计算变量或指针的内存地址）
-// 执行完后，rax 中存放的是一个内存地址
-// 生成左值（计算变量或指针的内存地址）
-static void gen_lvalue(ASTNode* node) {
-    if (node->type == NODE_IDENTIFIER) {
-        IdentifierNode* ident = (IdentifierNode*)node;
-        
-        // 1. 先在局部符号表找
-        Symbol* sym = find_symbol(ident->name);
-        
-        if (sym) {
-            // [原有逻辑] 找到了 -> 局部变量 (栈地址)
-            // 结果: lea rax, [rbp-8]
-            printf("  lea rax, [rbp-%d]\n", sym->stack_offset);
-        } else {
-            // [新增逻辑] 没找到 -> 默认为全局变量 (RIP 相对寻址)
-            // 结果: lea rax, [rip + g_val]
-            // 注意：这里直接使用 label，不用判断是否存在，交给汇编器报错（如果拼写错误的话）
-            printf("  lea rax, [rip + %s]\n", ident->name);
-        }
-        return;
-    }
-
-    if (node->type == NODE_ARRAY_ACCESS) {
-        ArrayAccessNode* access = (ArrayAccessNode*)node;
-        Symbol* sym = find_symbol(access->array_name);
-        if (!sym) { fprintf(stderr, "Undefined array %s\n", access->array_name); exit(1); }
-
-        // 1. 计算索引值，结果在 rax
-        codegen_node(access->index);
-
-        // 2. 计算内存地址
-        // 公式: address = rbp - sym->offset + (index * 8)
-        
-        printf("  mov rbx, rax\n");       // rbx = index
-        printf("  imul rbx, 8\n");        // rbx = index * 8
-        printf("  mov rax, rbp\n");       // rax = rbp
-        printf("  sub rax, %d\n", sym->stack_offset); // rax = rbp - offset (即 a[0])
-        printf("  add rax, rbx\n");       // rax = a[0] + index*8
-        
-        return; // rax 现在是地址
-    }
-    
-    // ... 下面处理指针解引用 (*p = ...) 的逻辑保持不变 ...
-    if (node->type == NODE_UNARY_OP) {
-        UnaryOpNode* unary = (UnaryOpNode*)node;
-        if (unary->op == TOKEN_STAR) {
-            codegen_node(unary->operand);
-            return;
-        }
-    }
-
-    if (node->type == NODE_MEMBER_ACCESS) {
-        MemberAccessNode* access = (MemberAccessNode*)node;
-        
-        // 1. 找结构体变量 p
-        Symbol* sym = find_symbol(access->struct_var_name);
-        if (!sym) { /* Error */ }
-        
-        // 2. 找结构体定义 Point
-        StructDef* sdef = find_struct(sym->struct_name);
-        if (!sdef) { /* Error */ }
-        
-        // 3. 找成员 x
-        MemberInfo* mem = find_struct_member(sdef, access->member_name);
-        if (!mem) { /* Error */ }
-        
-        // 4. 计算地址
-        // Addr = rbp - sym->offset + mem->offset
-        // 注意：栈是向下增长的。
-        // 如果 p 在 rbp-16 (size 16)，那么 p 的首地址其实是 rbp-16。
-        // p.x (offset 0) -> rbp-16
-        // p.y (offset 8) -> rbp-16 + 8 = rbp-8
-        
-        printf("  mov rax, rbp\n");
-        printf("  sub rax, %d\n", sym->stack_offset); // Base address
-        printf("  add rax, %d\n", mem->offset);       // Member offset
-        
-        return; // rax 是地址
-    }
-
-    fprintf(stderr, "Error: Left side of assignment must be a variable or pointer dereference.\n");
-    exit(1);
-}
-
-static void codegen_string_literal(StringLiteralNode* node) {
-    // 1. 把它注册到全局池子，拿到一个唯一的 ID (例如 0)
-    int id = add_string_to_pool(node->value);
-    
-    // 2. 生成获取地址的指令
-    // 我们约定 .LC0, .LC1 作为字符串的标签
-    printf("  lea rax, [rip + .LC%d]\n", id);
 }
 
 // 递归扫描 AST，查找所有的变量声明 (包括嵌套在 for/if/while 里的)
-static void scan_locals(ASTNode* node, int* current_stack_offset) {
-    if (node == NULL) return;
+static int scan_locals(ASTNode* node, int offset, FrameUsage* usage) {
+    if (node == NULL) return offset;
 
     switch (node->type) {
         case NODE_VAR_DECL: {
@@ -643,44 +1360,42 @@ static void scan_locals(ASTNode* node, int* current_stack_offset) {
             if (var->array_size > 0) {
                 size = var->array_size * 8;
             }
-            *current_stack_offset += size;
-            
-            // 注册到符号表
-            symbol_table[symbol_count].name = var->name;
-            symbol_table[symbol_count].stack_offset = *current_stack_offset;
-            symbol_table[symbol_count].type = var->var_type;
-            symbol_table[symbol_count].struct_name = var->struct_name;
-            symbol_count++;
-            break;
+            offset += size;
+            usage->unshared += size;
+            if (offset > usage->size) usage->size = offset;
+
+            // 记录在声明节点上，代码生成走到这里时再登记到符号表
+            var->stack_offset = offset;
+            return offset;
         }
         case NODE_BLOCK_STATEMENT: {
+            // 块里的变量活到块结束，之后这段栈空间留给后面的语句
             BlockStatementNode* block = (BlockStatementNode*)node;
+            int inner = offset;
             for (int i = 0; i < block->count; i++) {
-                scan_locals(block->statements[i], current_stack_offset);
+                inner = scan_locals(block->statements[i], inner, usage);
             }
-            break;
+            return offset;
         }
         case NODE_IF_STATEMENT: {
+            // 两边是块时都从 offset 开始，共用同一段；不是块的声明留在外层作用域里，位置就一直占着
             IfStatementNode* stmt = (IfStatementNode*)node;
-            scan_locals(stmt->body, current_stack_offset);
-            scan_locals(stmt->else_branch, current_stack_offset);
-            break;
-        }
-        case NODE_WHILE_STATEMENT: {
-            WhileStatementNode* stmt = (WhileStatementNode*)node;
-            scan_locals(stmt->body, current_stack_offset);
-            break;
+            int end = scan_locals(stmt->body, offset, usage);
+            return scan_locals(stmt->else_branch, end, usage);
         }
-        case NODE_FOR_STATEMENT: { // <--- 关键！钻进 For 循环
+        case NODE_WHILE_STATEMENT:
+            return scan_locals(((WhileStatementNode*)node)->body, offset, usage);
+        case NODE_FOR_STATEMENT: {
+            // init 里的 int i=0 和循环体都在 for 自己的作用域里
             ForStatementNode* stmt = (ForStatementNode*)node;
-            scan_locals(stmt->init, current_stack_offset); // 扫描 int i=0
-            scan_locals(stmt->body, current_stack_offset); // 扫描循环体
+            int inner = scan_locals(stmt->init, offset, usage);
+            scan_locals(stmt->body, inner, usage);
             // cond 和 inc 通常不包含变量声明，可以不扫
-            break;
+            return offset;
         }
         default:
             // 其他节点（如表达式）通常不包含变量声明，跳过
-            break;
+            return offset;
     }
 }
 
@@ -688,33 +1403,27 @@ static void codegen_for_statement(ForStatementNode* node) {
     int label_id = label_counter++;
     
     int old_id = current_loop_id;
-    int old_type = current_loop_type;
     
     current_loop_id = label_id;
-    current_loop_type = 2; // For
-    
+
+    // for 的 init 里声明的变量 (int i = 0) 只在整个 for 语句内可见
+    symtab_push_scope();
     if (node->init) codegen_node(node->init);
 
-    printf(".L_start_%d:\n", label_id);
-    if (node->condition) {
-        codegen_node(node->condition);
-        printf("  cmp rax, 0\n");
-        printf("  je .L_end_%d\n", label_id);
-    }
+    gen_loop_entry(node->condition, label_id);
 
     codegen_node(node->body);
 
-    // 关键：For 循环需要一个专门的 increment 标签供 continue 跳转
-    printf(".L_inc_%d:\n", label_id); // <--- 新增这个标签
+    // continue 跳到 increment
+    emit(".L_inc_%d:\n", label_id);
     if (node->increment) {
         codegen_node(node->increment);
     }
-    printf("  jmp .L_start_%d\n", label_id);
+    gen_loop_latch(node->condition, label_id);
 
-    printf(".L_end_%d:\n", label_id);
+    symtab_pop_scope();
     
     current_loop_id = old_id;
-    current_loop_type = old_type;
 }
 
 static void codegen_break(ASTNode* node) {
@@ -723,7 +1432,7 @@ static void codegen_break(ASTNode* node) {
         exit(1);
     }
     // 无论是 while 还是 for，break 都是去 .L_end_ID
-    printf("  jmp .L_end_%d\n", current_loop_id);
+    emit("  jmp .L_end_%d\n", current_loop_id);
 }
 
 static void codegen_continue(ASTNode* node) {
@@ -731,14 +1440,8 @@ static void codegen_continue(ASTNode* node) {
         fprintf(stderr, "Error: 'continue' outside of loop.\n");
         exit(1);
     }
-    
-    if (current_loop_type == 1) {
-        // While: 跳回 start
-        printf("  jmp .L_start_%d\n", current_loop_id);
-    } else if (current_loop_type == 2) {
-        // For: 跳回 increment
-        printf("  jmp .L_inc_%d\n", current_loop_id);
-    }
+    // while 和 for 都跳到循环尾部的 .L_inc_ID (for 先做 increment，然后重新测条件)
+    emit("  jmp .L_inc_%d\n", current_loop_id);
 }
 
 /**
@@ -763,41 +1466,15 @@ static void codegen_node(ASTNode* node) {
         case NODE_RETURN_STATEMENT:
             codegen_return_statement((ReturnStatementNode*)node);
             break;
-        case NODE_NUMERIC_LITERAL:
-            codegen_numeric_literal((NumericLiteralNode*)node);
-            break;
         case NODE_VAR_DECL:
             codegen_variable_declaration((VarDeclNode*)node);
             break;
-        case NODE_IDENTIFIER:
-            codegen_identifier((IdentifierNode*)node);
-            break;
-        case NODE_BINARY_OP:
-            codegen_binary_op((BinaryOpNode*)node);
-            break;
         case NODE_IF_STATEMENT:
             codegen_if_statement((IfStatementNode*)node);
             break;
         case NODE_WHILE_STATEMENT:
             codegen_while_statement((WhileStatementNode*)node);
             break;
-        case NODE_UNARY_OP:
-            codegen_unary_op((UnaryOpNode*)node);
-            break;
-        case NODE_FUNCTION_CALL:
-            codegen_function_call((FunctionCallNode*)node);
-            break;
-        case NODE_ARRAY_ACCESS: {
-            // 读取数组的值: x = a[i];
-            // 1. 拿到地址
-            gen_lvalue(node);
-            // 2. 取值
-            printf("  mov rax, [rax]\n");
-            break;
-        }
-        case NODE_STRING_LITERAL:
-            codegen_string_literal((StringLiteralNode*)node);
-            break;
         case NODE_FOR_STATEMENT:
             codegen_for_statement((ForStatementNode*)node);
             break;
@@ -807,15 +1484,11 @@ static void codegen_node(ASTNode* node) {
         case NODE_CONTINUE:
             codegen_continue(node);
             break;
-        case NODE_MEMBER_ACCESS: {
-            // 读取 p.x 的值
-            gen_lvalue(node);
-            printf("  mov rax, [rax]\n");
-            break;
-        }
         default:
-            fprintf(stderr, "Codegen Error: Unknown AST node type %d\n", node->type);
-            exit(1);
+            // 表达式语句 (x = 1; f(2); ...)：求值，结果丢掉。能原地改内存的赋值不经过寄存器
+            if (node->type == NODE_BINARY_OP && gen_assign_in_place((BinaryOpNode*)node)) break;
+            gen_expr_value(node);
+            break;
     }
 }
 
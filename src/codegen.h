@@ -3,12 +3,39 @@
 
 #include "ast.h"
 
+/**
+ * @brief 是否省略帧指针 (默认 1，-fno-omit-frame-pointer 置 0)。
+ *
+ * 省略时函数不再 push rbp; mov rbp, rsp，局部变量用 rsp 相对的地址访问，
+ * 叶子函数直接使用 rsp 下面 128 字节的红区，连 sub rsp 都没有。
+ * 两个后端 (codegen.c 和 ir_x86.c) 都看这个开关。
+ */
+extern int omit_frame_pointer;
+
+/**
+ * @brief --frame-report：每个函数生成完以后往 stderr 打一行栈帧大小 (两个后端都打)。
+ *
+ * 格式: "frame: 函数名: locals 各占一块的字节数 -> 按作用域共用以后的字节数, frame 栈帧总字节数"。
+ * 栈帧总字节数是返回地址以下这个函数用到的栈 (保存的 rbp / 寄存器、局部变量、溢出，红区里的也算)。
+ */
+extern int frame_report;
+void print_frame_report(const char* name, int locals_unshared, int locals_shared, int frame);
+
 /**
  * @brief 代码生成器的入口函数。
  * 
- * 接收 AST 的根节点，并将生成的汇编代码打印到标准输出。
+ * 接收 AST 的根节点，并将生成的汇编代码追加到输出缓冲区 (见 emit.h)。
+ * 由调用方决定把缓冲区写到哪里 (emit_write) 或交给后续阶段 (emit_buffer)。
  * @param root AST 的根节点。
  */
 void codegen(ASTNode* root);
 
+/**
+ * @brief 只输出汇编文件头 (.intel_syntax) 和全局变量的 .data 段。
+ *
+ * 函数体由 IR 后端 (ir_x86.c) 生成时，全局变量仍然走这里。
+ * @param node 程序的根节点。
+ */
+void codegen_globals(ProgramNode* node);
+
 #endif // CODEGEN_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include "emit.h"
+
+static char* buffer = NULL;
+static size_t length = 0;
+static size_t capacity = 0;
+
+// 保证还能再放 extra 个字节 (外加结尾的 '\0')，不够就按 2 倍扩容
+static void reserve(size_t extra) {
+    if (length + extra + 1 <= capacity) return;
+    size_t new_capacity = capacity == 0 ? 64 * 1024 : capacity;
+    while (length + extra + 1 > new_capacity) new_capacity *= 2;
+    buffer = (char*)realloc(buffer, new_capacity);
+    if (!buffer) {
+        fprintf(stderr, "Error: Out of memory (emitter)\n");
+        exit(1);
+    }
+    capacity = new_capacity;
+}
+
+static void append(const char* str, size_t len) {
+    reserve(len);
+    memcpy(buffer + length, str, len);
+    length += len;
+}
+
+static void append_char(char c) {
+    reserve(1);
+    buffer[length++] = c;
+}
+
+void emit_str(const char* str) {
+    append(str, strlen(str));
+}
+
+void emit_strn(const char* str, size_t len) {
+    append(str, len);
+}
+
+// 手写的整数格式化：从低位往高位写到临时数组里，再整体拷贝
+void emit_int(long value) {
+    char digits[24];
+    int pos = sizeof(digits);
+    // 用无符号数处理，LONG_MIN 取负也不会溢出
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) digits[--pos] = '-';
+    append(digits + pos, sizeof(digits) - pos);
+}
+
+void emit(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+
+    const char* run = fmt; // 尚未输出的普通文本的起点
+    const char* p = fmt;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        // 先把 % 之前的普通文本整段拷贝过去
+        append(run, p - run);
+        switch (p[1]) {
+            case 's': emit_str(va_arg(args, const char*)); break;
+            case 'd': emit_int(va_arg(args, int)); break;
+            case 'c': append_char((char)va_arg(args, int)); break;
+            case '%': append_char('%'); break;
+            case 'l':
+                if (p[2] != 'd') {
+                    fprintf(stderr, "Emitter Error: Unsupported format '%%l%c'\n", p[2]);
+                    exit(1);
+                }
+                emit_int(va_arg(args, long));
+                p++;
+                break;
+            default:
+                fprintf(stderr, "Emitter Error: Unsupported format '%%%c'\n", p[1]);
+                exit(1);
+        }
+        p += 2;
+        run = p;
+    }
+    append(run, p - run);
+
+    va_end(args);
+}
+
+const char* emit_buffer(size_t* out_length) {
+    reserve(0);
+    buffer[length] = '\0';
+    if (out_length) *out_length = length;
+    return buffer;
+}
+
+size_t emit_length() {
+    return length;
+}
+
+void emit_truncate(size_t new_length) {
+    if (new_length < length) length = new_length;
+}
+
+int emit_write(int fd) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, buffer + written, length - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+    return 0;
+}
+
+void emit_reset() {
+    length = 0;
+}
+
+void emit_free() {
+    free(buffer);
+    buffer = NULL;
+    length = 0;
+    capacity = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef EMIT_H
+#define EMIT_H
+
+#include <stddef.h>
+
+// --- 汇编输出缓冲区 (Emitter) ---
+// 代码生成器不再对每条指令调用一次 printf，而是把文本追加到一个可增长的内存缓冲区里。
+// 格式化是手写的 (只支持 %s %d %ld %c %%)，不经过 stdio，也没有加锁开销。
+// 生成结束后，用一次 write 系统调用把整个缓冲区写到文件/标准输出，
+// 或者直接把缓冲区交给后续的进程内阶段处理。
+
+// 按格式追加文本：%s 字符串, %d int, %ld long, %c 字符, %% 百分号
+void emit(const char* fmt, ...);
+// 追加一个原样的字符串
+void emit_str(const char* str);
+// 追加 str 的前 len 个字节 (不要求以 '\0' 结尾)
+void emit_strn(const char* str, size_t len);
+// 追加一个十进制整数 (long，足够放下任何立即数)
+void emit_int(long value);
+
+// 取得当前缓冲区的内容 (以 '\0' 结尾)，length 返回字节数。
+// 缓冲区仍归 emitter 所有，下一次 emit 可能让指针失效。
+const char* emit_buffer(size_t* length);
+// 已经输出的字节数，以及回退到之前的某个长度 (丢掉之后输出的内容，用来重新生成一段代码)
+size_t emit_length();
+void emit_truncate(size_t length);
+// 把整个缓冲区写到文件描述符 fd (一次 write，处理部分写入)，成功返回 0
+int emit_write(int fd);
+// 清空缓冲区 (保留已分配的内存，供下一次使用)
+void emit_reset();
+// 释放缓冲区
+void emit_free();
+
+#endif // EMIT_H
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "fold.h"
+#include "symtab.h"
+
+// --- 表达式折叠 ---
+
+static int is_constant(ASTNode* node, long* value) {
+    if (node == NULL || node->type != NODE_NUMERIC_LITERAL) return 0;
+    *value = strtol(((NumericLiteralNode*)node)->value, NULL, 10);
+    return 1;
+}
+
+static ASTNode* make_constant(long value) {
+    char* text = (char*)arena_alloc(&ast_arena, 24);
+    snprintf(text, 24, "%ld", value);
+    return (ASTNode*)create_numeric_literal(text);
+}
+
+// 两个常量做二元运算。和生成的代码一样按 64 位补码回绕；除以 0 这类运行时才出错的不折叠
+static int fold_binary(TokenType op, long a, long b, long* result) {
+    unsigned long ua = (unsigned long)a, ub = (unsigned long)b;
+    switch (op) {
+        case TOKEN_PLUS:  *result = (long)(ua + ub); return 1;
+        case TOKEN_MINUS: *result = (long)(ua - ub); return 1;
+        case TOKEN_STAR:  *result = (long)(ua * ub); return 1;
+        case TOKEN_SLASH:
+            if (b == 0 || (a == LONG_MIN && b == -1)) return 0;
+            *result = a / b;
+            return 1;
+        case TOKEN_EQ:  *result = a == b; return 1;
+        case TOKEN_NEQ: *result = a != b; return 1;
+        case TOKEN_LT:  *result = a < b;  return 1;
+        case TOKEN_LE:  *result = a <= b; return 1;
+        case TOKEN_GT:  *result = a > b;  return 1;
+        case TOKEN_GE:  *result = a >= b; return 1;
+        case TOKEN_LOGIC_AND: *result = a && b; return 1;
+        case TOKEN_LOGIC_OR:  *result = a || b; return 1;
+        default: return 0;
+    }
+}
+
+static void fold_expr(ASTNode** slot);
+
+static void fold_binary_op(ASTNode** slot) {
+    BinaryOpNode* node = (BinaryOpNode*)*slot;
+    fold_expr(&node->right);
+    if (node->op == TOKEN_ASSIGN) {
+        // 左边是被赋值的位置，只折叠里面的下标 (a[1+1] = ...)
+        if (node->left->type == NODE_ARRAY_ACCESS) fold_expr(&((ArrayAccessNode*)node->left)->index);
+        if (node->left->type == NODE_UNARY_OP) fold_expr(&((UnaryOpNode*)node->left)->operand);
+        return;
+    }
+    fold_expr(&node->left);
+
+    long a, b, result;
+    int left_constant = is_constant(node->left, &a);
+    if (left_constant && is_constant(node->right, &b)) {
+        if (fold_binary(node->op, a, b, &result)) *slot = make_constant(result);
+        return;
+    }
+
+    // 短路运算只看左边就能决定的情况 (右边根本不会被求值，所以可以整个丢掉)：
+    //   0 && x -> 0,  1 || x -> 1,  1 && x -> (x != 0),  0 || x -> (x != 0)
+    if (left_constant && (node->op == TOKEN_LOGIC_AND || node->op == TOKEN_LOGIC_OR)) {
+        int decided = node->op == TOKEN_LOGIC_AND ? a == 0 : a != 0;
+        if (decided) {
+            *slot = make_constant(node->op == TOKEN_LOGIC_OR);
+        } else {
+            *slot = (ASTNode*)create_binary_op_node(node->right, TOKEN_NEQ, make_constant(0));
+        }
+    }
+}
+
+static void fold_expr(ASTNode** slot) {
+    ASTNode* node = *slot;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_BINARY_OP:
+            fold_binary_op(slot);
+            break;
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            if (unary->op == TOKEN_AMPERSAND) break; // &x 的操作数是左值，不能折叠
+            fold_expr(&unary->operand);
+            long value;
+            if (!is_constant(unary->operand, &value)) break;
+            if (unary->op == TOKEN_MINUS) *slot = make_constant((long)(0ul - (unsigned long)value));
+            else if (unary->op == TOKEN_BANG) *slot = make_constant(!value);
+            else if (unary->op == TOKEN_PLUS) *slot = unary->operand;
+            break;
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            for (int i = 0; i < call->arg_count; i++) fold_expr(&call->args[i]);
+            break;
+        }
+        case NODE_ARRAY_ACCESS:
+            fold_expr(&((ArrayAccessNode*)node)->index);
+            break;
+        default:
+            break;
+    }
+}
+
+// --- 语句：折叠表达式，删掉死分支 ---
+
+static ASTNode* empty_statement() {
+    return (ASTNode*)create_block_statement();
+}
+
+// 用 if 的一个分支替换整个 if。分支如果直接是一个声明，包一层代码块保持它原来的作用域
+static ASTNode* as_statement(ASTNode* branch) {
+    if (branch == NULL) return empty_statement();
+    if (branch->type == NODE_VAR_DECL) {
+        BlockStatementNode* block = create_block_statement();
+        add_statement_to_block(block, branch);
+        return (ASTNode*)block;
+    }
+    return branch;
+}
+
+static void fold_statement(ASTNode** slot) {
+    ASTNode* node = *slot;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) fold_statement(&block->statements[i]);
+            break;
+        }
+        case NODE_VAR_DECL:
+            fold_expr(&((VarDeclNode*)node)->initial_value);
+            break;
+        case NODE_RETURN_STATEMENT:
+            fold_expr(&((ReturnStatementNode*)node)->argument);
+            break;
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            fold_expr(&stmt->condition);
+            fold_statement(&stmt->body);
+            fold_statement(&stmt->else_branch);
+            long value;
+            if (is_constant(stmt->condition, &value)) {
+                *slot = as_statement(value ? stmt->body : stmt->else_branch);
+            }
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            fold_expr(&stmt->condition);
+            fold_statement(&stmt->body);
+            long value;
+            if (is_constant(stmt->condition, &value) && value == 0) *slot = empty_statement();
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            fold_statement(&stmt->init);
+            fold_expr(&stmt->condition);
+            fold_expr(&stmt->increment);
+            fold_statement(&stmt->body);
+            long value;
+            if (is_constant(stmt->condition, &value) && value == 0) {
+                // 循环体一次都不执行，只剩初始化 (它在 for 自己的作用域里)
+                *slot = as_statement(stmt->init);
+            }
+            break;
+        }
+        case NODE_BREAK:
+        case NODE_CONTINUE:
+            break;
+        default:
+            fold_expr(slot); // 表达式语句
+            break;
+    }
+}
+
+// --- 常量传播 ---
+// 第一遍按作用域把每个读取解析到它的声明 (复用 symtab，Symbol.slot 记变量编号)，
+// 统计每个变量有没有被再次赋值、有没有被取地址；
+// 第二遍把 "只赋值一次的常量" 的读取换成字面量。
+
+typedef struct {
+    VarDeclNode* decl;      // 参数的 decl 为 NULL (值在运行时才知道)
+    int assigned;           // 声明之后还被赋值过
+    int address_taken;
+} LocalInfo;
+
+typedef struct {
+    ASTNode** slot;         // 读取这个变量的表达式在父节点里的位置
+    int local;
+} ReadSite;
+
+static LocalInfo* locals = NULL;
+static int local_count = 0;
+static int local_capacity = 0;
+static ReadSite* reads = NULL;
+static int read_count = 0;
+static int read_capacity = 0;
+
+static void out_of_memory() {
+    fprintf(stderr, "Error: Out of memory (constant folding)\n");
+    exit(1);
+}
+
+static void declare(char* name, VarDeclNode* decl) {
+    if (local_count == local_capacity) {
+        local_capacity = local_capacity == 0 ? 64 : local_capacity * 2;
+        locals = (LocalInfo*)realloc(locals, local_capacity * sizeof(LocalInfo));
+        if (!locals) out_of_memory();
+    }
+    locals[local_count].decl = decl;
+    locals[local_count].assigned = 0;
+    locals[local_count].address_taken = 0;
+    symtab_declare(name)->slot = local_count++;
+}
+
+static void add_read(ASTNode** slot, int local) {
+    if (read_count == read_capacity) {
+        read_capacity = read_capacity == 0 ? 256 : read_capacity * 2;
+        reads = (ReadSite*)realloc(reads, read_capacity * sizeof(ReadSite));
+        if (!reads) out_of_memory();
+    }
+    reads[read_count].slot = slot;
+    reads[read_count].local = local;
+    read_count++;
+}
+
+// 名字对应的局部变量编号，全局变量返回 -1
+static int resolve(char* name) {
+    Symbol* sym = find_symbol(name);
+    return sym ? sym->slot : -1;
+}
+
+static void scan_expr(ASTNode** slot) {
+    ASTNode* node = *slot;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            int local = resolve(((IdentifierNode*)node)->name);
+            if (local != -1) add_read(slot, local);
+            break;
+        }
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            scan_expr(&bin->right);
+            if (bin->op == TOKEN_ASSIGN && bin->left->type == NODE_IDENTIFIER) {
+                int local = resolve(((IdentifierNode*)bin->left)->name);
+                if (local != -1) locals[local].assigned = 1;
+            } else {
+                scan_expr(&bin->left);
+            }
+            break;
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            if (unary->op == TOKEN_AMPERSAND && unary->operand->type == NODE_IDENTIFIER) {
+                int local = resolve(((IdentifierNode*)unary->operand)->name);
+                if (local != -1) locals[local].address_taken = 1;
+            } else {
+                scan_expr(&unary->operand);
+            }
+            break;
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            for (int i = 0; i < call->arg_count; i++) scan_expr(&call->args[i]);
+            break;
+        }
+        case NODE_ARRAY_ACCESS:
+            scan_expr(&((ArrayAccessNode*)node)->index);
+            break;
+        default:
+            break;
+    }
+}
+
+static void scan_statement(ASTNode* node) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            symtab_push_scope();
+            for (int i = 0; i < block->count; i++) scan_statement(block->statements[i]);
+            symtab_pop_scope();
+            break;
+        }
+        case NODE_VAR_DECL: {
+            // 和代码生成一致：初始值求完以后变量才进入作用域
+            VarDeclNode* var = (VarDeclNode*)node;
+            scan_expr(&var->initial_value);
+            declare(var->name, var);
+            break;
+        }
+        case NODE_RETURN_STATEMENT:
+            scan_expr(&((ReturnStatementNode*)node)->argument);
+            break;
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            scan_expr(&stmt->condition);
+            scan_statement(stmt->body);
+            scan_statement(stmt->else_branch);
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            scan_expr(&stmt->condition);
+            scan_statement(stmt->body);
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            symtab_push_scope();
+            scan_statement(stmt->init);
+            scan_expr(&stmt->condition);
+            scan_expr(&stmt->increment);
+            scan_statement(stmt->body);
+            symtab_pop_scope();
+            break;
+        }
+        case NODE_BREAK:
+        case NODE_CONTINUE:
+            break;
+        default:
+            // 表达式语句。单独一个变量名的语句不记录 (它没有可以回写的父节点位置，也没有意义)
+            if (node->type != NODE_IDENTIFIER) scan_expr(&node);
+            break;
+    }
+}
+
+// 变量能不能当常量传播，能的话 value 返回它的值
+static int constant_local(LocalInfo* info, long* value) {
+    VarDeclNode* decl = info->decl;
+    if (!decl || info->assigned || info->address_taken) return 0;
+    if (decl->array_size > 0 || (decl->var_type != TYPE_INT && decl->var_type != TYPE_CHAR)) return 0;
+    if (!is_constant(decl->initial_value, value)) return 0;
+    if (decl->var_type == TYPE_CHAR) *value = (unsigned char)*value; // char 只存 1 字节
+    return 1;
+}
+
+// 对一个函数做一轮常量传播，返回替换了多少个读取
+static int propagate_function(FunctionDeclarationNode* func) {
+    local_count = 0;
+    read_count = 0;
+    symtab_reset();
+    symtab_push_scope();
+    for (int i = 0; i < func->arg_count; i++) {
+        declare(((VarDeclNode*)func->args[i])->name, NULL);
+    }
+    scan_statement((ASTNode*)func->body);
+    symtab_pop_scope();
+
+    int replaced = 0;
+    for (int i = 0; i < read_count; i++) {
+        long value;
+        if (constant_local(&locals[reads[i].local], &value)) {
+            *reads[i].slot = make_constant(value);
+            replaced++;
+        }
+    }
+    // 所有读取都已经换成字面量了，声明处的存储也就没用了
+    for (int i = 0; i < local_count; i++) {
+        long value;
+        if (constant_local(&locals[i], &value)) locals[i].decl->initial_value = NULL;
+    }
+    return replaced;
+}
+
+void fold_program(ASTNode* root) {
+    ProgramNode* program = (ProgramNode*)root;
+    for (int i = 0; i < program->count; i++) {
+        ASTNode* child = program->declarations[i];
+        if (child->type == NODE_VAR_DECL) {
+            fold_expr(&((VarDeclNode*)child)->initial_value);
+        } else if (child->type == NODE_FUNCTION_DECL) {
+            FunctionDeclarationNode* func = (FunctionDeclarationNode*)child;
+            // 传播出新的常量以后再折叠一遍，直到没有变化 (int k = 3; int m = k * 4; ...)
+            do {
+                fold_statement((ASTNode**)&func->body);
+            } while (propagate_function(func) > 0);
+        }
+    }
+    free(locals);
+    free(reads);
+    locals = NULL;
+    reads = NULL;
+    local_capacity = read_capacity = 0;
+}
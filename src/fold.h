@@ -0,0 +1,14 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+
+// --- 常量折叠与常量传播 (AST 上的 pass，在代码生成之前运行) ---
+//   * 折叠常量子树：算术、比较、&&、||、一元 - 和 !，结果是新的数字字面量；
+//   * 只在声明时赋值一次、之后既不被赋值也不被取地址的局部 int/char 变量，
+//     它的常量值直接替换掉所有读取；
+//   * 条件是常量的 if / while / for 删掉永远不会执行的分支；
+//   * 全局变量的初始值折叠成字面量 (codegen 要求它是常量表达式)。
+void fold_program(ASTNode* root);
+
+#endif // FOLD_H
@@ -0,0 +1,1082 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "inline.h"
+#include "intern.h"
+
+int inline_threshold = 16;
+
+// 循环深度最多按 3 算：再深的调用点也只允许 4 倍阈值的函数，展开后的代码不会无限膨胀
+#define MAX_LOOP_WEIGHT 3
+// 表达式内联最多处理几个形参 (和调用约定的 6 个参数寄存器一致)
+#define MAX_PARAMS 6
+
+static void out_of_memory() {
+    fprintf(stderr, "Error: Out of memory (inlining)\n");
+    exit(1);
+}
+
+// --- 函数表 ---
+// 按函数名 (驻留指针) 哈希的开放寻址索引，槽位里存 下标+1，0 表示空
+
+typedef struct {
+    FunctionDeclarationNode* decl;
+    int index;          // Tarjan 算法的访问序号，-1 表示还没访问
+    int lowlink;
+    int on_stack;
+    int recursive;      // 在调用图的环上 (包括直接调用自己)
+    int size;           // 函数体的 AST 节点数 (它自己的调用内联完以后)
+} FunctionInfo;
+
+static FunctionInfo* functions = NULL;
+static int function_count = 0;
+static int* function_index = NULL;
+static int function_index_capacity = 0;
+
+static FunctionInfo* find_function(char* name) {
+    unsigned mask = function_index_capacity - 1;
+    for (unsigned i = hash_atom(name) & mask; function_index[i] != 0; i = (i + 1) & mask) {
+        FunctionInfo* info = &functions[function_index[i] - 1];
+        if (info->decl->name == name) return info;
+    }
+    return NULL;
+}
+
+static void build_function_table(ProgramNode* program) {
+    functions = (FunctionInfo*)calloc(program->count > 0 ? program->count : 1, sizeof(FunctionInfo));
+    function_index_capacity = 16;
+    while (function_index_capacity < program->count * 2) function_index_capacity *= 2;
+    function_index = (int*)calloc(function_index_capacity, sizeof(int));
+    if (!functions || !function_index) out_of_memory();
+
+    for (int i = 0; i < program->count; i++) {
+        ASTNode* child = program->declarations[i];
+        if (child->type != NODE_FUNCTION_DECL) continue;
+        FunctionDeclarationNode* decl = (FunctionDeclarationNode*)child;
+        if (find_function(decl->name)) continue; // 重复定义：只认第一个
+        FunctionInfo* info = &functions[function_count++];
+        info->decl = decl;
+        info->index = -1;
+        unsigned mask = function_index_capacity - 1;
+        unsigned slot = hash_atom(decl->name) & mask;
+        while (function_index[slot] != 0) slot = (slot + 1) & mask;
+        function_index[slot] = function_count;
+    }
+}
+
+// --- 报告 ---
+
+typedef struct {
+    char* caller;
+    char* callee;
+    int depth;          // 调用点的循环深度
+    int size;           // 被调函数的大小
+    int limit;          // 这个调用点允许的大小
+    const char* reason; // 没有内联的原因，NULL 表示内联了
+} InlineDecision;
+
+static InlineDecision* decisions = NULL;
+static int decision_count = 0;
+static int decision_capacity = 0;
+
+static FunctionInfo* current_caller; // 正在往里内联的函数
+
+static void record(FunctionInfo* callee, int depth, int limit, const char* reason) {
+    if (decision_count == decision_capacity) {
+        decision_capacity = decision_capacity == 0 ? 64 : decision_capacity * 2;
+        decisions = (InlineDecision*)realloc(decisions, decision_capacity * sizeof(InlineDecision));
+        if (!decisions) out_of_memory();
+    }
+    InlineDecision* d = &decisions[decision_count++];
+    d->caller = current_caller->decl->name;
+    d->callee = callee->decl->name;
+    d->depth = depth;
+    d->size = callee->size;
+    d->limit = limit;
+    d->reason = reason;
+}
+
+void inline_print_report() {
+    for (int i = 0; i < decision_count; i++) {
+        InlineDecision* d = &decisions[i];
+        fprintf(stderr, "inline: %s -> %s (size %d, limit %d, loop depth %d): ",
+                d->caller, d->callee, d->size, d->limit, d->depth);
+        if (d->reason) fprintf(stderr, "not inlined, %s\n", d->reason);
+        else fprintf(stderr, "inlined\n");
+    }
+}
+
+// --- 遍历小工具 ---
+
+static int count_nodes(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            int n = 1;
+            for (int i = 0; i < block->count; i++) n += count_nodes(block->statements[i]);
+            return n;
+        }
+        case NODE_VAR_DECL:
+            return 1 + count_nodes(((VarDeclNode*)node)->initial_value);
+        case NODE_RETURN_STATEMENT:
+            return 1 + count_nodes(((ReturnStatementNode*)node)->argument);
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            return 1 + count_nodes(stmt->condition) + count_nodes(stmt->body) + count_nodes(stmt->else_branch);
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            return 1 + count_nodes(stmt->condition) + count_nodes(stmt->body);
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            return 1 + count_nodes(stmt->init) + count_nodes(stmt->condition) +
+                   count_nodes(stmt->increment) + count_nodes(stmt->body);
+        }
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            return 1 + count_nodes(bin->left) + count_nodes(bin->right);
+        }
+        case NODE_UNARY_OP:
+            return 1 + count_nodes(((UnaryOpNode*)node)->operand);
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            int n = 1;
+            for (int i = 0; i < call->arg_count; i++) n += count_nodes(call->args[i]);
+            return n;
+        }
+        case NODE_ARRAY_ACCESS:
+            return 1 + count_nodes(((ArrayAccessNode*)node)->index);
+        default:
+            return 1;
+    }
+}
+
+// 语句里有没有 return
+static int contains_return(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_RETURN_STATEMENT:
+            return 1;
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) {
+                if (contains_return(block->statements[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            return contains_return(stmt->body) || contains_return(stmt->else_branch);
+        }
+        case NODE_WHILE_STATEMENT:
+            return contains_return(((WhileStatementNode*)node)->body);
+        case NODE_FOR_STATEMENT:
+            return contains_return(((ForStatementNode*)node)->body);
+        default:
+            return 0;
+    }
+}
+
+// 语句是不是每条路径都以 return 结束 (之后的语句执行不到)
+static int always_returns(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_RETURN_STATEMENT:
+            return 1;
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) {
+                if (always_returns(block->statements[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            return always_returns(stmt->body) && always_returns(stmt->else_branch);
+        }
+        default:
+            return 0;
+    }
+}
+
+// 表达式有没有副作用 (函数调用、赋值)
+static int has_side_effects(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_FUNCTION_CALL:
+            return 1;
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            return bin->op == TOKEN_ASSIGN || has_side_effects(bin->left) || has_side_effects(bin->right);
+        }
+        case NODE_UNARY_OP:
+            return has_side_effects(((UnaryOpNode*)node)->operand);
+        case NODE_ARRAY_ACCESS:
+            return has_side_effects(((ArrayAccessNode*)node)->index);
+        default:
+            return 0;
+    }
+}
+
+static int is_literal(ASTNode* node, long* value) {
+    if (node->type != NODE_NUMERIC_LITERAL) return 0;
+    *value = strtol(((NumericLiteralNode*)node)->value, NULL, 10);
+    return 1;
+}
+
+static ASTNode* make_constant(long value) {
+    char* text = (char*)arena_alloc(&ast_arena, 24);
+    snprintf(text, 24, "%ld", value);
+    return (ASTNode*)create_numeric_literal(text);
+}
+
+// 内联出来的局部变量的新名字："a.3"。'.' 不会出现在源码的标识符里，所以不会和任何变量重名
+static int fresh_counter = 0;
+
+static char* fresh_name(const char* base) {
+    char buffer[128];
+    int len = snprintf(buffer, sizeof(buffer), "%.100s.%d", base, fresh_counter++);
+    return intern(buffer, len);
+}
+
+// --- 调用者的局部变量名集合 ---
+// 被调函数引用的全局变量如果和调用者的某个局部变量同名，展开后会被它遮蔽，这种调用点不内联。
+// 不区分作用域 (调用者里任何地方声明过都算)，保守但足够简单
+
+static char** caller_names = NULL;  // 开放寻址，NULL 表示空
+static int caller_name_capacity = 0;
+static int caller_name_count = 0;
+
+static void add_caller_name(char* name) {
+    if ((caller_name_count + 1) * 2 > caller_name_capacity) {
+        char** old = caller_names;
+        int old_capacity = caller_name_capacity;
+        caller_name_capacity = old_capacity == 0 ? 32 : old_capacity * 2;
+        caller_names = (char**)calloc(caller_name_capacity, sizeof(char*));
+        if (!caller_names) out_of_memory();
+        caller_name_count = 0;
+        for (int i = 0; i < old_capacity; i++) {
+            if (old[i]) add_caller_name(old[i]);
+        }
+        free(old);
+    }
+    unsigned mask = caller_name_capacity - 1;
+    unsigned i = hash_atom(name) & mask;
+    while (caller_names[i] != NULL) {
+        if (caller_names[i] == name) return;
+        i = (i + 1) & mask;
+    }
+    caller_names[i] = name;
+    caller_name_count++;
+}
+
+static int is_caller_name(char* name) {
+    if (caller_name_capacity == 0) return 0;
+    unsigned mask = caller_name_capacity - 1;
+    for (unsigned i = hash_atom(name) & mask; caller_names[i] != NULL; i = (i + 1) & mask) {
+        if (caller_names[i] == name) return 1;
+    }
+    return 0;
+}
+
+static void collect_caller_names(ASTNode* node) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) collect_caller_names(block->statements[i]);
+            break;
+        }
+        case NODE_VAR_DECL:
+            add_caller_name(((VarDeclNode*)node)->name);
+            break;
+        case NODE_IF_STATEMENT:
+            collect_caller_names(((IfStatementNode*)node)->body);
+            collect_caller_names(((IfStatementNode*)node)->else_branch);
+            break;
+        case NODE_WHILE_STATEMENT:
+            collect_caller_names(((WhileStatementNode*)node)->body);
+            break;
+        case NODE_FOR_STATEMENT:
+            collect_caller_names(((ForStatementNode*)node)->init);
+            collect_caller_names(((ForStatementNode*)node)->body);
+            break;
+        default:
+            break;
+    }
+}
+
+// --- 名字绑定 ---
+// 复制被调函数的代码时，它的形参和局部变量要换成新名字 (语句内联)，
+// 或者形参直接换成实参表达式 (表达式内联)。绑定按作用域压栈，查找从栈顶往下找。
+
+typedef struct {
+    char* name;         // 被调函数里的名字
+    char* new_name;     // 换成的新名字
+    ASTNode* value;     // 或者换成的表达式 (不为 NULL 时优先)
+} Binding;
+
+static Binding* bindings = NULL;
+static int binding_count = 0;
+static int binding_capacity = 0;
+
+static void bind(char* name, char* new_name, ASTNode* value) {
+    if (binding_count == binding_capacity) {
+        binding_capacity = binding_capacity == 0 ? 32 : binding_capacity * 2;
+        bindings = (Binding*)realloc(bindings, binding_capacity * sizeof(Binding));
+        if (!bindings) out_of_memory();
+    }
+    bindings[binding_count].name = name;
+    bindings[binding_count].new_name = new_name;
+    bindings[binding_count].value = value;
+    binding_count++;
+}
+
+static Binding* lookup(char* name) {
+    for (int i = binding_count - 1; i >= 0; i--) {
+        if (bindings[i].name == name) return &bindings[i];
+    }
+    return NULL;
+}
+
+// 被调函数里的名字换成什么 (没有绑定的是全局变量，名字不变)
+static char* renamed(char* name) {
+    Binding* b = lookup(name);
+    return b ? b->new_name : name;
+}
+
+// 被调函数里引用的全局变量会不会被调用者的局部变量遮蔽
+static int captures_caller_name(ASTNode* node) {
+    if (node == NULL) return 0;
+    switch (node->type) {
+        case NODE_IDENTIFIER:
+            return !lookup(((IdentifierNode*)node)->name) && is_caller_name(((IdentifierNode*)node)->name);
+        case NODE_ARRAY_ACCESS: {
+            ArrayAccessNode* access = (ArrayAccessNode*)node;
+            if (!lookup(access->array_name) && is_caller_name(access->array_name)) return 1;
+            return captures_caller_name(access->index);
+        }
+        case NODE_MEMBER_ACCESS: {
+            MemberAccessNode* member = (MemberAccessNode*)node;
+            return !lookup(member->struct_var_name) && is_caller_name(member->struct_var_name);
+        }
+        case NODE_BINARY_OP:
+            return captures_caller_name(((BinaryOpNode*)node)->left) ||
+                   captures_caller_name(((BinaryOpNode*)node)->right);
+        case NODE_UNARY_OP:
+            return captures_caller_name(((UnaryOpNode*)node)->operand);
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            for (int i = 0; i < call->arg_count; i++) {
+                if (captures_caller_name(call->args[i])) return 1;
+            }
+            return 0;
+        }
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            int mark = binding_count, found = 0;
+            for (int i = 0; i < block->count && !found; i++) found = captures_caller_name(block->statements[i]);
+            binding_count = mark;
+            return found;
+        }
+        case NODE_VAR_DECL: {
+            VarDeclNode* var = (VarDeclNode*)node;
+            if (captures_caller_name(var->initial_value)) return 1;
+            bind(var->name, var->name, NULL);
+            return 0;
+        }
+        case NODE_RETURN_STATEMENT:
+            return captures_caller_name(((ReturnStatementNode*)node)->argument);
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            return captures_caller_name(stmt->condition) || captures_caller_name(stmt->body) ||
+                   captures_caller_name(stmt->else_branch);
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            return captures_caller_name(stmt->condition) || captures_caller_name(stmt->body);
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            int mark = binding_count;
+            int found = captures_caller_name(stmt->init) || captures_caller_name(stmt->condition) ||
+                        captures_caller_name(stmt->increment) || captures_caller_name(stmt->body);
+            binding_count = mark;
+            return found;
+        }
+        default:
+            return 0;
+    }
+}
+
+// --- 复制被调函数的代码 ---
+
+static ASTNode* copy_expr(ASTNode* node, int rename);
+
+static ASTNode** copy_args(FunctionCallNode* call, int rename) {
+    if (call->arg_count == 0) return NULL;
+    ASTNode** args = (ASTNode**)arena_alloc(&ast_arena, call->arg_count * sizeof(ASTNode*));
+    for (int i = 0; i < call->arg_count; i++) args[i] = copy_expr(call->args[i], rename);
+    return args;
+}
+
+// 复制表达式。rename 为 1 时按当前的绑定换名字 (被调函数的代码)，为 0 时原样复制 (调用者的实参)。
+// 字面量不会被任何 pass 原地修改，直接共用
+static ASTNode* copy_expr(ASTNode* node, int rename) {
+    if (node == NULL) return NULL;
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            char* name = ((IdentifierNode*)node)->name;
+            Binding* b = rename ? lookup(name) : NULL;
+            if (b && b->value) return copy_expr(b->value, 0);
+            return (ASTNode*)create_identifier_node(b ? b->new_name : name);
+        }
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            return (ASTNode*)create_binary_op_node(copy_expr(bin->left, rename), bin->op,
+                                                   copy_expr(bin->right, rename));
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            return (ASTNode*)create_unary_op_node(unary->op, copy_expr(unary->operand, rename));
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            return (ASTNode*)create_function_call_node(call->name, copy_args(call, rename), call->arg_count);
+        }
+        case NODE_ARRAY_ACCESS: {
+            ArrayAccessNode* access = (ArrayAccessNode*)node;
+            char* name = rename ? renamed(access->array_name) : access->array_name;
+            return (ASTNode*)create_array_access_node(name, copy_expr(access->index, rename));
+        }
+        case NODE_MEMBER_ACCESS: {
+            MemberAccessNode* copy = (MemberAccessNode*)arena_alloc(&ast_arena, sizeof(MemberAccessNode));
+            *copy = *(MemberAccessNode*)node;
+            if (rename) copy->struct_var_name = renamed(copy->struct_var_name);
+            return (ASTNode*)copy;
+        }
+        default:
+            return node;
+    }
+}
+
+// 复制被调函数的一条语句 (里面没有 return)，声明的变量都换成新名字
+static ASTNode* copy_statement(ASTNode* node) {
+    if (node == NULL) return NULL;
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            BlockStatementNode* copy = create_block_statement();
+            int mark = binding_count;
+            for (int i = 0; i < block->count; i++) add_statement_to_block(copy, copy_statement(block->statements[i]));
+            binding_count = mark;
+            return (ASTNode*)copy;
+        }
+        case NODE_VAR_DECL: {
+            // 和代码生成一致：初始值求完以后变量才进入作用域
+            VarDeclNode* var = (VarDeclNode*)node;
+            ASTNode* initial_value = copy_expr(var->initial_value, 1);
+            char* name = fresh_name(var->name);
+            bind(var->name, name, NULL);
+            return (ASTNode*)create_var_decl_node(name, initial_value, var->array_size, var->var_type, var->struct_name);
+        }
+        case NODE_RETURN_STATEMENT:
+            return (ASTNode*)create_return_statement_node(copy_expr(((ReturnStatementNode*)node)->argument, 1));
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            ASTNode* condition = copy_expr(stmt->condition, 1);
+            ASTNode* body = copy_statement(stmt->body);
+            return (ASTNode*)create_if_statement_node(condition, body, copy_statement(stmt->else_branch));
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            ASTNode* condition = copy_expr(stmt->condition, 1);
+            return (ASTNode*)create_while_statement_node(condition, copy_statement(stmt->body));
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            int mark = binding_count;
+            ASTNode* init = copy_statement(stmt->init);
+            ASTNode* condition = copy_expr(stmt->condition, 1);
+            ASTNode* increment = copy_expr(stmt->increment, 1);
+            ASTNode* body = copy_statement(stmt->body);
+            binding_count = mark;
+            return (ASTNode*)create_for_statement_node(init, condition, increment, body);
+        }
+        case NODE_BREAK:
+            return create_break_node();
+        case NODE_CONTINUE:
+            return create_continue_node();
+        default:
+            return copy_expr(node, 1); // 表达式语句
+    }
+}
+
+// --- 语句内联：把 return 改写成赋值 ---
+// 函数体里的 return 必须都在 "结尾位置"：return 之后到函数结束之间没有别的语句要执行，
+// 或者是 if (c) { ... return x; } 后面跟着别的语句 —— 这时后面的语句挪进不返回的那个分支。
+// 两个分支都可能走到后面的语句时，后面的语句要复制两份，不做；循环里的 return 也不做 (没有 goto)。
+//
+// Continuation 是 "当前语句列表执行完以后还要接着执行的语句"，
+// mark 是这些语句所在作用域的绑定栈高度 (复制它们之前先退回到那个作用域)。
+
+typedef struct Continuation {
+    ASTNode** statements;
+    int count;
+    int mark;
+    struct Continuation* next;
+} Continuation;
+
+static int continuation_empty(Continuation* rest) {
+    for (; rest != NULL; rest = rest->next) {
+        if (rest->count > 0) return 0;
+    }
+    return 1;
+}
+
+// return E 换成 target = E; (target 为 NULL 时结果没人用，只保留 E 的副作用)
+static void emit_result(BlockStatementNode* out, ASTNode* value, ASTNode* target) {
+    value = copy_expr(value, 1);
+    if (target != NULL) {
+        add_statement_to_block(out, (ASTNode*)create_binary_op_node(copy_expr(target, 0), TOKEN_ASSIGN, value));
+    } else if (has_side_effects(value)) {
+        add_statement_to_block(out, value);
+    }
+}
+
+static int rewrite_returns(ASTNode** statements, int count, Continuation* rest,
+                           BlockStatementNode* out, ASTNode* target);
+
+// 把 if 的一个分支 (后面接着 rest) 改写成一个代码块
+static BlockStatementNode* rewrite_branch(ASTNode* branch, Continuation* rest, ASTNode* target, int* ok) {
+    BlockStatementNode* block = create_block_statement();
+    int mark = binding_count;
+    if (branch == NULL) {
+        *ok = rewrite_returns(NULL, 0, rest, block, target);
+    } else if (branch->type == NODE_BLOCK_STATEMENT) {
+        BlockStatementNode* inner = (BlockStatementNode*)branch;
+        *ok = rewrite_returns(inner->statements, inner->count, rest, block, target);
+    } else {
+        *ok = rewrite_returns(&branch, 1, rest, block, target);
+    }
+    binding_count = mark;
+    return block;
+}
+
+// 复制 statements 并接着复制 rest，return 都改写成给 target 赋值，结果追加到 out。做不到时返回 0
+static int rewrite_returns(ASTNode** statements, int count, Continuation* rest,
+                           BlockStatementNode* out, ASTNode* target) {
+    for (int i = 0; i < count; i++) {
+        ASTNode* node = statements[i];
+        if (!contains_return(node)) {
+            add_statement_to_block(out, copy_statement(node));
+            continue;
+        }
+
+        Continuation here = {statements + i + 1, count - i - 1, binding_count, rest};
+        switch (node->type) {
+            case NODE_RETURN_STATEMENT:
+                emit_result(out, ((ReturnStatementNode*)node)->argument, target);
+                return 1; // 后面的语句执行不到
+            case NODE_BLOCK_STATEMENT: {
+                // 代码块后面的语句接在块里面执行 (名字都换过了，作用域变大不会冲突)
+                BlockStatementNode* inner = (BlockStatementNode*)node;
+                BlockStatementNode* block = create_block_statement();
+                int mark = binding_count;
+                int ok = rewrite_returns(inner->statements, inner->count, &here, block, target);
+                binding_count = mark;
+                add_statement_to_block(out, (ASTNode*)block);
+                return ok;
+            }
+            case NODE_IF_STATEMENT: {
+                IfStatementNode* stmt = (IfStatementNode*)node;
+                if (!always_returns(stmt->body) && !always_returns(stmt->else_branch) &&
+                    !continuation_empty(&here)) {
+                    return 0; // 两个分支都会走到后面的语句
+                }
+                ASTNode* condition = copy_expr(stmt->condition, 1);
+                int body_ok, else_ok;
+                BlockStatementNode* body = rewrite_branch(stmt->body, &here, target, &body_ok);
+                BlockStatementNode* else_branch = rewrite_branch(stmt->else_branch, &here, target, &else_ok);
+                add_statement_to_block(out, (ASTNode*)create_if_statement_node(condition, (ASTNode*)body,
+                                                                               (ASTNode*)else_branch));
+                return body_ok && else_ok;
+            }
+            default:
+                return 0; // 循环里的 return
+        }
+    }
+
+    if (rest == NULL) return 1;
+    binding_count = rest->mark;
+    return rewrite_returns(rest->statements, rest->count, rest->next, out, target);
+}
+
+// 语句内联：{ 形参 = 实参; 改写过的函数体 }，失败返回 NULL
+static BlockStatementNode* inline_as_statements(FunctionCallNode* call, FunctionInfo* callee, ASTNode* target) {
+    FunctionDeclarationNode* decl = callee->decl;
+    BlockStatementNode* block = create_block_statement();
+    int mark = binding_count;
+    // 实参按从左到右的顺序求值，存进新的局部变量 (char 形参存 1 字节，和调用时一样截断)
+    for (int i = 0; i < call->arg_count; i++) {
+        VarDeclNode* param = (VarDeclNode*)decl->args[i];
+        char* name = fresh_name(param->name);
+        add_statement_to_block(block, (ASTNode*)create_var_decl_node(name, call->args[i], 0, param->var_type, NULL));
+        bind(param->name, name, NULL);
+    }
+    int ok = rewrite_returns(decl->body->statements, decl->body->count, NULL, block, target);
+    binding_count = mark;
+    return ok ? block : NULL;
+}
+
+// --- 表达式内联 ---
+
+typedef struct {
+    int uses[MAX_PARAMS];   // 每个形参在 return 表达式里出现了几次
+    int param_is_lvalue;    // 有形参被赋值、取地址、当数组或结构体用 (必须有自己的存储)
+    int side_effects;       // 表达式里有调用或赋值
+} ExprUses;
+
+static int param_index(FunctionDeclarationNode* decl, char* name) {
+    for (int i = 0; i < decl->arg_count; i++) {
+        if (((VarDeclNode*)decl->args[i])->name == name) return i;
+    }
+    return -1;
+}
+
+static void scan_uses(ASTNode* node, FunctionDeclarationNode* decl, ExprUses* uses) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            int i = param_index(decl, ((IdentifierNode*)node)->name);
+            if (i != -1) uses->uses[i]++;
+            break;
+        }
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            if (bin->op == TOKEN_ASSIGN) {
+                uses->side_effects = 1;
+                if (bin->left->type == NODE_IDENTIFIER &&
+                    param_index(decl, ((IdentifierNode*)bin->left)->name) != -1) {
+                    uses->param_is_lvalue = 1;
+                }
+            }
+            scan_uses(bin->left, decl, uses);
+            scan_uses(bin->right, decl, uses);
+            break;
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            if (unary->op == TOKEN_AMPERSAND && unary->operand->type == NODE_IDENTIFIER &&
+                param_index(decl, ((IdentifierNode*)unary->operand)->name) != -1) {
+                uses->param_is_lvalue = 1;
+            }
+            scan_uses(unary->operand, decl, uses);
+            break;
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            uses->side_effects = 1;
+            for (int i = 0; i < call->arg_count; i++) scan_uses(call->args[i], decl, uses);
+            break;
+        }
+        case NODE_ARRAY_ACCESS: {
+            ArrayAccessNode* access = (ArrayAccessNode*)node;
+            if (param_index(decl, access->array_name) != -1) uses->param_is_lvalue = 1;
+            scan_uses(access->index, decl, uses);
+            break;
+        }
+        case NODE_MEMBER_ACCESS:
+            if (param_index(decl, ((MemberAccessNode*)node)->struct_var_name) != -1) uses->param_is_lvalue = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+// 函数体是 "return E;" 时把实参代进 E，返回代好的表达式；不能直接代入时返回 NULL。
+// 代入改变了实参的求值时机和次数，所以只有这些情况可以：
+//   * 实参是字面量 (char 形参按 1 字节截断)；
+//   * E 没有副作用、实参也没有副作用，并且形参只用了一次，或者实参就是一个变量 (多读几次值不变)；
+//   * 形参没用到、实参没有副作用 (直接丢掉)。
+static ASTNode* inline_as_expression(FunctionCallNode* call, FunctionInfo* callee) {
+    FunctionDeclarationNode* decl = callee->decl;
+    if (decl->body->count != 1 || decl->body->statements[0]->type != NODE_RETURN_STATEMENT) return NULL;
+    ASTNode* expr = ((ReturnStatementNode*)decl->body->statements[0])->argument;
+
+    ExprUses uses = {{0}, 0, 0};
+    scan_uses(expr, decl, &uses);
+    if (uses.param_is_lvalue) return NULL;
+
+    int mark = binding_count;
+    for (int i = 0; i < call->arg_count; i++) {
+        VarDeclNode* param = (VarDeclNode*)decl->args[i];
+        ASTNode* arg = call->args[i];
+        long value;
+        if (is_literal(arg, &value)) {
+            if (param->var_type == TYPE_CHAR) arg = make_constant((unsigned char)value);
+        } else if (param->var_type == TYPE_CHAR || uses.side_effects || has_side_effects(arg) ||
+                   (uses.uses[i] > 1 && arg->type != NODE_IDENTIFIER)) {
+            binding_count = mark;
+            return NULL;
+        }
+        bind(param->name, NULL, arg);
+    }
+    ASTNode* result = copy_expr(expr, 1);
+    binding_count = mark;
+    return result;
+}
+
+// --- 在调用者里找调用点 ---
+
+// 这个调用点能不能内联 (不看是表达式还是语句)，能的话返回被调函数。
+// 调用的是外部函数 (printf 之类) 时不记录
+static FunctionInfo* decide(FunctionCallNode* call, int depth, int* limit) {
+    FunctionInfo* callee = find_function(call->name);
+    if (!callee) return NULL;
+
+    int weight = depth < MAX_LOOP_WEIGHT ? depth : MAX_LOOP_WEIGHT;
+    *limit = inline_threshold * (1 + weight);
+    const char* reason = NULL;
+    if (strcmp(callee->decl->name, "main") == 0) reason = "main is never inlined";
+    else if (callee->on_stack || callee->recursive) reason = "recursive";
+    else if (call->arg_count != callee->decl->arg_count) reason = "argument count mismatch";
+    else if (call->arg_count > MAX_PARAMS) reason = "more than 6 parameters";
+    else if (callee->size > *limit) reason = "too large";
+    else {
+        int mark = binding_count;
+        for (int i = 0; i < callee->decl->arg_count; i++) {
+            char* name = ((VarDeclNode*)callee->decl->args[i])->name;
+            bind(name, name, NULL);
+        }
+        if (captures_caller_name((ASTNode*)callee->decl->body)) reason = "a global it uses is shadowed in the caller";
+        binding_count = mark;
+    }
+    if (reason) {
+        record(callee, depth, *limit, reason);
+        return NULL;
+    }
+    return callee;
+}
+
+static int inlined_count = 0;
+
+static void inline_expr(ASTNode** slot, int depth);
+
+static void inline_args(FunctionCallNode* call, int depth) {
+    for (int i = 0; i < call->arg_count; i++) inline_expr(&call->args[i], depth);
+}
+
+// 表达式里的调用只能做表达式内联
+static void inline_expr(ASTNode** slot, int depth) {
+    ASTNode* node = *slot;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            inline_expr(&bin->left, depth);
+            inline_expr(&bin->right, depth);
+            break;
+        }
+        case NODE_UNARY_OP:
+            inline_expr(&((UnaryOpNode*)node)->operand, depth);
+            break;
+        case NODE_ARRAY_ACCESS:
+            inline_expr(&((ArrayAccessNode*)node)->index, depth);
+            break;
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            inline_args(call, depth);
+            int limit;
+            FunctionInfo* callee = decide(call, depth, &limit);
+            if (!callee) break;
+            ASTNode* expr = inline_as_expression(call, callee);
+            if (expr) {
+                *slot = expr;
+                inlined_count++;
+            }
+            record(callee, depth, limit, expr ? NULL : "needs a statement context");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// 语句层面的调用 (*slot 是调用)：先试表达式内联，不行再做语句内联。
+// target 是结果要赋给的变量 (x = f(...))；result_slot 不为 NULL 时结果放进一个新的临时变量，
+// 再写回 *result_slot (int x = f(...); 和 return f(...);)
+static void inline_call_statement(ASTNode** slot, int depth, ASTNode* statement, ASTNode* target,
+                                  ASTNode** result_slot, BlockStatementNode* out) {
+    FunctionCallNode* call = (FunctionCallNode*)*slot;
+    inline_args(call, depth);
+    int limit;
+    FunctionInfo* callee = decide(call, depth, &limit);
+    if (!callee) {
+        add_statement_to_block(out, statement);
+        return;
+    }
+
+    ASTNode* expr = inline_as_expression(call, callee);
+    if (expr) {
+        *slot = expr;
+        add_statement_to_block(out, statement == (ASTNode*)call ? expr : statement);
+        inlined_count++;
+        record(callee, depth, limit, NULL);
+        return;
+    }
+
+    char* result = result_slot ? fresh_name("ret") : NULL;
+    if (result) target = (ASTNode*)create_identifier_node(result);
+    BlockStatementNode* block = inline_as_statements(call, callee, target);
+    if (!block) {
+        add_statement_to_block(out, statement);
+        record(callee, depth, limit, "return is not in tail position");
+        return;
+    }
+    if (result) {
+        add_statement_to_block(out, (ASTNode*)create_var_decl_node(result, NULL, 0, TYPE_INT, NULL));
+        add_statement_to_block(out, (ASTNode*)block);
+        *result_slot = target;
+        add_statement_to_block(out, statement);
+    } else {
+        add_statement_to_block(out, (ASTNode*)block);
+    }
+    inlined_count++;
+    record(callee, depth, limit, NULL);
+}
+
+static void inline_block(BlockStatementNode* block, int depth);
+static ASTNode* inline_substatement(ASTNode* node, int depth);
+
+// 处理一条语句，结果 (可能展开成好几条) 追加到 out
+static void inline_statement(ASTNode* node, int depth, BlockStatementNode* out) {
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT:
+            inline_block((BlockStatementNode*)node, depth);
+            add_statement_to_block(out, node);
+            break;
+        case NODE_VAR_DECL: {
+            VarDeclNode* var = (VarDeclNode*)node;
+            if (var->initial_value && var->initial_value->type == NODE_FUNCTION_CALL) {
+                inline_call_statement(&var->initial_value, depth, node, NULL, &var->initial_value, out);
+            } else {
+                inline_expr(&var->initial_value, depth);
+                add_statement_to_block(out, node);
+            }
+            break;
+        }
+        case NODE_RETURN_STATEMENT: {
+            ReturnStatementNode* ret = (ReturnStatementNode*)node;
+            if (ret->argument && ret->argument->type == NODE_FUNCTION_CALL) {
+                inline_call_statement(&ret->argument, depth, node, NULL, &ret->argument, out);
+            } else {
+                inline_expr(&ret->argument, depth);
+                add_statement_to_block(out, node);
+            }
+            break;
+        }
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            inline_expr(&stmt->condition, depth);
+            stmt->body = inline_substatement(stmt->body, depth);
+            stmt->else_branch = inline_substatement(stmt->else_branch, depth);
+            add_statement_to_block(out, node);
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            inline_expr(&stmt->condition, depth + 1);
+            stmt->body = inline_substatement(stmt->body, depth + 1);
+            add_statement_to_block(out, node);
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            // 初始化部分在 for 自己的作用域里，展开成多条语句会改变作用域，只做表达式内联
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            if (stmt->init && stmt->init->type == NODE_VAR_DECL) {
+                inline_expr(&((VarDeclNode*)stmt->init)->initial_value, depth);
+            } else {
+                inline_expr(&stmt->init, depth);
+            }
+            inline_expr(&stmt->condition, depth + 1);
+            inline_expr(&stmt->increment, depth + 1);
+            stmt->body = inline_substatement(stmt->body, depth + 1);
+            add_statement_to_block(out, node);
+            break;
+        }
+        case NODE_BREAK:
+        case NODE_CONTINUE:
+            add_statement_to_block(out, node);
+            break;
+        default: {
+            // 表达式语句：f(...); 或者 x = f(...);
+            BinaryOpNode* assign = (BinaryOpNode*)node;
+            if (node->type == NODE_FUNCTION_CALL) {
+                inline_call_statement(&node, depth, node, NULL, NULL, out);
+            } else if (node->type == NODE_BINARY_OP && assign->op == TOKEN_ASSIGN &&
+                       assign->left->type == NODE_IDENTIFIER && assign->right->type == NODE_FUNCTION_CALL) {
+                inline_call_statement(&assign->right, depth, node, assign->left, NULL, out);
+            } else {
+                inline_expr(&node, depth);
+                add_statement_to_block(out, node);
+            }
+            break;
+        }
+    }
+}
+
+// if / while / for 的分支不一定是代码块：展开成多条语句时包一层代码块
+static ASTNode* inline_substatement(ASTNode* node, int depth) {
+    if (node == NULL) return NULL;
+    if (node->type == NODE_BLOCK_STATEMENT) {
+        inline_block((BlockStatementNode*)node, depth);
+        return node;
+    }
+    BlockStatementNode* out = create_block_statement();
+    inline_statement(node, depth, out);
+    return out->count == 1 ? out->statements[0] : (ASTNode*)out;
+}
+
+static void inline_block(BlockStatementNode* block, int depth) {
+    BlockStatementNode* out = create_block_statement();
+    for (int i = 0; i < block->count; i++) inline_statement(block->statements[i], depth, out);
+    block->statements = out->statements;
+    block->count = out->count;
+    block->capacity = out->capacity;
+}
+
+static void inline_into(FunctionInfo* caller) {
+    FunctionDeclarationNode* decl = caller->decl;
+    current_caller = caller;
+    if (caller_name_capacity > 0) memset(caller_names, 0, caller_name_capacity * sizeof(char*));
+    caller_name_count = 0;
+    for (int i = 0; i < decl->arg_count; i++) add_caller_name(((VarDeclNode*)decl->args[i])->name);
+    collect_caller_names((ASTNode*)decl->body);
+
+    inline_block(decl->body, 0);
+    caller->size = count_nodes((ASTNode*)decl->body);
+}
+
+// --- 调用图：Tarjan 强连通分量，顺便按后序 (被调函数先) 做内联 ---
+// 一个函数访问完的时候，它调用的函数要么已经处理完 (不在栈上)，要么和它在同一个环里 (在栈上)
+
+static FunctionInfo** tarjan_stack = NULL;
+static int tarjan_top = 0;
+static int tarjan_counter = 0;
+
+static void visit_function(FunctionInfo* info);
+
+static void visit_calls(ASTNode* node, FunctionInfo* caller) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            for (int i = 0; i < call->arg_count; i++) visit_calls(call->args[i], caller);
+            FunctionInfo* callee = find_function(call->name);
+            if (!callee) break;
+            if (callee == caller) caller->recursive = 1;
+            if (callee->index == -1) {
+                visit_function(callee);
+                if (callee->lowlink < caller->lowlink) caller->lowlink = callee->lowlink;
+            } else if (callee->on_stack && callee->index < caller->lowlink) {
+                caller->lowlink = callee->index;
+            }
+            break;
+        }
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            for (int i = 0; i < block->count; i++) visit_calls(block->statements[i], caller);
+            break;
+        }
+        case NODE_VAR_DECL:
+            visit_calls(((VarDeclNode*)node)->initial_value, caller);
+            break;
+        case NODE_RETURN_STATEMENT:
+            visit_calls(((ReturnStatementNode*)node)->argument, caller);
+            break;
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            visit_calls(stmt->condition, caller);
+            visit_calls(stmt->body, caller);
+            visit_calls(stmt->else_branch, caller);
+            break;
+        }
+        case NODE_WHILE_STATEMENT:
+            visit_calls(((WhileStatementNode*)node)->condition, caller);
+            visit_calls(((WhileStatementNode*)node)->body, caller);
+            break;
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            visit_calls(stmt->init, caller);
+            visit_calls(stmt->condition, caller);
+            visit_calls(stmt->increment, caller);
+            visit_calls(stmt->body, caller);
+            break;
+        }
+        case NODE_BINARY_OP:
+            visit_calls(((BinaryOpNode*)node)->left, caller);
+            visit_calls(((BinaryOpNode*)node)->right, caller);
+            break;
+        case NODE_UNARY_OP:
+            visit_calls(((UnaryOpNode*)node)->operand, caller);
+            break;
+        case NODE_ARRAY_ACCESS:
+            visit_calls(((ArrayAccessNode*)node)->index, caller);
+            break;
+        default:
+            break;
+    }
+}
+
+static void visit_function(FunctionInfo* info) {
+    info->index = info->lowlink = tarjan_counter++;
+    info->on_stack = 1;
+    tarjan_stack[tarjan_top++] = info;
+
+    visit_calls((ASTNode*)info->decl->body, info);
+
+    if (info->lowlink == info->index) {
+        // info 是一个强连通分量的根：弹出整个分量，多于一个函数就都是递归的
+        int first = tarjan_top - 1;
+        while (tarjan_stack[first] != info) first--;
+        for (int i = first; i < tarjan_top; i++) {
+            tarjan_stack[i]->on_stack = 0;
+            if (tarjan_top - first > 1) tarjan_stack[i]->recursive = 1;
+        }
+        tarjan_top = first;
+    }
+    inline_into(info);
+}
+
+int inline_program(ASTNode* root) {
+    if (inline_threshold <= 0) return 0;
+
+    ProgramNode* program = (ProgramNode*)root;
+    build_function_table(program);
+    tarjan_stack = (FunctionInfo**)malloc((function_count > 0 ? function_count : 1) * sizeof(FunctionInfo*));
+    if (!tarjan_stack) out_of_memory();
+    for (int i = 0; i < function_count; i++) {
+        functions[i].size = count_nodes((ASTNode*)functions[i].decl->body);
+    }
+    for (int i = 0; i < function_count; i++) {
+        if (functions[i].index == -1) visit_function(&functions[i]);
+    }
+
+    free(tarjan_stack);
+    free(function_index);
+    free(functions);
+    free(caller_names);
+    free(bindings);
+    tarjan_stack = NULL;
+    function_index = NULL;
+    functions = NULL;
+    caller_names = NULL;
+    bindings = NULL;
+    caller_name_capacity = caller_name_count = 0;
+    binding_capacity = binding_count = 0;
+    return inlined_count;
+}
@@ -0,0 +1,25 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include "ast.h"
+
+// --- 函数内联 (AST 上的 pass，在常量折叠之后、代码生成之前运行) ---
+// 把小的、不递归的函数直接展开到调用点，省掉参数搬运、call/ret 和序言尾声。
+//   * 函数体只有一条 "return 表达式;"、实参又足够简单 (字面量、变量、没有副作用的表达式) 时，
+//     直接把实参代进表达式 (表达式内联)，哪里的调用都可以；
+//   * 否则只内联语句层面的调用 (f(...);  x = f(...);  int x = f(...);  return f(...);)：
+//     形参变成新的局部变量，函数体里的 return E 改成给结果变量赋值 (语句内联)；
+//   * 函数体大小 (AST 节点数) 不超过 inline_threshold * (1 + 循环深度) 才内联 (深度最多按 3 算)，
+//     调用点所在的循环越深，执行得越频繁，允许展开的函数就越大；
+//   * 按调用图自底向上处理，被调函数自己的调用先内联好；调用图里成环 (递归) 的函数不内联。
+// 内联进来的形参就是普通局部变量，之后再跑一遍 fold_program 就能把常量实参传播进去。
+
+// 大小阈值 (AST 节点数)，0 表示关闭内联
+extern int inline_threshold;
+
+// 对整个程序做内联，返回内联了多少个调用点
+int inline_program(ASTNode* root);
+// 把每个调用点的内联决定 (内联了 / 为什么没有内联) 打印到 stderr
+void inline_print_report();
+
+#endif // INLINE_H
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+#include "arena.h"
+
+typedef struct {
+    char* str;      // 驻留的字符串 (NULL 表示空槽位)
+    unsigned hash;
+    int len;
+} Atom;
+
+static Atom* table = NULL;
+static int capacity = 0; // 总是 2 的幂
+static int count = 0;
+
+// 字符串本身放在 arena 里，和整个编译过程同生共死
+static Arena atom_arena;
+
+static unsigned hash_bytes(const char* str, int len) {
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static Atom* find_slot(Atom* slots, int slot_capacity, const char* str, int len, unsigned hash) {
+    unsigned mask = (unsigned)slot_capacity - 1;
+    unsigned i = hash & mask;
+    while (slots[i].str != NULL) {
+        if (slots[i].hash == hash && slots[i].len == len && memcmp(slots[i].str, str, len) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static void grow_table() {
+    int new_capacity = capacity == 0 ? 1024 : capacity * 2;
+    Atom* fresh = (Atom*)calloc(new_capacity, sizeof(Atom));
+    if (!fresh) {
+        fprintf(stderr, "Error: Out of memory (intern table)\n");
+        exit(1);
+    }
+    for (int i = 0; i < capacity; i++) {
+        if (table[i].str != NULL) {
+            *find_slot(fresh, new_capacity, table[i].str, table[i].len, table[i].hash) = table[i];
+        }
+    }
+    free(table);
+    table = fresh;
+    capacity = new_capacity;
+}
+
+char* intern(const char* str, int len) {
+    if ((count + 1) * 4 > capacity * 3) {
+        grow_table();
+    }
+
+    unsigned hash = hash_bytes(str, len);
+    Atom* slot = find_slot(table, capacity, str, len, hash);
+    if (slot->str == NULL) {
+        slot->str = arena_strndup(&atom_arena, str, len);
+        slot->hash = hash;
+        slot->len = len;
+        count++;
+    }
+    return slot->str;
+}
+
+void intern_free() {
+    free(table);
+    table = NULL;
+    capacity = 0;
+    count = 0;
+    arena_free(&atom_arena);
+}
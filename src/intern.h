@@ -0,0 +1,27 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdint.h>
+
+// --- 字符串驻留表 (Intern Table / Atom Table) ---
+// 每个不同的名字在整个编译过程中只存一份。词法分析器遇到标识符
+// (和字符串字面量) 时调用 intern()，之后 parser/codegen 手里的名字都是
+// 驻留过的指针：两个名字相同，当且仅当它们的指针相等。
+// 所以后面的各种查找 (符号表、结构体、字符串池) 都只需要比较指针，不再 strcmp。
+
+// 返回 str[0..len) 的唯一副本 (以 '\0' 结尾)。str 不要求以 '\0' 结尾。
+char* intern(const char* str, int len);
+// 释放所有驻留的字符串 (编译结束时调用)
+void intern_free();
+
+// 驻留过的名字可以直接按指针哈希 (符号表、字符串池、结构体表都用它)
+static inline unsigned hash_atom(const char* atom) {
+    uintptr_t p = (uintptr_t)atom;
+    unsigned h = (unsigned)(p ^ (p >> 32));
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+}
+
+#endif // INTERN_H
@@ -0,0 +1,742 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "arena.h"
+#include "symtab.h"
+#include "strpool.h"
+
+// 所有 IR (函数、块、指令、各种数组) 都从这里分配，ir_free() 一次性释放
+static Arena ir_arena;
+
+void* ir_alloc(size_t size) {
+    void* p = arena_alloc(&ir_arena, size);
+    memset(p, 0, size);
+    return p;
+}
+
+// --- 构建 IR 的工具函数 ---
+
+int ir_new_vreg(IRFunction* fn) {
+    return fn->nvregs++;
+}
+
+BasicBlock* ir_new_block(IRFunction* fn) {
+    BasicBlock* block = (BasicBlock*)ir_alloc(sizeof(BasicBlock));
+    if (fn->nblocks == fn->block_capacity) {
+        int new_capacity = fn->block_capacity == 0 ? 16 : fn->block_capacity * 2;
+        fn->blocks = (BasicBlock**)arena_grow(&ir_arena, fn->blocks, fn->block_capacity,
+                                              new_capacity, sizeof(BasicBlock*));
+        fn->block_capacity = new_capacity;
+    }
+    block->id = fn->nblocks;
+    fn->blocks[fn->nblocks++] = block;
+    return block;
+}
+
+IRInstr* ir_insert(BasicBlock* block, IRInstr* before, IROp op) {
+    IRInstr* instr = (IRInstr*)ir_alloc(sizeof(IRInstr));
+    instr->op = op;
+    instr->dst = instr->a = instr->b = instr->slot = -1;
+
+    instr->next = before;
+    instr->prev = before ? before->prev : block->tail;
+    if (instr->prev) instr->prev->next = instr; else block->head = instr;
+    if (before) before->prev = instr; else block->tail = instr;
+    return instr;
+}
+
+void ir_remove(BasicBlock* block, IRInstr* instr) {
+    if (instr->prev) instr->prev->next = instr->next; else block->head = instr->next;
+    if (instr->next) instr->next->prev = instr->prev; else block->tail = instr->prev;
+}
+
+static void add_pred(BasicBlock* block, BasicBlock* pred) {
+    if (block->npreds == block->pred_capacity) {
+        int new_capacity = block->pred_capacity == 0 ? 4 : block->pred_capacity * 2;
+        block->preds = (BasicBlock**)arena_grow(&ir_arena, block->preds, block->pred_capacity,
+                                                new_capacity, sizeof(BasicBlock*));
+        block->pred_capacity = new_capacity;
+    }
+    block->preds[block->npreds++] = pred;
+}
+
+static int is_terminator(IROp op) {
+    return op == IR_JMP || op == IR_BR || op == IR_RET;
+}
+
+static void mark_reachable(BasicBlock* block, char* reachable) {
+    if (reachable[block->id]) return;
+    reachable[block->id] = 1;
+    for (int i = 0; i < block->nsucc; i++) {
+        mark_reachable(block->succ[i], reachable);
+    }
+}
+
+void ir_rebuild_cfg(IRFunction* fn) {
+    for (int i = 0; i < fn->nblocks; i++) {
+        BasicBlock* block = fn->blocks[i];
+        IRInstr* last = block->tail;
+        block->id = i;
+        block->npreds = 0;
+        block->nsucc = 0;
+        if (last->op == IR_JMP) {
+            block->succ[block->nsucc++] = last->target[0];
+        } else if (last->op == IR_BR) {
+            block->succ[block->nsucc++] = last->target[0];
+            if (last->target[1] != last->target[0]) block->succ[block->nsucc++] = last->target[1];
+        }
+    }
+
+    // 只保留从入口可达的块 (比如 return 后面的代码)
+    char* reachable = (char*)calloc(fn->nblocks, 1);
+    mark_reachable(fn->blocks[0], reachable);
+    int count = 0;
+    for (int i = 0; i < fn->nblocks; i++) {
+        if (reachable[i]) fn->blocks[count++] = fn->blocks[i];
+    }
+    fn->nblocks = count;
+    free(reachable);
+
+    for (int i = 0; i < fn->nblocks; i++) {
+        fn->blocks[i]->id = i;
+    }
+    for (int i = 0; i < fn->nblocks; i++) {
+        BasicBlock* block = fn->blocks[i];
+        for (int j = 0; j < block->nsucc; j++) {
+            add_pred(block->succ[j], block);
+        }
+    }
+}
+
+// --- AST -> IR ---
+
+static IRFunction* fn;          // 正在降低的函数
+static BasicBlock* cur;         // 当前往里追加指令的块
+static BasicBlock* break_target;
+static BasicBlock* continue_target;
+
+static IRInstr* add(IROp op) {
+    // 当前块已经结束 (比如 return 之后又有语句)：后面的代码放进一个新的、不可达的块
+    if (cur->tail && is_terminator(cur->tail->op)) {
+        cur = ir_new_block(fn);
+    }
+    return ir_insert(cur, NULL, op);
+}
+
+static int add_value(IROp op, int a, int b) {
+    IRInstr* instr = add(op);
+    instr->dst = ir_new_vreg(fn);
+    instr->a = a;
+    instr->b = b;
+    return instr->dst;
+}
+
+static int add_const(long value) {
+    IRInstr* instr = add(IR_CONST);
+    instr->dst = ir_new_vreg(fn);
+    instr->imm = value;
+    return instr->dst;
+}
+
+static void add_jump(BasicBlock* target) {
+    IRInstr* instr = add(IR_JMP);
+    instr->target[0] = target;
+}
+
+static void add_branch(int cond, BasicBlock* then_block, BasicBlock* else_block) {
+    IRInstr* instr = add(IR_BR);
+    instr->a = cond;
+    instr->target[0] = then_block;
+    instr->target[1] = else_block;
+}
+
+// 开始往 block 里追加指令；当前块没结束的话先跳过去 (直落)
+static void start_block(BasicBlock* block) {
+    if (!cur->tail || !is_terminator(cur->tail->op)) {
+        add_jump(block);
+    }
+    cur = block;
+}
+
+static int new_slot(char* name, int size, int is_char, int is_scalar) {
+    if (fn->nslots == fn->slot_capacity) {
+        int new_capacity = fn->slot_capacity == 0 ? 16 : fn->slot_capacity * 2;
+        fn->slots = (IRSlot*)arena_grow(&ir_arena, fn->slots, fn->slot_capacity,
+                                        new_capacity, sizeof(IRSlot));
+        fn->slot_capacity = new_capacity;
+    }
+    IRSlot* slot = &fn->slots[fn->nslots];
+    slot->name = name;
+    slot->size = size;
+    slot->is_char = is_char;
+    slot->is_scalar = is_scalar;
+    slot->address_taken = 0;
+    slot->promoted = 0;
+    slot->scope_end = -1;
+    return fn->nslots++;
+}
+
+// 作用域结束：从 first 开始、还没结束的槽位 (这个作用域里声明的) 到这里就都死了
+static void close_scope(int first) {
+    for (int i = first; i < fn->nslots; i++) {
+        if (fn->slots[i].scope_end == -1) fn->slots[i].scope_end = fn->nslots;
+    }
+}
+
+static int lower_expr(ASTNode* node);
+
+// 局部变量对应的槽位，全局变量返回 -1
+static int local_slot(char* name) {
+    Symbol* sym = find_symbol(name);
+    return sym ? sym->slot : -1;
+}
+
+// 计算左值的地址
+static int lower_address(ASTNode* node) {
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            IdentifierNode* ident = (IdentifierNode*)node;
+            int slot = local_slot(ident->name);
+            if (slot == -1) {
+                IRInstr* instr = add(IR_ADDR_GLOBAL);
+                instr->dst = ir_new_vreg(fn);
+                instr->name = ident->name;
+                return instr->dst;
+            }
+            fn->slots[slot].address_taken = 1;
+            IRInstr* instr = add(IR_ADDR_VAR);
+            instr->dst = ir_new_vreg(fn);
+            instr->slot = slot;
+            return instr->dst;
+        }
+        case NODE_ARRAY_ACCESS: {
+            // a[i] 的地址 = &a + i * 8
+            ArrayAccessNode* access = (ArrayAccessNode*)node;
+            int slot = local_slot(access->array_name);
+            if (slot == -1) { fprintf(stderr, "Undefined array %s\n", access->array_name); exit(1); }
+            int index = lower_expr(access->index);
+            int offset = add_value(IR_MUL, index, add_const(8));
+            IRInstr* base = add(IR_ADDR_VAR);
+            base->dst = ir_new_vreg(fn);
+            base->slot = slot;
+            return add_value(IR_ADD, base->dst, offset);
+        }
+        case NODE_MEMBER_ACCESS: {
+            // p.x 的地址 = &p + 成员偏移
+            MemberAccessNode* access = (MemberAccessNode*)node;
+            IRInstr* base = add(IR_ADDR_VAR);
+            base->dst = ir_new_vreg(fn);
+            base->slot = local_slot(access->struct_var_name);
+            if (access->member_offset == 0) return base->dst;
+            return add_value(IR_ADD, base->dst, add_const(access->member_offset));
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            if (unary->op == TOKEN_STAR) {
+                return lower_expr(unary->operand); // *p 的地址就是 p 的值
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    fprintf(stderr, "Error: Left side of assignment must be a variable or pointer dereference.\n");
+    exit(1);
+}
+
+// && 和 ||：结果写进一个临时的局部变量，两条路径在 end 块汇合
+// (mem2reg 之后它会变成一个 phi)
+static int lower_logical(BinaryOpNode* node) {
+    int is_and = node->op == TOKEN_LOGIC_AND;
+    int result = new_slot(is_and ? "and.tmp" : "or.tmp", 8, 0, 1);
+    BasicBlock* rhs_block = ir_new_block(fn);
+    BasicBlock* short_block = ir_new_block(fn);
+    BasicBlock* end_block = ir_new_block(fn);
+
+    int left = lower_expr(node->left);
+    if (is_and) add_branch(left, rhs_block, short_block);
+    else add_branch(left, short_block, rhs_block);
+
+    // 左边没短路：结果就是 (右边 != 0)
+    cur = rhs_block;
+    int right = lower_expr(node->right);
+    int value = add_value(IR_NE, right, add_const(0));
+    IRInstr* store = add(IR_STOREVAR);
+    store->slot = result;
+    store->a = value;
+    add_jump(end_block);
+
+    // 短路：&& 的结果是 0，|| 的结果是 1
+    cur = short_block;
+    value = add_const(is_and ? 0 : 1);
+    store = add(IR_STOREVAR);
+    store->slot = result;
+    store->a = value;
+    add_jump(end_block);
+
+    cur = end_block;
+    IRInstr* load = add(IR_LOADVAR);
+    load->dst = ir_new_vreg(fn);
+    load->slot = result;
+    return load->dst;
+}
+
+static int lower_assign(BinaryOpNode* node) {
+    int value = lower_expr(node->right);
+
+    if (node->left->type == NODE_IDENTIFIER) {
+        int slot = local_slot(((IdentifierNode*)node->left)->name);
+        if (slot != -1) {
+            IRInstr* store = add(IR_STOREVAR);
+            store->slot = slot;
+            store->a = value;
+            return value;
+        }
+    }
+
+    // 只有 char 变量按 1 字节写，数组元素、p.x、*p 都按 8 字节
+    int address = lower_address(node->left);
+    IRInstr* store = add(IR_STORE);
+    store->a = address;
+    store->b = value;
+    return value;
+}
+
+static IROp binary_ir_op(TokenType op) {
+    switch (op) {
+        case TOKEN_PLUS:  return IR_ADD;
+        case TOKEN_MINUS: return IR_SUB;
+        case TOKEN_STAR:  return IR_MUL;
+        case TOKEN_SLASH: return IR_DIV;
+        case TOKEN_EQ:    return IR_EQ;
+        case TOKEN_NEQ:   return IR_NE;
+        case TOKEN_LT:    return IR_LT;
+        case TOKEN_LE:    return IR_LE;
+        case TOKEN_GT:    return IR_GT;
+        case TOKEN_GE:    return IR_GE;
+        default:
+            fprintf(stderr, "Codegen: Unsupported binary operator\n");
+            exit(1);
+    }
+}
+
+static int lower_expr(ASTNode* node) {
+    switch (node->type) {
+        case NODE_NUMERIC_LITERAL:
+            return add_const(strtol(((NumericLiteralNode*)node)->value, NULL, 10));
+        case NODE_STRING_LITERAL: {
+            IRInstr* instr = add(IR_ADDR_STRING);
+            instr->dst = ir_new_vreg(fn);
+            instr->imm = strpool_add(((StringLiteralNode*)node)->value);
+            return instr->dst;
+        }
+        case NODE_IDENTIFIER: {
+            IdentifierNode* ident = (IdentifierNode*)node;
+            int slot = local_slot(ident->name);
+            if (slot == -1) {
+                // 全局变量：暂时假设全局只有 int
+                return add_value(IR_LOAD, lower_address(node), -1);
+            }
+            IRInstr* load = add(IR_LOADVAR);
+            load->dst = ir_new_vreg(fn);
+            load->slot = slot;
+            return load->dst;
+        }
+        case NODE_BINARY_OP: {
+            BinaryOpNode* bin = (BinaryOpNode*)node;
+            if (bin->op == TOKEN_LOGIC_AND || bin->op == TOKEN_LOGIC_OR) return lower_logical(bin);
+            if (bin->op == TOKEN_ASSIGN) return lower_assign(bin);
+            // 和 AST 后端一样先算右边
+            int right = lower_expr(bin->right);
+            int left = lower_expr(bin->left);
+            return add_value(binary_ir_op(bin->op), left, right);
+        }
+        case NODE_UNARY_OP: {
+            UnaryOpNode* unary = (UnaryOpNode*)node;
+            switch (unary->op) {
+                case TOKEN_AMPERSAND: return lower_address(unary->operand);
+                case TOKEN_STAR:      return add_value(IR_LOAD, lower_expr(unary->operand), -1);
+                case TOKEN_MINUS:     return add_value(IR_NEG, lower_expr(unary->operand), -1);
+                case TOKEN_BANG:      return add_value(IR_NOT, lower_expr(unary->operand), -1);
+                case TOKEN_PLUS:      return lower_expr(unary->operand);
+                default:
+                    fprintf(stderr, "Codegen Error: Unknown unary operator\n");
+                    exit(1);
+            }
+        }
+        case NODE_FUNCTION_CALL: {
+            FunctionCallNode* call = (FunctionCallNode*)node;
+            if (call->arg_count > 6) {
+                fprintf(stderr, "Error: Function call to %s has more than 6 arguments.\n", call->name);
+                exit(1);
+            }
+            int* args = (int*)ir_alloc((call->arg_count + 1) * sizeof(int));
+            for (int i = 0; i < call->arg_count; i++) {
+                args[i] = lower_expr(call->args[i]);
+            }
+            IRInstr* instr = add(IR_CALL);
+            instr->dst = ir_new_vreg(fn);
+            instr->name = call->name;
+            instr->args = args;
+            instr->nargs = call->arg_count;
+            return instr->dst;
+        }
+        case NODE_ARRAY_ACCESS:
+        case NODE_MEMBER_ACCESS:
+            return add_value(IR_LOAD, lower_address(node), -1);
+        default:
+            fprintf(stderr, "Codegen Error: Unknown expression node type %d\n", node->type);
+            exit(1);
+    }
+}
+
+static void lower_statement(ASTNode* node);
+
+static void declare_variable(VarDeclNode* var) {
+    int size = var->array_size > 0 ? var->array_size * 8 : 8;
+    int is_scalar = var->array_size == 0 && var->var_type != TYPE_STRUCT;
+    Symbol* sym = symtab_declare(var->name);
+    sym->type = var->var_type;
+    sym->struct_name = var->struct_name;
+    sym->slot = new_slot(var->name, size, var->var_type == TYPE_CHAR, is_scalar);
+}
+
+static void lower_loop(ASTNode* init, ASTNode* cond, ASTNode* inc, ASTNode* body) {
+    BasicBlock* cond_block = ir_new_block(fn);
+    BasicBlock* body_block = ir_new_block(fn);
+    BasicBlock* inc_block = inc ? ir_new_block(fn) : cond_block;
+    BasicBlock* end_block = ir_new_block(fn);
+
+    if (init) lower_statement(init);
+    start_block(cond_block);
+    if (cond) add_branch(lower_expr(cond), body_block, end_block);
+    else add_jump(body_block);
+
+    BasicBlock* old_break = break_target;
+    BasicBlock* old_continue = continue_target;
+    break_target = end_block;
+    continue_target = inc_block; // while 的 continue 回到条件，for 的回到 increment
+
+    cur = body_block;
+    lower_statement(body);
+    if (inc) {
+        start_block(inc_block);
+        lower_expr(inc);
+    }
+    add_jump(cond_block);
+
+    break_target = old_break;
+    continue_target = old_continue;
+    cur = end_block;
+}
+
+static void lower_statement(ASTNode* node) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT: {
+            BlockStatementNode* block = (BlockStatementNode*)node;
+            int first = fn->nslots;
+            symtab_push_scope();
+            for (int i = 0; i < block->count; i++) {
+                lower_statement(block->statements[i]);
+            }
+            symtab_pop_scope();
+            close_scope(first);
+            break;
+        }
+        case NODE_VAR_DECL: {
+            VarDeclNode* var = (VarDeclNode*)node;
+            // 和 AST 后端一样：初始值求完以后，变量才进入作用域
+            int value = var->initial_value ? lower_expr(var->initial_value) : -1;
+            declare_variable(var);
+            if (value != -1) {
+                IRInstr* store = add(IR_STOREVAR);
+                store->slot = find_symbol(var->name)->slot;
+                store->a = value;
+            }
+            break;
+        }
+        case NODE_RETURN_STATEMENT: {
+            int value = lower_expr(((ReturnStatementNode*)node)->argument);
+            IRInstr* ret = add(IR_RET);
+            ret->a = value;
+            break;
+        }
+        case NODE_IF_STATEMENT: {
+            IfStatementNode* stmt = (IfStatementNode*)node;
+            BasicBlock* then_block = ir_new_block(fn);
+            BasicBlock* else_block = stmt->else_branch ? ir_new_block(fn) : NULL;
+            BasicBlock* end_block = ir_new_block(fn);
+
+            add_branch(lower_expr(stmt->condition), then_block, else_block ? else_block : end_block);
+            cur = then_block;
+            lower_statement(stmt->body);
+            if (else_block) {
+                start_block(end_block); // then 的结尾跳到 end
+                cur = else_block;
+                lower_statement(stmt->else_branch);
+            }
+            start_block(end_block);
+            break;
+        }
+        case NODE_WHILE_STATEMENT: {
+            WhileStatementNode* stmt = (WhileStatementNode*)node;
+            lower_loop(NULL, stmt->condition, NULL, stmt->body);
+            break;
+        }
+        case NODE_FOR_STATEMENT: {
+            ForStatementNode* stmt = (ForStatementNode*)node;
+            int first = fn->nslots;
+            symtab_push_scope();
+            lower_loop(stmt->init, stmt->condition, stmt->increment, stmt->body);
+            symtab_pop_scope();
+            close_scope(first);
+            break;
+        }
+        case NODE_BREAK:
+            if (!break_target) {
+                fprintf(stderr, "Error: 'break' outside of loop.\n");
+                exit(1);
+            }
+            add_jump(break_target);
+            break;
+        case NODE_CONTINUE:
+            if (!continue_target) {
+                fprintf(stderr, "Error: 'continue' outside of loop.\n");
+                exit(1);
+            }
+            add_jump(continue_target);
+            break;
+        default:
+            // 表达式语句：求值，结果丢掉
+            lower_expr(node);
+            break;
+    }
+}
+
+static IRFunction* lower_function(FunctionDeclarationNode* node) {
+    fn = (IRFunction*)ir_alloc(sizeof(IRFunction));
+    fn->name = node->name;
+    fn->nparams = node->arg_count;
+    cur = ir_new_block(fn);
+    break_target = continue_target = NULL;
+
+    symtab_reset();
+    symtab_push_scope(); // 参数所在的作用域
+    for (int i = 0; i < node->arg_count; i++) {
+        VarDeclNode* param = (VarDeclNode*)node->args[i];
+        if (i >= 6) {
+            fprintf(stderr, "Error: Function %s has more than 6 parameters.\n", node->name);
+            exit(1);
+        }
+        declare_variable(param);
+        IRInstr* arg = add(IR_ARG);
+        arg->dst = ir_new_vreg(fn);
+        arg->imm = i;
+        IRInstr* store = add(IR_STOREVAR);
+        store->slot = find_symbol(param->name)->slot;
+        store->a = arg->dst;
+    }
+    lower_statement((ASTNode*)node->body);
+    symtab_pop_scope();
+
+    // 函数体走到结尾还没有 return：返回 0
+    if (!cur->tail || !is_terminator(cur->tail->op)) {
+        int zero = add_const(0);
+        IRInstr* ret = add(IR_RET);
+        ret->a = zero;
+    }
+
+    ir_rebuild_cfg(fn);
+    return fn;
+}
+
+IRProgram* ir_lower(ASTNode* root) {
+    ProgramNode* program = (ProgramNode*)root;
+    IRProgram* prog = (IRProgram*)ir_alloc(sizeof(IRProgram));
+    prog->ast = program;
+    prog->funcs = (IRFunction**)ir_alloc((program->count + 1) * sizeof(IRFunction*));
+    for (int i = 0; i < program->count; i++) {
+        ASTNode* child = program->declarations[i];
+        if (child->type == NODE_FUNCTION_DECL) {
+            prog->funcs[prog->nfuncs++] = lower_function((FunctionDeclarationNode*)child);
+        }
+    }
+    return prog;
+}
+
+// --- 尾递归消除 ---
+// 以 "v = call 自己(...); ret v" 结尾的块改成：实参存进参数的槽位，跳回函数体开头，递归变成循环。
+// 入口块只留下开头的 arg/storevar，函数体的其余部分拆到紧跟着的新块 (循环头) 里；
+// 之后 mem2reg 会在循环头给参数插 phi。
+// 函数里有被取过地址的变量、数组或结构体时不做：下一轮会覆盖上一轮还可能被引用的栈帧。
+
+int ir_frame_escapes(IRFunction* fn) {
+    for (int i = 0; i < fn->nslots; i++) {
+        if (fn->slots[i].address_taken || !fn->slots[i].is_scalar) return 1;
+    }
+    return 0;
+}
+
+static int is_self_tail_call(IRFunction* fn, BasicBlock* block) {
+    IRInstr* ret = block->tail;
+    IRInstr* call = ret->prev;
+    return ret->op == IR_RET && call && call->op == IR_CALL && call->dst == ret->a &&
+           call->name == fn->name && call->nargs == fn->nparams;
+}
+
+static void eliminate_tail_recursion(IRFunction* fn) {
+    if (ir_frame_escapes(fn)) return;
+    int found = 0;
+    for (int i = 0; i < fn->nblocks && !found; i++) found = is_self_tail_call(fn, fn->blocks[i]);
+    if (!found) return;
+
+    // 入口块开头：每个参数一对 arg + storevar (见 lower_function)
+    BasicBlock* entry = fn->blocks[0];
+    int param_slot[6];
+    IRInstr* last_param = NULL;
+    IRInstr* in = entry->head;
+    for (int i = 0; i < fn->nparams; i++) {
+        last_param = in->next;
+        param_slot[i] = last_param->slot;
+        in = last_param->next;
+    }
+
+    // 剩下的指令挪进循环头，循环头排在入口块后面 (块的下标就是布局顺序)
+    BasicBlock* body = ir_new_block(fn);
+    memmove(&fn->blocks[2], &fn->blocks[1], (fn->nblocks - 2) * sizeof(BasicBlock*));
+    fn->blocks[1] = body;
+    body->head = in;
+    body->tail = entry->tail;
+    in->prev = NULL;
+    if (last_param) last_param->next = NULL;
+    entry->head = last_param ? entry->head : NULL;
+    entry->tail = last_param;
+    ir_insert(entry, NULL, IR_JMP)->target[0] = body;
+
+    for (int i = 0; i < fn->nblocks; i++) {
+        BasicBlock* block = fn->blocks[i];
+        if (!is_self_tail_call(fn, block)) continue;
+        IRInstr* ret = block->tail;
+        IRInstr* call = ret->prev;
+        // 实参都已经算好放在 vreg 里了，按顺序存进参数槽位不会互相覆盖
+        for (int j = 0; j < call->nargs; j++) {
+            IRInstr* store = ir_insert(block, call, IR_STOREVAR);
+            store->slot = param_slot[j];
+            store->a = call->args[j];
+        }
+        ir_remove(block, call);
+        ir_remove(block, ret);
+        ir_insert(block, NULL, IR_JMP)->target[0] = body;
+    }
+    ir_rebuild_cfg(fn);
+}
+
+void ir_optimize(IRProgram* prog) {
+    for (int i = 0; i < prog->nfuncs; i++) {
+        eliminate_tail_recursion(prog->funcs[i]);
+        ssa_mem2reg(prog->funcs[i]);
+    }
+}
+
+void ir_free() {
+    arena_free(&ir_arena);
+}
+
+// --- 打印 (--dump-ir) ---
+
+static const char* op_name(IROp op) {
+    switch (op) {
+        case IR_CONST: return "const";
+        case IR_COPY: return "copy";
+        case IR_ARG: return "arg";
+        case IR_ADD: return "add";
+        case IR_SUB: return "sub";
+        case IR_MUL: return "mul";
+        case IR_DIV: return "div";
+        case IR_EQ: return "eq";
+        case IR_NE: return "ne";
+        case IR_LT: return "lt";
+        case IR_LE: return "le";
+        case IR_GT: return "gt";
+        case IR_GE: return "ge";
+        case IR_NEG: return "neg";
+        case IR_NOT: return "not";
+        case IR_ZEXT8: return "zext8";
+        case IR_LOAD: return "load";
+        case IR_LOAD8: return "load8";
+        case IR_STORE: return "store";
+        case IR_STORE8: return "store8";
+        case IR_LOADVAR: return "loadvar";
+        case IR_STOREVAR: return "storevar";
+        case IR_ADDR_VAR: return "addr";
+        case IR_ADDR_GLOBAL: return "addr";
+        case IR_ADDR_STRING: return "addr";
+        case IR_CALL: return "call";
+        case IR_JMP: return "jmp";
+        case IR_BR: return "br";
+        case IR_RET: return "ret";
+        case IR_PHI: return "phi";
+    }
+    return "?";
+}
+
+static void dump_instr(IRFunction* f, BasicBlock* block, IRInstr* in) {
+    printf("  ");
+    if (in->dst != -1) printf("v%d = ", in->dst);
+    printf("%s", op_name(in->op));
+    switch (in->op) {
+        case IR_CONST:       printf(" %ld", in->imm); break;
+        case IR_ARG:         printf(" %ld", in->imm); break;
+        case IR_LOADVAR:     printf(" %s.%d", f->slots[in->slot].name, in->slot); break;
+        case IR_STOREVAR:    printf(" %s.%d, v%d", f->slots[in->slot].name, in->slot, in->a); break;
+        case IR_ADDR_VAR:    printf(" %s.%d", f->slots[in->slot].name, in->slot); break;
+        case IR_ADDR_GLOBAL: printf(" @%s", in->name); break;
+        case IR_ADDR_STRING: printf(" .LC%ld", in->imm); break;
+        case IR_CALL:
+            printf(" %s(", in->name);
+            for (int i = 0; i < in->nargs; i++) printf(i ? ", v%d" : "v%d", in->args[i]);
+            printf(")");
+            break;
+        case IR_PHI:
+            for (int i = 0; i < in->nargs; i++) printf(i ? ", [v%d, bb%d]" : " [v%d, bb%d]", in->args[i], block->preds[i]->id);
+            break;
+        case IR_JMP:         printf(" bb%d", in->target[0]->id); break;
+        case IR_BR:          printf(" v%d, bb%d, bb%d", in->a, in->target[0]->id, in->target[1]->id); break;
+        default:
+            if (in->a != -1) printf(" v%d", in->a);
+            if (in->b != -1) printf(", v%d", in->b);
+            break;
+    }
+    printf("\n");
+}
+
+void ir_dump(IRProgram* prog) {
+    for (int i = 0; i < prog->nfuncs; i++) {
+        IRFunction* f = prog->funcs[i];
+        printf("function %s (%d params, %d vregs)\n", f->name, f->nparams, f->nvregs);
+        for (int s = 0; s < f->nslots; s++) {
+            IRSlot* slot = &f->slots[s];
+            if (slot->promoted) continue; // 已经变成 SSA 值了
+            printf("  slot %s.%d: %d bytes%s%s%s\n", slot->name, s, slot->size,
+                   slot->is_char ? ", char" : "",
+                   slot->is_scalar ? "" : ", aggregate",
+                   slot->address_taken ? ", address taken" : "");
+        }
+        for (int b = 0; b < f->nblocks; b++) {
+            BasicBlock* block = f->blocks[b];
+            printf("bb%d:", block->id);
+            if (block->npreds > 0) {
+                printf("  ; preds:");
+                for (int p = 0; p < block->npreds; p++) printf(" bb%d", block->preds[p]->id);
+            }
+            printf("\n");
+            for (IRInstr* in = block->head; in; in = in->next) {
+                dump_instr(f, block, in);
+            }
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,159 @@
+#ifndef IR_H
+#define IR_H
+
+#include "ast.h"
+
+// --- 中间表示 (IR) ---
+// AST 先被降低 (lower) 成线性的三地址码，按基本块 (basic block) 组织，
+// 块之间有显式的后继/前驱边 (控制流图 CFG)。后端 (ir_x86.c) 再把 IR 翻译成 x86-64。
+//
+// 值用虚拟寄存器 (vreg) 表示，编号从 0 开始，数量不限；
+// 局部变量是函数里的 "槽位" (slot)，通过 LOADVAR/STOREVAR 读写，
+// 只有被取地址的、数组和结构体才真的需要内存。
+
+typedef enum {
+    IR_CONST,       // dst = imm
+    IR_COPY,        // dst = a
+    IR_ARG,         // dst = 第 imm 个参数 (只出现在入口块开头)
+    IR_ADD,         // dst = a + b
+    IR_SUB,         // dst = a - b
+    IR_MUL,         // dst = a * b
+    IR_DIV,         // dst = a / b (有符号)
+    IR_EQ,          // dst = a == b (0 或 1，下同)
+    IR_NE,
+    IR_LT,
+    IR_LE,
+    IR_GT,
+    IR_GE,
+    IR_NEG,         // dst = -a
+    IR_NOT,         // dst = !a
+    IR_ZEXT8,       // dst = a & 0xff (写进 char 变量时截断)
+    IR_LOAD,        // dst = *(long*)a
+    IR_LOAD8,       // dst = *(unsigned char*)a
+    IR_STORE,       // *(long*)a = b
+    IR_STORE8,      // *(char*)a = b
+    IR_LOADVAR,     // dst = 局部变量 slot
+    IR_STOREVAR,    // 局部变量 slot = a
+    IR_ADDR_VAR,    // dst = &局部变量 slot
+    IR_ADDR_GLOBAL, // dst = &全局变量 name
+    IR_ADDR_STRING, // dst = &字符串 .LC{imm}
+    IR_CALL,        // dst = name(args...)
+    IR_JMP,         // goto target[0]
+    IR_BR,          // if (a) goto target[0] else goto target[1]
+    IR_RET,         // return a
+    IR_PHI,         // dst = args[i]，i 是实际从哪个前驱 (preds[i]) 进来的 (只在 SSA 形式里出现)
+} IROp;
+
+struct BasicBlock;
+
+typedef struct IRInstr {
+    IROp op;
+    int dst;                    // 结果 vreg，没有结果的指令为 -1
+    int a, b;                   // 操作数 vreg，不用的为 -1
+    long imm;                   // CONST 的值 / ARG 的下标 / ADDR_STRING 的字符串编号
+    int slot;                   // LOADVAR / STOREVAR / ADDR_VAR 的局部变量编号
+    char* name;                 // CALL 的函数名 / ADDR_GLOBAL 的全局变量名
+    int* args;                  // CALL 的参数 / PHI 的输入 (和块的 preds 一一对应)
+    int nargs;
+    struct BasicBlock* target[2]; // JMP / BR 的跳转目标
+    struct IRInstr* prev;
+    struct IRInstr* next;
+} IRInstr;
+
+typedef struct BasicBlock {
+    int id;                     // 在函数里的下标 (也是布局顺序)
+    IRInstr* head;
+    IRInstr* tail;              // 最后一条总是 JMP / BR / RET
+    struct BasicBlock* succ[2];
+    int nsucc;
+    struct BasicBlock** preds;
+    int npreds;
+    int pred_capacity;
+} BasicBlock;
+
+typedef struct {
+    char* name;
+    int size;                   // 字节数
+    int is_char;                // char 变量：读写 1 字节
+    int is_scalar;              // 普通的 int/char 变量 (不是数组或结构体)
+    int address_taken;          // 出现过 &x
+    int promoted;               // 已经被 mem2reg 提升成 SSA 值，不再占栈空间
+    int scope_end;              // 作用域结束时函数里已经有几个槽位 (编号不小于它的槽位可以和它共用栈空间)，
+                                // -1 表示活到函数结尾 (参数)
+} IRSlot;
+
+typedef struct {
+    char* name;
+    int nparams;
+    BasicBlock** blocks;        // blocks[0] 是入口块
+    int nblocks;
+    int block_capacity;
+    IRSlot* slots;
+    int nslots;
+    int slot_capacity;
+    int nvregs;
+} IRFunction;
+
+typedef struct {
+    ProgramNode* ast;           // 全局变量的 .data 段仍然直接从 AST 生成
+    IRFunction** funcs;
+    int nfuncs;
+} IRProgram;
+
+// 把整个程序降低成 IR (每个函数都已经建好 CFG，删掉了不可达的块)
+IRProgram* ir_lower(ASTNode* root);
+// 以文本形式打印 IR (--dump-ir)
+void ir_dump(IRProgram* prog);
+// 把 IR 翻译成 x86-64 汇编，追加到 emitter 缓冲区 (见 emit.h)
+void ir_codegen(IRProgram* prog);
+// 在 IR 上跑优化 pass (-O)：尾递归消除，然后 mem2reg
+void ir_optimize(IRProgram* prog);
+// 释放所有 IR
+void ir_free();
+
+// --- SSA (ssa.c) ---
+// 把没被取过地址的标量局部变量提升成 SSA 值：插入 phi，删掉对应的 loadvar/storevar
+void ssa_mem2reg(IRFunction* fn);
+// 离开 SSA：把 phi 换成前驱里的 copy (必要时拆开关键边)，后端只认识非 SSA 的 IR
+void ssa_destruct(IRFunction* fn);
+
+// --- 寄存器分配 (regalloc.c) ---
+// 分配器可以用的物理寄存器。前 NUM_CALLEE_SAVED 个是被调用者保存的，跨 call 也不会被破坏；
+// 后面的是调用者保存的 (同时也是参数寄存器)。rax/rdx (除法、返回值) 和 r10/r11 (后端的临时寄存器) 不参与分配
+typedef enum {
+    PREG_RBX, PREG_R12, PREG_R13, PREG_R14, PREG_R15,
+    PREG_RDI, PREG_RSI, PREG_RCX, PREG_R8, PREG_R9,
+    NUM_PREGS
+} PhysReg;
+#define NUM_CALLEE_SAVED 5
+#define REG_SPILLED (-1)    // 放在栈上
+#define REG_NONE (-2)       // 这个 vreg 已经不存在了 (被优化掉)
+
+extern const char* preg_names[NUM_PREGS];
+extern const char* preg_names8[NUM_PREGS];
+
+typedef struct {
+    int* reg;                   // 每个 vreg 的 PhysReg，或者 REG_SPILLED / REG_NONE
+    int nspilled;
+    unsigned callee_saved_used; // 用到的被调用者保存寄存器 (第 i 位对应 PhysReg i)
+} RegAllocation;
+
+// 给 (非 SSA 的) fn 做全函数的寄存器分配
+void regalloc(IRFunction* fn, RegAllocation* out);
+void regalloc_free(RegAllocation* alloc);
+
+// --- 给各个 pass 用的工具函数 ---
+// 在 block 里 before 之前 (before 为 NULL 时追加到末尾) 插入一条新指令
+IRInstr* ir_insert(BasicBlock* block, IRInstr* before, IROp op);
+void ir_remove(BasicBlock* block, IRInstr* instr);
+// 分配一个新的 vreg / 基本块 (新块追加在函数末尾)
+int ir_new_vreg(IRFunction* fn);
+BasicBlock* ir_new_block(IRFunction* fn);
+// 函数里有没有被取过地址的变量、数组或结构体 (栈帧里的地址可能被别人拿着，不能做尾调用)
+int ir_frame_escapes(IRFunction* fn);
+// 根据每个块的结尾指令重新计算后继和前驱，删掉从入口不可达的块，重新编号
+void ir_rebuild_cfg(IRFunction* fn);
+// 从 IR 的 arena 里分配内存 (和 IR 一起释放)
+void* ir_alloc(size_t size);
+
+#endif // IR_H
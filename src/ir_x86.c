@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "emit.h"
+#include "codegen.h"
+#include "strpool.h"
+#include "strength.h"
+#include "isel.h"
+
+// --- IR -> x86-64 ---
+// 每个 vreg 要么在寄存器分配 (regalloc.c) 给的寄存器里，要么溢出到栈帧里的一个 8 字节位置。
+// r11 和 r10 是翻译单条指令用的临时寄存器，rax/rdx 留给除法和返回值，它们都不参与分配。
+//
+// 栈帧布局 (k 是用到的被调用者保存寄存器个数，偏移都相对栈帧基址 B):
+//   [B-8k, B)          保存的 rbx / r12-r15
+//   往下               没被提升的局部变量 (数组、结构体、取过地址的)，然后是溢出的 vreg
+// 保留帧指针 (-fno-omit-frame-pointer) 时 B 就是 rbp (旧的 rbp 在 [rbp])；
+// 默认省略帧指针，B 是函数入口处的 rsp，函数体里没有 push，所以一律用 [rsp + 8k + frame_size - N] 访问。
+// 叶子函数 (除了尾调用不调用别的函数) 栈上的东西不超过 128 字节时不 sub rsp，变量直接放在红区里
+
+static const char* arg_regs[6] = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"};
+
+static IRFunction* fn;
+static int func_index;          // 第几个函数，用来让块的标签全局唯一
+static RegAllocation alloc;
+static int* slot_offset;        // 每个局部变量相对基址的偏移 (变量占 [B-N, B-N+size))
+static int* spill_offset;       // 每个溢出的 vreg 的栈位置
+static int saved_regs[NUM_CALLEE_SAVED]; // 要在序言里保存的寄存器 (PhysReg)
+static int saved_count;
+static int frame_size;          // 序言里 sub rsp 的大小
+static int frame_escapes;       // 栈帧里的地址可能被别人拿着 (这时不做尾调用)
+static int frame_bytes;         // 溢出的 vreg 也算上，栈帧一共要多少字节 (不含返回地址和旧的 rbp)
+static int locals_size;         // 没被提升的局部变量占的字节数 (作用域不重叠的共用空间)
+static int locals_unshared;     // 不共用时要占多少字节 (--frame-report 用)
+static IRInstr** const_def;     // vreg 唯一的定义是 const 时指向那条指令，否则 NULL
+static char* const_absorbed;    // 每次使用都被强度削弱吸收成立即数的 const，不用生成
+static char* branch_compare;    // 比较的结果只给紧跟着的 br 用：只生成 cmp，br 直接 jCC，不物化 0/1
+
+// 离基址 offset 字节的位置: "rbp-16"、"rsp+8"
+static const char* frame_addr(int offset) {
+    static char buffers[4][32];
+    static int next = 0;
+    char* buf = buffers[next];
+    next = (next + 1) % 4;
+    if (!omit_frame_pointer) {
+        snprintf(buf, sizeof(buffers[0]), "rbp-%d", offset);
+    } else {
+        int disp = saved_count * 8 + frame_size - offset;
+        if (disp == 0) snprintf(buf, sizeof(buffers[0]), "rsp");
+        else snprintf(buf, sizeof(buffers[0]), "rsp%+d", disp);
+    }
+    return buf;
+}
+
+static int in_reg(int v) {
+    return alloc.reg[v] >= 0;
+}
+
+// vreg v 所在的位置 (可以直接当指令的操作数用)。
+// 结果放在轮换的静态缓冲区里，一条指令里同时用几个也没问题
+static const char* loc(int v) {
+    if (in_reg(v)) return preg_names[alloc.reg[v]];
+    static char buffers[4][32];
+    static int next = 0;
+    char* buf = buffers[next];
+    next = (next + 1) % 4;
+    snprintf(buf, sizeof(buffers[0]), "qword ptr [%s]", frame_addr(spill_offset[v]));
+    return buf;
+}
+
+// 寄存器之间 (或者寄存器和内存之间) 搬一个值，源和目标相同就什么都不做
+static void move(const char* to, const char* from) {
+    if (strcmp(to, from) != 0) emit("  mov %s, %s\n", to, from);
+}
+
+// 读操作数：v 在寄存器里就直接用，否则先读进 scratch
+static const char* value_reg(int v, const char* scratch) {
+    if (in_reg(v)) return loc(v);
+    emit("  mov %s, %s\n", scratch, loc(v));
+    return scratch;
+}
+
+// 写结果的寄存器：dst 在寄存器里就直接写，否则先写进 r11，再由 finish() 存回去
+static const char* result_reg(int v) {
+    return in_reg(v) ? loc(v) : "r11";
+}
+
+static void finish(int v, const char* reg) {
+    if (!in_reg(v)) emit("  mov %s, %s\n", loc(v), reg);
+}
+
+// 调用的结果直接被 return：尾调用，拆掉栈帧以后 jmp 过去 (见 gen_call)
+static int is_tail_call(IRInstr* in) {
+    return in->op == IR_CALL && in->next && in->next->op == IR_RET && in->next->a == in->dst && !frame_escapes;
+}
+
+// 叶子函数：除了尾调用 (jmp 过去，不压返回地址) 以外不调用别的函数，rsp 下面的红区不会被人覆盖
+static int is_leaf() {
+    for (int i = 0; i < fn->nblocks; i++) {
+        for (IRInstr* in = fn->blocks[i]->head; in; in = in->next) {
+            if (in->op == IR_CALL && !is_tail_call(in)) return 0;
+        }
+    }
+    return 1;
+}
+
+static void layout_frame() {
+    saved_count = 0;
+    for (int r = 0; r < NUM_CALLEE_SAVED; r++) {
+        if (alloc.callee_saved_used & (1u << r)) saved_regs[saved_count++] = r;
+    }
+
+    slot_offset = (int*)malloc((fn->nslots + 1) * sizeof(int));
+    spill_offset = (int*)malloc((fn->nvregs + 1) * sizeof(int));
+    if (!slot_offset || !spill_offset) {
+        fprintf(stderr, "Error: Out of memory (IR backend)\n");
+        exit(1);
+    }
+
+    // 槽位按作用域共用栈空间 (和 AST 后端的 scan_locals 一样)：槽位按声明顺序编号、作用域又是嵌套的，
+    // 所以还活着的槽位总是一个栈，新槽位放在栈顶那个的下面，作用域结束的从栈顶退掉
+    int* live = (int*)malloc((fn->nslots + 1) * sizeof(int));
+    if (!live) {
+        fprintf(stderr, "Error: Out of memory (IR backend)\n");
+        exit(1);
+    }
+    int nlive = 0;
+    int offset = saved_count * 8;
+    locals_unshared = 0;
+    for (int i = 0; i < fn->nslots; i++) {
+        if (fn->slots[i].promoted) continue; // 已经是 SSA 值了，不占栈
+        while (nlive > 0 && fn->slots[live[nlive - 1]].scope_end != -1 && fn->slots[live[nlive - 1]].scope_end <= i) {
+            nlive--;
+        }
+        int size = (fn->slots[i].size + 7) / 8 * 8;
+        slot_offset[i] = (nlive > 0 ? slot_offset[live[nlive - 1]] : saved_count * 8) + size;
+        live[nlive++] = i;
+        locals_unshared += size;
+        if (slot_offset[i] > offset) offset = slot_offset[i];
+    }
+    free(live);
+    locals_size = offset - saved_count * 8;
+    for (int v = 0; v < fn->nvregs; v++) {
+        if (alloc.reg[v] != REG_SPILLED) continue;
+        offset += 8;
+        spill_offset[v] = offset;
+    }
+    frame_bytes = offset;
+    if (!omit_frame_pointer) {
+        // 返回地址 + rbp 正好 16 字节，所以保存的寄存器加上 sub rsp 的部分要是 16 的倍数
+        frame_size = (offset + 15) / 16 * 16 - saved_count * 8;
+    } else if (is_leaf() && offset - saved_count * 8 <= 128) {
+        frame_size = 0; // 红区
+    } else {
+        // 没有 push rbp：保存的寄存器加上 sub rsp 的部分要 ≡ 8 (mod 16)，和返回地址凑成 16 的倍数
+        frame_size = (offset + 8 + 15) / 16 * 16 - 8 - saved_count * 8;
+    }
+}
+
+static IRInstr* constant_of(int v) {
+    return v != -1 ? const_def[v] : NULL;
+}
+
+// 返回被当成立即数吸收进这条指令的 const vreg (c 是它的值)，没有返回 -1：
+//   乘除常数换成移位 / lea / 魔数乘法 (strength.c)；
+//   加减、比较的 32 位立即数直接写进指令 (lea / add / cmp)
+static int absorbed_constant(IRInstr* in, long* c) {
+    IRInstr* a = constant_of(in->a);
+    IRInstr* b = constant_of(in->b);
+    int absorbed = -1;
+    switch (in->op) {
+        case IR_MUL:
+            if (b && can_mul_by_constant(b->imm)) absorbed = in->b;
+            else if (a && can_mul_by_constant(a->imm)) absorbed = in->a;
+            break;
+        case IR_DIV:
+            if (b && can_div_by_constant(b->imm)) absorbed = in->b;
+            break;
+        case IR_ADD:
+            if (b && fits_imm32(b->imm)) absorbed = in->b;
+            else if (a && fits_imm32(a->imm)) absorbed = in->a;
+            break;
+        case IR_SUB:
+            if (b && fits_imm32(b->imm) && b->imm != -2147483648L) absorbed = in->b;
+            break;
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            if (b && fits_imm32(b->imm)) absorbed = in->b;
+            break;
+        default:
+            break;
+    }
+    if (absorbed != -1) *c = const_def[absorbed]->imm;
+    return absorbed;
+}
+
+static void count_use(int v, int* uses) {
+    uses[v]++;
+}
+
+static int is_compare(IROp op) {
+    return op == IR_EQ || op == IR_NE || op == IR_LT || op == IR_LE || op == IR_GT || op == IR_GE;
+}
+
+// 找出只定义一次的 const，以及所有使用都被吸收掉的那些；
+// 顺便找出只被紧跟着的 br 用到的比较 (中间没有别的指令，flags 还在)
+static void find_constants() {
+    int n = fn->nvregs + 1;
+    int* defs = (int*)calloc(n, sizeof(int));
+    int* uses = (int*)calloc(n, sizeof(int));
+    int* absorbed = (int*)calloc(n, sizeof(int));
+    const_def = (IRInstr**)calloc(n, sizeof(IRInstr*));
+    const_absorbed = (char*)calloc(n, 1);
+    branch_compare = (char*)calloc(n, 1);
+    if (!defs || !uses || !absorbed || !const_def || !const_absorbed || !branch_compare) {
+        fprintf(stderr, "Error: Out of memory (IR backend)\n");
+        exit(1);
+    }
+
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (in->dst == -1) continue;
+            defs[in->dst]++;
+            if (in->op == IR_CONST) const_def[in->dst] = in;
+        }
+    }
+    for (int v = 0; v < fn->nvregs; v++) {
+        if (defs[v] != 1) const_def[v] = NULL; // 消除 SSA 以后 phi 的结果会有多个定义
+    }
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (in->a != -1) count_use(in->a, uses);
+            if (in->b != -1) count_use(in->b, uses);
+            for (int i = 0; i < in->nargs; i++) count_use(in->args[i], uses);
+            long c;
+            int v = absorbed_constant(in, &c);
+            if (v != -1) absorbed[v]++;
+        }
+    }
+    for (int v = 0; v < fn->nvregs; v++) {
+        const_absorbed[v] = const_def[v] && uses[v] > 0 && uses[v] == absorbed[v];
+    }
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (is_compare(in->op) && in->next && in->next->op == IR_BR && in->next->a == in->dst &&
+                defs[in->dst] == 1 && uses[in->dst] == 1) {
+                branch_compare[in->dst] = 1;
+            }
+        }
+    }
+    free(defs);
+    free(uses);
+    free(absorbed);
+}
+
+// 带常数操作数的加减乘除，生成了就返回 1
+static int gen_with_constant(IRInstr* in) {
+    long c;
+    int constant = absorbed_constant(in, &c);
+    if (constant == -1) return 0;
+
+    int operand = constant == in->b ? in->a : in->b;
+    if (in->op == IR_ADD || in->op == IR_SUB) {
+        // 结果和操作数不在同一个寄存器时用三操作数的 lea
+        const char* r = result_reg(in->dst);
+        const char* src = in_reg(operand) ? loc(operand) : r;
+        if (!in_reg(operand)) move(r, loc(operand));
+        emit_add_constant(r, src, in->op == IR_ADD ? c : -c);
+        finish(in->dst, r);
+    } else if (in->op == IR_MUL) {
+        const char* r = result_reg(in->dst);
+        move(r, loc(operand));
+        emit_mul_by_constant(r, c);
+        finish(in->dst, r);
+    } else if (!div_needs_magic(c)) {
+        const char* r = result_reg(in->dst);
+        move(r, loc(operand));
+        emit_div_by_pow2(r, c, strcmp(r, "r11") == 0 ? "r10" : "r11");
+        finish(in->dst, r);
+    } else {
+        // rax / rdx 不参与分配，可以直接用
+        emit_div_by_magic(value_reg(operand, "r11"), c);
+        move(loc(in->dst), "rdx");
+    }
+    return 1;
+}
+
+static void emit_label(BasicBlock* block) {
+    emit(".LB%d_%d:\n", func_index, block->id);
+}
+
+// 跳到 target；target 紧跟在 block 后面时直接落下去
+static void emit_jump(BasicBlock* block, BasicBlock* target) {
+    if (target->id != block->id + 1) {
+        emit("  jmp .LB%d_%d\n", func_index, target->id);
+    }
+}
+
+// 比较成立时的条件码 (setCC / jCC 的后缀)
+static const char* condition_code(IROp op) {
+    switch (op) {
+        case IR_EQ: return "e";
+        case IR_NE: return "ne";
+        case IR_LT: return "l";
+        case IR_LE: return "le";
+        case IR_GT: return "g";
+        default:    return "ge";
+    }
+}
+
+// 比较不成立时的条件码
+static const char* inverse_condition_code(IROp op) {
+    switch (op) {
+        case IR_EQ: return "ne";
+        case IR_NE: return "e";
+        case IR_LT: return "ge";
+        case IR_LE: return "g";
+        case IR_GT: return "le";
+        default:    return "l";
+    }
+}
+
+// 入口块里的 ARG：参数寄存器整体搬到各自分到的位置
+static void gen_params(BasicBlock* entry) {
+    const char* from[6];
+    const char* to[6];
+    int moves = 0;
+    // ARG 不一定连在一起：mem2reg 会在 char 参数的 ARG 后面插一条 zext8，所以整个入口块都要找
+    for (IRInstr* in = entry->head; in; in = in->next) {
+        if (in->op != IR_ARG) continue;
+        if (!in_reg(in->dst)) {
+            // 先存进栈里的，这时参数寄存器还没被覆盖
+            emit("  mov %s, %s\n", loc(in->dst), arg_regs[in->imm]);
+        } else {
+            from[moves] = arg_regs[in->imm];
+            to[moves] = loc(in->dst);
+            moves++;
+        }
+    }
+    emit_parallel_move(from, to, moves);
+}
+
+// 恢复被调用者保存的寄存器，拆掉栈帧 (ret 或者尾调用的 jmp 之前)
+static void gen_frame_teardown() {
+    if (omit_frame_pointer) {
+        if (frame_size > 0) emit("  add rsp, %d\n", frame_size);
+        for (int i = saved_count - 1; i >= 0; i--) {
+            emit("  pop %s\n", preg_names[saved_regs[i]]);
+        }
+        return;
+    }
+    if (saved_count > 0) {
+        if (frame_size > 0) emit("  lea rsp, [rbp-%d]\n", saved_count * 8);
+        for (int i = saved_count - 1; i >= 0; i--) {
+            emit("  pop %s\n", preg_names[saved_regs[i]]);
+        }
+    } else if (frame_size > 0) {
+        emit("  mov rsp, rbp\n");
+    }
+    emit("  pop rbp\n");
+}
+
+static void gen_call(IRInstr* in) {
+    // 在寄存器里的参数用并行赋值搬，之后才从栈里读溢出的参数 (这时已经没人要读参数寄存器了)
+    const char* from[6];
+    const char* to[6];
+    int moves = 0;
+    for (int i = 0; i < in->nargs; i++) {
+        if (in_reg(in->args[i])) {
+            from[moves] = loc(in->args[i]);
+            to[moves] = arg_regs[i];
+            moves++;
+        }
+    }
+    emit_parallel_move(from, to, moves);
+    for (int i = 0; i < in->nargs; i++) {
+        if (!in_reg(in->args[i])) emit("  mov %s, %s\n", arg_regs[i], loc(in->args[i]));
+    }
+
+    if (is_tail_call(in)) {
+        // 被调函数的 ret 直接回到我们的调用者，后面的 ret 不用生成了
+        gen_frame_teardown();
+        emit("  xor eax, eax\n");
+        emit("  jmp %s\n", in->name);
+        return;
+    }
+    // 序言之后 rsp 就是 16 字节对齐的，函数体里没有 push
+    emit("  xor eax, eax\n"); // 变长参数函数 (printf) 需要 al = 向量寄存器个数
+    emit("  call %s\n", in->name);
+    move(loc(in->dst), "rax");
+}
+
+static void gen_epilogue() {
+    gen_frame_teardown();
+    emit("  ret\n");
+}
+
+static void gen_instr(BasicBlock* block, IRInstr* in) {
+    switch (in->op) {
+        case IR_CONST:
+            if (const_absorbed[in->dst]) break; // 已经作为立即数写进用到它的指令里了
+            if (in_reg(in->dst)) {
+                emit_load_constant(loc(in->dst), in->imm);
+            } else if (fits_imm32(in->imm)) {
+                emit("  mov %s, %ld\n", loc(in->dst), in->imm);
+            } else {
+                emit("  mov r11, %ld\n", in->imm);
+                finish(in->dst, "r11");
+            }
+            break;
+        case IR_COPY:
+            if (in_reg(in->dst) || in_reg(in->a)) {
+                move(loc(in->dst), loc(in->a));
+            } else {
+                emit("  mov r11, %s\n", loc(in->a));
+                finish(in->dst, "r11");
+            }
+            break;
+        case IR_ARG:
+            break; // 已经在 gen_params 里一起处理了
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL: {
+            if (gen_with_constant(in)) break;
+            const char* op = in->op == IR_ADD ? "add" : in->op == IR_SUB ? "sub" : "imul";
+            if (in->op != IR_SUB && in_reg(in->b) && in_reg(in->dst) && alloc.reg[in->b] == alloc.reg[in->dst]) {
+                int t = in->a; in->a = in->b; in->b = t; // 加法和乘法可交换：直接累加到 dst 上
+            }
+            const char* r = result_reg(in->dst);
+            // dst 和 b 分到了同一个寄存器：先写 dst 会把 b 覆盖掉
+            if (in_reg(in->b) && in->a != in->b && alloc.reg[in->b] == alloc.reg[in->dst]) r = "r11";
+            move(r, loc(in->a));
+            emit("  %s %s, %s\n", op, r, loc(in->b));
+            if (strcmp(r, "r11") == 0) move(loc(in->dst), "r11");
+            break;
+        }
+        case IR_DIV:
+            if (gen_with_constant(in)) break;
+            move("rax", loc(in->a));
+            emit("  cqo\n");
+            emit("  idiv %s\n", loc(in->b));
+            move(loc(in->dst), "rax");
+            break;
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE: {
+            long c;
+            if (absorbed_constant(in, &c) != -1) {
+                // a 在内存里也可以直接比较：cmp qword ptr [rbp-N], imm
+                if (c == 0) emit_test_zero(loc(in->a));
+                else emit("  cmp %s, %ld\n", loc(in->a), c);
+            } else if (in_reg(in->a) || in_reg(in->b)) {
+                emit("  cmp %s, %s\n", loc(in->a), loc(in->b));
+            } else {
+                emit("  mov r11, %s\n", loc(in->a));
+                emit("  cmp r11, %s\n", loc(in->b));
+            }
+            if (branch_compare[in->dst]) break; // 后面的 br 直接按 flags 跳
+            const char* r = result_reg(in->dst);
+            const char* r8 = in_reg(in->dst) ? preg_names8[alloc.reg[in->dst]] : "r11b";
+            emit("  set%s %s\n", condition_code(in->op), r8);
+            emit("  movzx %s, %s\n", r, r8);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_NEG: {
+            const char* r = result_reg(in->dst);
+            move(r, loc(in->a));
+            emit("  neg %s\n", r);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_NOT: {
+            emit_test_zero(loc(in->a));
+            const char* r = result_reg(in->dst);
+            const char* r8 = in_reg(in->dst) ? preg_names8[alloc.reg[in->dst]] : "r11b";
+            emit("  sete %s\n", r8);
+            emit("  movzx %s, %s\n", r, r8);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_ZEXT8: {
+            const char* src8 = "r11b";
+            if (in_reg(in->a)) src8 = preg_names8[alloc.reg[in->a]];
+            else emit("  mov r11, %s\n", loc(in->a));
+            const char* r = result_reg(in->dst);
+            emit("  movzx %s, %s\n", r, src8);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_LOAD:
+        case IR_LOAD8: {
+            const char* address = value_reg(in->a, "r11");
+            const char* r = result_reg(in->dst);
+            if (in->op == IR_LOAD8) emit("  movzx %s, byte ptr [%s]\n", r, address);
+            else emit("  mov %s, [%s]\n", r, address);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_STORE:
+        case IR_STORE8: {
+            const char* address = value_reg(in->a, "r11");
+            if (in->op == IR_STORE8) {
+                const char* value8 = "r10b";
+                if (in_reg(in->b)) value8 = preg_names8[alloc.reg[in->b]];
+                else emit("  mov r10, %s\n", loc(in->b));
+                emit("  mov byte ptr [%s], %s\n", address, value8);
+            } else {
+                emit("  mov [%s], %s\n", address, value_reg(in->b, "r10"));
+            }
+            break;
+        }
+        case IR_LOADVAR: {
+            const char* r = result_reg(in->dst);
+            if (fn->slots[in->slot].is_char) {
+                emit("  movzx %s, byte ptr [%s]\n", r, frame_addr(slot_offset[in->slot]));
+            } else {
+                emit("  mov %s, [%s]\n", r, frame_addr(slot_offset[in->slot]));
+            }
+            finish(in->dst, r);
+            break;
+        }
+        case IR_STOREVAR:
+            if (fn->slots[in->slot].is_char) {
+                const char* value8 = "r11b";
+                if (in_reg(in->a)) value8 = preg_names8[alloc.reg[in->a]];
+                else emit("  mov r11, %s\n", loc(in->a));
+                emit("  mov byte ptr [%s], %s\n", frame_addr(slot_offset[in->slot]), value8);
+            } else {
+                emit("  mov [%s], %s\n", frame_addr(slot_offset[in->slot]), value_reg(in->a, "r11"));
+            }
+            break;
+        case IR_ADDR_VAR: {
+            const char* r = result_reg(in->dst);
+            emit("  lea %s, [%s]\n", r, frame_addr(slot_offset[in->slot]));
+            finish(in->dst, r);
+            break;
+        }
+        case IR_ADDR_GLOBAL: {
+            const char* r = result_reg(in->dst);
+            emit("  lea %s, [rip + %s]\n", r, in->name);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_ADDR_STRING: {
+            const char* r = result_reg(in->dst);
+            emit("  lea %s, [rip + .LC%ld]\n", r, in->imm);
+            finish(in->dst, r);
+            break;
+        }
+        case IR_CALL:
+            gen_call(in);
+            break;
+        case IR_JMP:
+            emit_jump(block, in->target[0]);
+            break;
+        case IR_BR: {
+            // 条件是紧挨着的比较时 flags 已经设好了，否则按 0 / 非 0 跳
+            const char* when_true = "ne";
+            const char* when_false = "e";
+            if (branch_compare[in->a]) {
+                when_true = condition_code(in->prev->op);
+                when_false = inverse_condition_code(in->prev->op);
+            } else {
+                emit_test_zero(loc(in->a));
+            }
+            if (in->target[0]->id == block->id + 1) {
+                emit("  j%s .LB%d_%d\n", when_false, func_index, in->target[1]->id);
+            } else {
+                emit("  j%s .LB%d_%d\n", when_true, func_index, in->target[0]->id);
+                emit_jump(block, in->target[1]);
+            }
+            break;
+        }
+        case IR_RET:
+            if (in->prev && is_tail_call(in->prev)) break; // 尾调用已经 jmp 走了
+            // 每个 return 自己带一份收尾 (epilogue)
+            move("rax", loc(in->a));
+            gen_epilogue();
+            break;
+        case IR_PHI:
+            fprintf(stderr, "IR Error: phi reached the backend (missing ssa_destruct)\n");
+            exit(1);
+    }
+}
+
+static void gen_function(IRFunction* f) {
+    ssa_destruct(f);
+    fn = f;
+    regalloc(fn, &alloc);
+    frame_escapes = ir_frame_escapes(fn);
+    layout_frame();
+    find_constants();
+
+    if (frame_report) {
+        int frame = saved_count * 8 + frame_size;
+        if (!omit_frame_pointer) frame += 8;
+        else if (frame_bytes > frame) frame = frame_bytes; // 红区
+        print_frame_report(fn->name, locals_unshared, locals_size, frame);
+    }
+
+    emit("%s:\n", fn->name);
+    if (!omit_frame_pointer) {
+        emit("  push rbp\n");
+        emit("  mov rbp, rsp\n");
+    }
+    for (int i = 0; i < saved_count; i++) {
+        emit("  push %s\n", preg_names[saved_regs[i]]);
+    }
+    if (frame_size > 0) emit("  sub rsp, %d\n", frame_size);
+    gen_params(fn->blocks[0]);
+
+    for (int i = 0; i < fn->nblocks; i++) {
+        BasicBlock* block = fn->blocks[i];
+        if (block->npreds > 0) emit_label(block);
+        for (IRInstr* in = block->head; in; in = in->next) {
+            gen_instr(block, in);
+        }
+    }
+
+    free(slot_offset);
+    free(spill_offset);
+    free(const_def);
+    free(const_absorbed);
+    free(branch_compare);
+    regalloc_free(&alloc);
+}
+
+void ir_codegen(IRProgram* prog) {
+    codegen_globals(prog->ast);
+
+    emit(".text\n");
+    emit(".globl main\n");
+    emit("\n");
+    for (func_index = 0; func_index < prog->nfuncs; func_index++) {
+        gen_function(prog->funcs[func_index]);
+    }
+
+    strpool_emit();
+    strpool_free();
+}
@@ -0,0 +1,96 @@
+#include <string.h>
+#include "isel.h"
+#include "emit.h"
+
+static const char* names64[] = {
+    "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+static const char* names32[] = {
+    "eax", "ebx", "ecx", "edx", "esi", "edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d",
+};
+
+int fits_imm32(long value) {
+    return value >= -2147483648L && value <= 2147483647L;
+}
+
+const char* reg32_name(const char* reg) {
+    for (int i = 0; i < (int)(sizeof(names64) / sizeof(names64[0])); i++) {
+        if (strcmp(reg, names64[i]) == 0) return names32[i];
+    }
+    return NULL;
+}
+
+static int is_register(const char* operand) {
+    return reg32_name(operand) != NULL;
+}
+
+void emit_load_constant(const char* reg, long value) {
+    if (value == 0) {
+        emit("  xor %s, %s\n", reg32_name(reg), reg32_name(reg));
+    } else if (value > 0 && value <= 4294967295L) {
+        emit("  mov %s, %ld\n", reg32_name(reg), value); // 高 32 位自动清零
+    } else {
+        emit("  mov %s, %ld\n", reg, value);
+    }
+}
+
+void emit_add_constant(const char* dst, const char* src, long value) {
+    if (strcmp(dst, src) != 0) {
+        if (value == 0) {
+            emit("  mov %s, %s\n", dst, src);
+        } else if (value < 0) {
+            emit("  lea %s, [%s-%ld]\n", dst, src, -value);
+        } else {
+            emit("  lea %s, [%s+%ld]\n", dst, src, value);
+        }
+        return;
+    }
+    emit_add_to_memory(dst, value); // 寄存器和内存的写法一样
+}
+
+void emit_add_to_memory(const char* memory, long value) {
+    if (value == 1) emit("  inc %s\n", memory);
+    else if (value == -1) emit("  dec %s\n", memory);
+    else if (value < 0 && value != -2147483648L) emit("  sub %s, %ld\n", memory, -value);
+    else if (value != 0) emit("  add %s, %ld\n", memory, value);
+}
+
+void emit_test_zero(const char* operand) {
+    if (is_register(operand)) {
+        emit("  test %s, %s\n", operand, operand);
+    } else {
+        emit("  cmp %s, 0\n", operand);
+    }
+}
+
+// 先搬目标不再被别人读的；只剩环的时候用 xchg 拆开
+void emit_parallel_move(const char** from, const char** to, int n) {
+    for (;;) {
+        int progress = 0, pending = 0;
+        for (int i = 0; i < n; i++) {
+            if (strcmp(from[i], to[i]) == 0) continue;
+            pending++;
+            int blocked = 0;
+            for (int j = 0; j < n; j++) {
+                if (j != i && strcmp(from[j], to[j]) != 0 && strcmp(from[j], to[i]) == 0) { blocked = 1; break; }
+            }
+            if (!blocked) {
+                emit("  mov %s, %s\n", to[i], from[i]);
+                from[i] = to[i];
+                progress = 1;
+            }
+        }
+        if (pending == 0) return;
+        if (progress) continue;
+        // 全都在环上：交换一对，环就缩短一个
+        for (int i = 0; i < n; i++) {
+            if (strcmp(from[i], to[i]) == 0) continue;
+            emit("  xchg %s, %s\n", to[i], from[i]);
+            for (int j = 0; j < n; j++) {
+                if (j != i && strcmp(from[j], to[i]) == 0) from[j] = from[i];
+            }
+            from[i] = to[i];
+            break;
+        }
+    }
+}
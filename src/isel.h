@@ -0,0 +1,28 @@
+#ifndef ISEL_H
+#define ISEL_H
+
+// --- 指令选择的小工具 (两个后端共用) ---
+// 同样的操作挑编码更短的指令：
+//   mov rax, 0  -> xor eax, eax      (2 字节，还能打破依赖)
+//   mov rax, 5  -> mov eax, 5        (写 32 位寄存器会把高 32 位清零)
+//   cmp rax, 0  -> test rax, rax
+//   rcx = rax + 8 -> lea rcx, [rax+8]  (三操作数，不用先 mov)
+// 寄存器都用 64 位的名字传进来 ("rax"、"r12")。
+
+// 立即数能不能直接写进指令 (有符号 32 位)
+int fits_imm32(long value);
+// 64 位寄存器对应的 32 位名字 ("rax" -> "eax"，"r8" -> "r8d")
+const char* reg32_name(const char* reg);
+
+// reg = value。value 为 0 时用 xor，会改写标志位
+void emit_load_constant(const char* reg, long value);
+// dst = src + value (value 是 32 位立即数)。dst 是寄存器，src 是寄存器或者就是 dst
+void emit_add_constant(const char* dst, const char* src, long value);
+// 内存里的值原地加上 value (32 位立即数)：inc / dec / add qword ptr [...]
+void emit_add_to_memory(const char* memory, long value);
+// 按 operand 是否为 0 设置标志位 (之后跟 je / jne / sete)
+void emit_test_zero(const char* operand);
+// 把 n 个值同时从寄存器 from[i] 搬到寄存器 to[i] (并行赋值，to 互不相同，from 可以重复)
+void emit_parallel_move(const char** from, const char** to, int n);
+
+#endif // ISEL_H
@@ -1,293 +1,366 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 #include "lexer.h"
+#include "intern.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // --- 从 main.c 移动过来的 ---
 
 // 全局变量，用于指向当前正在分析的源代码位置
 static char* source_code; // 使用 static 使其成为文件内私有变量
 static int current_pos = 0;
+static int source_length = 0; // 源码长度：SIMD 扫描只在剩余字节足够一整块时进行，绝不越界读
+
+// -----------
+// 字符类别表
+// -----------
+// 256 项的查找表，每个字节一个位掩码。用一次查表代替 isspace/isalnum 这类 libc 调用
+// (它们还要查 locale)。
+enum {
+    CHAR_SPACE       = 1 << 0, // ' ', \t, \n, \v, \f, \r
+    CHAR_DIGIT       = 1 << 1, // 0-9
+    CHAR_IDENT_START = 1 << 2, // a-z, A-Z, _
+    CHAR_IDENT       = 1 << 3, // 标识符中间可以出现的字符: 字母、数字、下划线
+};
+
+static unsigned char char_class[256];
+
+static void init_char_class() {
+    static int initialized = 0;
+    if (initialized) return;
+    initialized = 1;
+
+    const char* spaces = " \t\n\v\f\r";
+    for (const char* p = spaces; *p; p++) char_class[(unsigned char)*p] |= CHAR_SPACE;
+    for (int c = '0'; c <= '9'; c++) char_class[c] |= CHAR_DIGIT | CHAR_IDENT;
+    for (int c = 'a'; c <= 'z'; c++) char_class[c] |= CHAR_IDENT_START | CHAR_IDENT;
+    for (int c = 'A'; c <= 'Z'; c++) char_class[c] |= CHAR_IDENT_START | CHAR_IDENT;
+    char_class['_'] |= CHAR_IDENT_START | CHAR_IDENT;
+}
 
-Token* create_token(TokenType type, char* value) {
-    Token* token = (Token*)malloc(sizeof(Token));
-    token->type = type;
-    token->value = value;
-    return token;
+#define CHAR_IS(c, cls) (char_class[(unsigned char)(c)] & (cls))
+
+// -----------
+// 块扫描 (SIMD)
+// -----------
+// 下面三个 scan_* 函数都从 pos 开始，返回第一个 "不属于该类别" 的字符位置。
+// 有 AVX2 时一次看 32 字节，有 SSE2 时一次看 16 字节 (x86-64 上总是有)，
+// 否则以及在缓冲区末尾不足一块时，退回逐字节的标量循环。
+
+#if defined(__AVX2__)
+typedef __m256i simd_block;
+#define SIMD_WIDTH 32
+#define simd_load(p)        _mm256_loadu_si256((const __m256i*)(p))
+#define simd_splat(c)       _mm256_set1_epi8((char)(c))
+#define simd_eq(a, b)       _mm256_cmpeq_epi8(a, b)
+#define simd_or(a, b)       _mm256_or_si256(a, b)
+#define simd_sub(a, b)      _mm256_sub_epi8(a, b)
+#define simd_min_u8(a, b)   _mm256_min_epu8(a, b)
+#define simd_mask(a)        ((unsigned)_mm256_movemask_epi8(a))
+#elif defined(__SSE2__)
+typedef __m128i simd_block;
+#define SIMD_WIDTH 16
+#define simd_load(p)        _mm_loadu_si128((const __m128i*)(p))
+#define simd_splat(c)       _mm_set1_epi8((char)(c))
+#define simd_eq(a, b)       _mm_cmpeq_epi8(a, b)
+#define simd_or(a, b)       _mm_or_si128(a, b)
+#define simd_sub(a, b)      _mm_sub_epi8(a, b)
+#define simd_min_u8(a, b)   _mm_min_epu8(a, b)
+#define simd_mask(a)        ((unsigned)_mm_movemask_epi8(a))
+#endif
+
+#ifdef SIMD_WIDTH
+// 无符号范围判断 lo <= c <= hi：(c - lo) 按无符号看 <= (hi - lo)
+static inline simd_block simd_in_range(simd_block v, char lo, char hi) {
+    simd_block shifted = simd_sub(v, simd_splat(lo));
+    return simd_eq(simd_min_u8(shifted, simd_splat(hi - lo)), shifted);
 }
 
-// 初始化词法分析器
-void lexer_init(char* source) {
-    source_code = source;
-    current_pos = 0;
+// 每一位对应一个字节：1 表示该字节是空白符
+static inline unsigned simd_space_mask(simd_block v) {
+    // \t \n \v \f \r 正好是 9..13 的连续区间
+    return simd_mask(simd_or(simd_eq(v, simd_splat(' ')), simd_in_range(v, '\t', '\r')));
 }
 
-Token* get_next_token() {
-    // 这部分代码和你写的一样，直接从你之前的 main.c 复制过来即可
-    if (source_code[current_pos] == '\0') {
-        return create_token(TOKEN_EOF, "");
-    }
-    // 跳过空白符
-    while(isspace(source_code[current_pos])){
-        current_pos++;
-    }
+// 每一位对应一个字节：1 表示该字节可以出现在标识符中
+static inline unsigned simd_ident_mask(simd_block v) {
+    simd_block lower = simd_or(v, simd_splat(0x20)); // 大写字母 | 0x20 就是小写字母
+    simd_block alpha = simd_in_range(lower, 'a', 'z');
+    simd_block digit = simd_in_range(v, '0', '9');
+    simd_block under = simd_eq(v, simd_splat('_'));
+    return simd_mask(simd_or(simd_or(alpha, digit), under));
+}
 
+#define SIMD_ALL_ONES ((unsigned)((1ULL << SIMD_WIDTH) - 1))
+#endif
 
+// 绝大多数空白只有一两个字符 (一个空格、一个换行)，标识符也大多很短。
+// 先用标量代码看这么多字节，只有长的连续区段 (缩进、长名字) 才值得启动块扫描。
+#define SCALAR_PREFIX 8
 
-    if (source_code[current_pos] == '\0') {
-        return create_token(TOKEN_EOF, "");
+// 跳过空白符
+static int scan_whitespace(int pos) {
+    for (int i = 0; i < SCALAR_PREFIX; i++, pos++) {
+        if (!CHAR_IS(source_code[pos], CHAR_SPACE)) return pos;
     }
-
-    if (source_code[current_pos] == '{') {
-        current_pos++;
-        return create_token(TOKEN_LBRACE, "{");
+#ifdef SIMD_WIDTH
+    while (pos + SIMD_WIDTH <= source_length) {
+        unsigned other = ~simd_space_mask(simd_load(source_code + pos)) & SIMD_ALL_ONES;
+        if (other) return pos + __builtin_ctz(other);
+        pos += SIMD_WIDTH;
     }
+#endif
+    while (CHAR_IS(source_code[pos], CHAR_SPACE)) pos++;
+    return pos;
+}
 
-    if (source_code[current_pos] == '}') {
-        current_pos++;
-        return create_token(TOKEN_RBRACE, "}");
+// 跳过标识符的剩余部分 (字母、数字、下划线)
+static int scan_ident_body(int pos) {
+    for (int i = 0; i < SCALAR_PREFIX; i++, pos++) {
+        if (!CHAR_IS(source_code[pos], CHAR_IDENT)) return pos;
+    }
+#ifdef SIMD_WIDTH
+    while (pos + SIMD_WIDTH <= source_length) {
+        unsigned other = ~simd_ident_mask(simd_load(source_code + pos)) & SIMD_ALL_ONES;
+        if (other) return pos + __builtin_ctz(other);
+        pos += SIMD_WIDTH;
     }
+#endif
+    while (CHAR_IS(source_code[pos], CHAR_IDENT)) pos++;
+    return pos;
+}
 
-    if (isdigit(source_code[current_pos])) {
-        int start = current_pos;
-        while (isdigit(source_code[current_pos])){
-            current_pos++;
-        }
-        int len = current_pos - start;
-        char* num_str = (char*)malloc(len + 1);
-        strncpy(num_str, source_code + start, len);
-        num_str[len] = '\0';
-        return create_token(TOKEN_INT, num_str);
+// 找到下一个等于 c 的字符；找不到就停在 '\0' (文件末尾)
+static int scan_until(int pos, char c) {
+#ifdef SIMD_WIDTH
+    simd_block target = simd_splat(c);
+    while (pos + SIMD_WIDTH <= source_length) {
+        unsigned hit = simd_mask(simd_eq(simd_load(source_code + pos), target));
+        if (hit) return pos + __builtin_ctz(hit);
+        pos += SIMD_WIDTH;
     }
+#endif
+    while (source_code[pos] != c && source_code[pos] != '\0') pos++;
+    return pos;
+}
+
+// 跳过所有空白和注释，返回后 current_pos 指向下一个 token 的第一个字符
+static void skip_whitespace_and_comments() {
+    while (1) {
+        current_pos = scan_whitespace(current_pos);
+        if (source_code[current_pos] != '/') return;
 
-    if (source_code[current_pos] == '/') {
-        
-        // 1. 单行注释 //
+        // 1. 单行注释 //：一直吃到换行符或文件结束
         if (source_code[current_pos + 1] == '/') {
-            current_pos += 2;
-            // 一直吃到换行符或文件结束
-            while (source_code[current_pos] != '\n' && source_code[current_pos] != '\0') {
-                current_pos++;
-            }
-            // 递归调用自己，获取注释后面的下一个 Token
-            return get_next_token(); 
+            current_pos = scan_until(current_pos + 2, '\n');
+            continue;
         }
-        
-        // 2. 多行注释 /* ... */
+
+        // 2. 多行注释 /* ... */：只在遇到 '*' 时才停下来看后面是不是 '/'
         if (source_code[current_pos + 1] == '*') {
-            current_pos += 2;
-            // 一直吃，直到遇到 */
-            while (source_code[current_pos] != '\0') {
-                if (source_code[current_pos] == '*' && source_code[current_pos + 1] == '/') {
-                    current_pos += 2; // 跳过 */
-                    break;
-                }
-                current_pos++;
+            int pos = current_pos + 2;
+            while (1) {
+                pos = scan_until(pos, '*');
+                if (source_code[pos] == '\0') break;        // 注释没有闭合，吃到文件末尾
+                if (source_code[pos + 1] == '/') { pos += 2; break; } // 跳过 */
+                pos++;
             }
-            // 递归调用自己
-            return get_next_token();
+            current_pos = pos;
+            continue;
         }
+        return; // 只是一个除号
     }
+}
 
-    // 1. 识别单字符 Token: '(', ')', ';'
-    if (source_code[current_pos] == '('){
-        current_pos++;
-        return create_token(TOKEN_LPAREN, "(");
-    }
-
-    if (source_code[current_pos] == ')'){
-        current_pos++;
-        return create_token(TOKEN_RPAREN, ")");
+// 关键字识别：先按长度分派，再看首字母，最多只需要一次 memcmp。
+// 这相当于一个手写的、编译期确定的完美哈希 (长度 + 首字符 -> 唯一候选)。
+// 返回对应的 TOKEN_KW_* 类型；不是关键字就返回 TOKEN_IDENTIFIER。
+static TokenType classify_word(const char* str, int len) {
+    switch (len) {
+        case 2:
+            if (str[0] == 'i' && str[1] == 'f') return TOKEN_KW_IF;
+            break;
+        case 3:
+            if (str[0] == 'i' && memcmp(str, "int", 3) == 0) return TOKEN_KW_INT;
+            if (str[0] == 'f' && memcmp(str, "for", 3) == 0) return TOKEN_KW_FOR;
+            break;
+        case 4:
+            if (str[0] == 'c' && memcmp(str, "char", 4) == 0) return TOKEN_KW_CHAR;
+            if (str[0] == 'e' && memcmp(str, "else", 4) == 0) return TOKEN_KW_ELSE;
+            break;
+        case 5:
+            if (str[0] == 'w' && memcmp(str, "while", 5) == 0) return TOKEN_KW_WHILE;
+            if (str[0] == 'b' && memcmp(str, "break", 5) == 0) return TOKEN_KW_BREAK;
+            break;
+        case 6:
+            if (str[0] == 'r' && memcmp(str, "return", 6) == 0) return TOKEN_KW_RETURN;
+            if (str[0] == 's' && memcmp(str, "struct", 6) == 0) return TOKEN_KW_STRUCT;
+            break;
+        case 8:
+            if (str[0] == 'c' && memcmp(str, "continue", 8) == 0) return TOKEN_KW_CONTINUE;
+            break;
     }
+    return TOKEN_IDENTIFIER;
+}
 
-    if (source_code[current_pos] == ';'){
-        current_pos++;
-        return create_token(TOKEN_SEMICOLON, ";");
-    }
+// 构造一个 token 视图：[start, start + length) 这段源码就是它的文本
+static Token make_token(TokenType type, int start, int length) {
+    Token token;
+    token.type = type;
+    token.offset = start;
+    token.length = length;
+    token.atom = NULL;
+    return token;
+}
 
-    if (source_code[current_pos] == '+') {
-        current_pos++;
-        return create_token(TOKEN_PLUS, "+");
-    }
-    if (source_code[current_pos] == '-') {
-        current_pos++;
-        return create_token(TOKEN_MINUS, "-");
-    }
-    if (source_code[current_pos] == '*') {
-        current_pos++;
-        return create_token(TOKEN_STAR, "*");
-    }
-    if (source_code[current_pos] == '/') {
-        current_pos++;
-        return create_token(TOKEN_SLASH, "/");
-    }
-    if (source_code[current_pos] == '[') {
-        current_pos++;
-        return create_token(TOKEN_LBRACKET, "[");
-    }
-    if (source_code[current_pos] == ']') {
-        current_pos++;
-        return create_token(TOKEN_RBRACKET, "]");
-    }
-    if (source_code[current_pos] == '.') {
-        current_pos++;
-        return create_token(TOKEN_DOT, ".");
-    }
+// 单字符/双字符符号：从 current_pos 开始，吃掉 length 个字符
+static Token punct_token(TokenType type, int length) {
+    int start = current_pos;
+    current_pos += length;
+    return make_token(type, start, length);
+}
 
-    // 处理 = 和 ==
-    if (source_code[current_pos] == '=') {
-        if (source_code[current_pos + 1] == '=') {
-            current_pos += 2;
-            return create_token(TOKEN_EQ, "==");
-        }
-        current_pos++;
-        return create_token(TOKEN_ASSIGN, "=");
-    }
+// 初始化词法分析器
+void lexer_init(char* source) {
+    init_char_class();
+    source_code = source;
+    current_pos = 0;
+    source_length = (int)strlen(source);
+}
 
-    // 处理 ! 和 != (暂时不处理单目 !, 只处理 !=)
-    if (source_code[current_pos] == '!') {
-        if (source_code[current_pos + 1] == '=') {
-            current_pos += 2;
-            return create_token(TOKEN_NEQ, "!=");
-        }
-        // --- 新增：处理单目 ! ---
-        current_pos++;
-        return create_token(TOKEN_BANG, "!");
-    }
+const char* token_text(Token* tok) {
+    return source_code + tok->offset;
+}
 
-    // 处理 < 和 <=
-    if (source_code[current_pos] == '<') {
-        if (source_code[current_pos + 1] == '=') {
-            current_pos += 2;
-            return create_token(TOKEN_LE, "<=");
-        }
-        current_pos++;
-        return create_token(TOKEN_LT, "<");
+int token_to_int(Token* tok) {
+    int value = 0;
+    for (int i = 0; i < tok->length; i++) {
+        value = value * 10 + (source_code[tok->offset + i] - '0');
     }
+    return value;
+}
 
-    // 处理 > 和 >=
-    if (source_code[current_pos] == '>') {
-        if (source_code[current_pos + 1] == '=') {
-            current_pos += 2;
-            return create_token(TOKEN_GE, ">=");
-        }
-        current_pos++;
-        return create_token(TOKEN_GT, ">");
+int token_char_value(Token* tok) {
+    char c = source_code[tok->offset];
+    // 简单的转义支持 (先支持 '\n' 和 '\0')
+    if (c == '\\') {
+        char e = source_code[tok->offset + 1];
+        if (e == 'n') return 10; // 换行符
+        if (e == '0') return 0;  // null
+        return e;                // 其他转义暂略：原样返回
     }
+    return c;
+}
 
-    if (source_code[current_pos] == ',') {
-        current_pos++;
-        return create_token(TOKEN_COMMA, ",");
-    }
+// 词法分析器的核心：一个以当前字符为分派键的 switch (DFA 的第一层转移)。
+// 多字符的符号 (==, <=, && ...) 再看一个字符决定走哪条边。
+Token get_next_token() {
+    skip_whitespace_and_comments();
+
+    char c = source_code[current_pos];
+    char next = (c == '\0') ? '\0' : source_code[current_pos + 1];
+
+    switch (c) {
+        case '\0': return make_token(TOKEN_EOF, current_pos, 0);
+
+        // 1. 单字符 Token
+        case '{': return punct_token(TOKEN_LBRACE, 1);
+        case '}': return punct_token(TOKEN_RBRACE, 1);
+        case '(': return punct_token(TOKEN_LPAREN, 1);
+        case ')': return punct_token(TOKEN_RPAREN, 1);
+        case ';': return punct_token(TOKEN_SEMICOLON, 1);
+        case '+': return punct_token(TOKEN_PLUS, 1);
+        case '-': return punct_token(TOKEN_MINUS, 1);
+        case '*': return punct_token(TOKEN_STAR, 1);
+        case '/': return punct_token(TOKEN_SLASH, 1); // 注释已经在上面跳过了
+        case '[': return punct_token(TOKEN_LBRACKET, 1);
+        case ']': return punct_token(TOKEN_RBRACKET, 1);
+        case '.': return punct_token(TOKEN_DOT, 1);
+        case ',': return punct_token(TOKEN_COMMA, 1);
+
+        // 2. 可能是两个字符的 Token
+        case '=': return next == '=' ? punct_token(TOKEN_EQ, 2)  : punct_token(TOKEN_ASSIGN, 1);
+        case '!': return next == '=' ? punct_token(TOKEN_NEQ, 2) : punct_token(TOKEN_BANG, 1);
+        case '<': return next == '=' ? punct_token(TOKEN_LE, 2)  : punct_token(TOKEN_LT, 1);
+        case '>': return next == '=' ? punct_token(TOKEN_GE, 2)  : punct_token(TOKEN_GT, 1);
+        case '&': return next == '&' ? punct_token(TOKEN_LOGIC_AND, 2) : punct_token(TOKEN_AMPERSAND, 1);
+        // 如果只有一个 |，暂时当作未知 (单竖线是位运算，以后再说)
+        case '|': return next == '|' ? punct_token(TOKEN_LOGIC_OR, 2)  : punct_token(TOKEN_UNKNOWN, 1);
+
+        // 3. 字符字面量 'A'
+        case '\'': {
+            current_pos++; // 吃掉开头的 '
+            int start = current_pos;
+
+            // 转义字符占两个字符 ('\n')，真正的值由 token_char_value() 解码
+            if (source_code[current_pos] == '\\') {
+                current_pos++;
+            }
+            current_pos++; // 吃掉字符
+            int len = current_pos - start;
 
-    if (source_code[current_pos] == '&') {
-        if (source_code[current_pos + 1] == '&') {
-            current_pos += 2;
-            return create_token(TOKEN_LOGIC_AND, "&&");
-        }
-        current_pos++;
-        return create_token(TOKEN_AMPERSAND, "&");
-    }
+            if (source_code[current_pos] != '\'') {
+                fprintf(stderr, "Error: Expected closing single quote.\n");
+                exit(1);
+            }
+            current_pos++; // 吃掉结尾的 '
 
-    // 处理 | (目前只有 ||，单竖线是位运算，以后再说)
-    if (source_code[current_pos] == '|') {
-        if (source_code[current_pos + 1] == '|') {
-            current_pos += 2;
-            return create_token(TOKEN_LOGIC_OR, "||");
+            return make_token(TOKEN_CHAR, start, len);
         }
-        // 如果只有一个 |，暂时当作未知或者位运算
-        current_pos++;
-        return create_token(TOKEN_UNKNOWN, "|");
-    }
 
-    if (source_code[current_pos] == '\'') {
-        current_pos++; // 吃掉开头的 '
-        char c = source_code[current_pos];
-        
-        // 简单的转义支持 (可选，先支持 '\n' 吧)
-        if (c == '\\') {
+        // 4. 字符串 "..."
+        case '"': {
             current_pos++;
-            if (source_code[current_pos] == 'n') c = 10; // 换行符
-            else if (source_code[current_pos] == '0') c = 0; // null
-            // 其他转义暂略
-        }
-        current_pos++; // 吃掉字符
-        
-        if (source_code[current_pos] != '\'') {
-            fprintf(stderr, "Error: Expected closing single quote.\n");
-            exit(1);
-        }
-        current_pos++; // 吃掉结尾的 '
+            int start = current_pos;
 
-        // 将字符转换为字符串形式的数字返回 (例如 'A' -> "65")
-        // 这样 parser 把它当数字处理就行，方便！
-        char* val = malloc(4);
-        sprintf(val, "%d", (int)c);
-        return create_token(TOKEN_CHAR, val);
-    }
+            current_pos = scan_until(current_pos, '"');
+            if (source_code[current_pos] == '\0') {
+                fprintf(stderr, "Error: Unclosed string literal.\n");
+                exit(1);
+            }
 
+            // 字符串内容就是 [start, current_pos)，不包含两侧引号
+            int len = current_pos - start;
 
-    // 2. 识别标识符和关键字
-    // C 语言的标识符以字母或下划线开头
-    if (isalpha(source_code[current_pos]) || source_code[current_pos] == '_') {
-        // TODO:
-        // a. 记录起始位置
-        int start = current_pos;
-        // b. 循环读取所有连续的字母、数字、下划线 (isalnum() 会很有用)
-        while (isalnum(source_code[current_pos]) || source_code[current_pos] == '_') {
-            current_pos++;
-        }
-        // c. 截取这个单词的子字符串 (像处理数字时一样，记得 malloc)
-        int len = current_pos - start;
-        char* str = (char*)malloc(len+1);   // 给单词字符串创建空间
-        strncpy(str, source_code + start, len);
-        str[len] = '\0';
-        // d. 检查这个字符串是不是关键字
-        //    - 如果是，返回一个 TOKEN_KEYWORD 类型的 Token
-        //    - 如果不是，返回一个 TOKEN_IDENTIFIER 类型的 Token
-        if (strcmp(str, "int") == 0 ||  
-            strcmp(str, "char") == 0 ||
-            strcmp(str, "return") == 0 || 
-            strcmp(str, "if") == 0 || 
-            strcmp(str, "else") == 0 ||
-            strcmp(str, "while") == 0 || 
-            strcmp(str, "for") == 0 ||
-            strcmp(str, "break") == 0 ||
-            strcmp(str, "continue") == 0 || 
-            strcmp(str, "struct") == 0) 
-        {
-            return create_token(TOKEN_KEYWORD, str);
-        } else {
-            return create_token(TOKEN_IDENTIFIER, str);
+            current_pos++; // 跳过结尾的 "
+
+            Token token = make_token(TOKEN_STRING, start, len);
+            token.atom = intern(source_code + start, len);
+            return token;
         }
+
+        default:
+            break;
     }
 
-    // 处理字符串
-    if (source_code[current_pos] == '"') {
-        current_pos++;
+    // 5. 数字
+    if (CHAR_IS(c, CHAR_DIGIT)) {
         int start = current_pos;
-
-        while(source_code[current_pos] != '"' && source_code[current_pos] != '\0'){
+        while (CHAR_IS(source_code[current_pos], CHAR_DIGIT)) {
             current_pos++;
         }
+        return make_token(TOKEN_INT, start, current_pos - start);
+    }
 
-        if (source_code[current_pos] == '\0') {
-            fprintf(stderr, "Error: Unclosed string literal.\n");
-            exit(1);
-        }
-
-        // 截取字符串
+    // 6. 标识符和关键字：C 语言的标识符以字母或下划线开头
+    if (CHAR_IS(c, CHAR_IDENT_START)) {
+        int start = current_pos;
+        current_pos = scan_ident_body(current_pos + 1);
+        // 这个单词就是源码里的 [start, current_pos)
         int len = current_pos - start;
-        char* str_value = (char*)malloc(len + 1);
-        strncpy(str_value, source_code + start, len);
-        str_value[len] = '\0';
-        
-        current_pos++; // 跳过结尾的 "
-        
-        return create_token(TOKEN_STRING, str_value);
+        Token token = make_token(classify_word(source_code + start, len), start, len);
+        if (token.type == TOKEN_IDENTIFIER) {
+            // 同一个名字无论出现多少次，都只在驻留表里存一份
+            token.atom = intern(source_code + start, len);
+        }
+        return token;
     }
 
-    current_pos++;
-    return create_token(TOKEN_UNKNOWN, "");
-}
\ No newline at end of file
+    return punct_token(TOKEN_UNKNOWN, 1);
+}
@@ -10,7 +10,6 @@ typedef enum {
     TOKEN_EOF,
     TOKEN_UNKNOWN,
     TOKEN_IDENTIFIER,   // 标识符, e.g., main, my_variable
-    TOKEN_KEYWORD,      // 关键字, e.g., int, return
     TOKEN_LPAREN,       // (
     TOKEN_RPAREN,       // )
     TOKEN_SEMICOLON,    // ;
@@ -35,18 +34,41 @@ typedef enum {
     TOKEN_LOGIC_OR,     // ||
     TOKEN_CHAR,         // 'A'
     TOKEN_DOT,          // .
-    TOKEN_STRUCT,       // struct
+
+    // --- 关键字：每个关键字都有自己的 token 类型，parser 直接 switch，不再比较字符串 ---
+    TOKEN_KW_INT,       // int
+    TOKEN_KW_CHAR,      // char
+    TOKEN_KW_RETURN,    // return
+    TOKEN_KW_IF,        // if
+    TOKEN_KW_ELSE,      // else
+    TOKEN_KW_WHILE,     // while
+    TOKEN_KW_FOR,       // for
+    TOKEN_KW_BREAK,     // break
+    TOKEN_KW_CONTINUE,  // continue
+    TOKEN_KW_STRUCT,    // struct
 } TokenType;
 
+// Token 是一个小小的值类型：它不持有任何堆内存，
+// 只是记录自己在 read_file() 读入的源码缓冲区里的位置 (offset, length)。
+// 词法分析阶段因此不再为每个 token 调用 malloc。
 typedef struct {
     TokenType type;
-    char* value;
+    int offset;     // token 文本在源码缓冲区中的起始下标
+    int length;     // token 文本的长度 (字符串不含引号，字符不含单引号)
+    char* atom;     // 标识符和字符串字面量：驻留后的文本 (见 intern.h)，其他 token 为 NULL
 } Token;
 
 // --- 函数声明 ---
-// 初始化词法分析器
+// 初始化词法分析器 (source 必须在整个编译期间保持有效)
 void lexer_init(char* source);
-// 获取下一个 token
-Token* get_next_token();
+// 获取下一个 token (按值返回)
+Token get_next_token();
+
+// 取得 token 文本的起始地址。注意：它指向源码内部，不以 '\0' 结尾！
+const char* token_text(Token* tok);
+// 把数字 token 转换成整数 (不需要复制字符串)
+int token_to_int(Token* tok);
+// 解码字符 token ('A', '\n' ...) 的值
+int token_char_value(Token* tok);
 
 #endif // LEXER_H
\ No newline at end of file
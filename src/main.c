@@ -1,9 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "lexer.h"
 #include "parser.h"
 #include "ast.h"
+#include "ast_compact.h"
 #include "codegen.h"
+#include "emit.h"
+#include "intern.h"
+#include "strpool.h"
+#include "ir.h"
+#include "fold.h"
+#include "peephole.h"
+#include "inline.h"
 
 // -----------
 // 调试与清理函数
@@ -161,111 +172,6 @@ void print_ast(ASTNode* node, int indent) {
     }
 }
 
-// 这是一个完整且正确的 free_ast 函数
-void free_ast(ASTNode* node) {
-    if (node == NULL) return;
-
-    switch (node->type) {
-        case NODE_PROGRAM: {
-            ProgramNode* prog = (ProgramNode*)node;
-            for (int i = 0; i < prog->count; i++) {
-                free_ast((ASTNode*)prog->declarations[i]);
-            }
-            free(prog->declarations);
-            break;
-        }
-        case NODE_BLOCK_STATEMENT: {
-            BlockStatementNode* block = (BlockStatementNode*)node;
-            for (int i = 0; i < block->count; i++) {
-                free_ast(block->statements[i]);
-            }
-            free(block->statements);
-            break;
-        }
-        case NODE_VAR_DECL: { // <--- 新增 case
-            VarDeclNode* var_decl = (VarDeclNode*)node;
-            free(var_decl->name); // 释放变量名
-            free_ast(var_decl->initial_value); // 递归释放初始值
-            break;
-        }
-        case NODE_RETURN_STATEMENT: {
-            ReturnStatementNode* ret = (ReturnStatementNode*)node;
-            free_ast(ret->argument);
-            break;
-        }
-        case NODE_IDENTIFIER: { // <--- 新增 case
-            IdentifierNode* ident = (IdentifierNode*)node;
-            free(ident->name); // 释放标识符名
-            break;
-        }
-        case NODE_NUMERIC_LITERAL: {
-            NumericLiteralNode* num_node = (NumericLiteralNode*)node;
-            free(num_node->value);
-            break;
-        }
-        case NODE_BINARY_OP: {
-            BinaryOpNode* bin = (BinaryOpNode*)node;
-            free_ast(bin->left);
-            free_ast(bin->right);
-            break;
-        }
-        case NODE_IF_STATEMENT: { // 假设你有这个 case，如果没有请加上
-            IfStatementNode* if_stmt = (IfStatementNode*)node;
-            free_ast(if_stmt->condition);
-            free_ast(if_stmt->body);
-            if (if_stmt->else_branch != NULL) { // 递归释放 else
-                free_ast(if_stmt->else_branch);
-            }
-            break;
-        }
-        case NODE_WHILE_STATEMENT: {
-            WhileStatementNode* while_stmt = (WhileStatementNode*)node;
-            free_ast(while_stmt->condition);
-            free_ast(while_stmt->body);
-            break;
-        }
-        case NODE_FOR_STATEMENT: {
-            ForStatementNode* for_node = (ForStatementNode*)node;
-            free_ast(for_node->init);
-            free_ast(for_node->condition);
-            free_ast(for_node->increment);
-            free_ast(for_node->body);
-            break;
-        }
-        case NODE_UNARY_OP: {
-            UnaryOpNode* unary = (UnaryOpNode*)node;
-            free_ast(unary->operand);
-            break;
-        }
-        case NODE_FUNCTION_DECL: {
-            FunctionDeclarationNode* func = (FunctionDeclarationNode*)node;
-            free(func->name);
-            
-            // --- 新增：释放参数列表 ---
-            // 1. 遍历释放每一个参数节点 (VarDeclNode)
-            for (int i = 0; i < func->arg_count; i++) {
-                free_ast(func->args[i]);
-            }
-            // 2. 释放存放指针的数组本身
-            if (func->args != NULL) {
-                free(func->args);
-            }
-            
-            free_ast((ASTNode*)func->body);
-            break;
-        }
-        case NODE_ARRAY_ACCESS: {
-            ArrayAccessNode* arr_access = (ArrayAccessNode*)node;
-            free(arr_access->array_name);  // 释放数组名（动态分配的字符串）
-            free_ast(arr_access->index);   // 递归释放索引表达式（可能是数字、标识符等节点）
-            break;
-        }
-        default:
-            break;
-    }
-    free(node);
-}
-
 char* read_file(const char* filename) {
     FILE* file = fopen(filename, "r");
     if (!file) {
@@ -293,15 +199,84 @@ char* read_file(const char* filename) {
     return buffer;
 }
 
+// 把 emitter 缓冲区写到 filename (为 NULL 时写到标准输出)，成功返回 1
+static int write_output(const char* filename) {
+    int fd = STDOUT_FILENO;
+    if (filename != NULL) {
+        fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "Error: Could not open output file '%s'\n", filename);
+            return 0;
+        }
+    } else {
+        // 之前可能有 printf 留在 stdio 缓冲区里 (比如 Usage 提示)，先把它们冲出去，保证顺序
+        fflush(stdout);
+    }
+
+    int ok = emit_write(fd) == 0;
+    if (filename != NULL && close(fd) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "Error: Could not write assembly to '%s'\n", filename ? filename : "<stdout>");
+    }
+    return ok;
+}
+
 // -----------
 // 主函数
 // -----------
 int main(int argc, char** argv) {
     char* source_code = NULL;
+    const char* input_file = NULL;
+    const char* output_file = NULL; // -o file.s: 直接写文件；不给就写到标准输出
+    int dump_ast = 0;          // --dump-ast: 打印 (指针形式的) AST 后退出
+    int dump_compact_ast = 0;  // --dump-ast=compact: 打印紧凑 AST 后退出，输出应与 --dump-ast 完全一致
+    int use_ir = 0;            // -O: 经过 IR (ir.h) 生成代码，而不是直接从 AST 生成
+    int dump_ir = 0;           // --dump-ir: 打印 IR 后退出
+    int peephole_stats = 0;    // --peephole-stats: 打印每条窥孔规则的改写次数
+    int inline_report = 0;     // --inline-report: 打印每个调用点的内联决定
 
-    if (argc >= 2) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: '-o' requires a file name\n");
+                return 1;
+            }
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--merge-strings") == 0) {
+            strpool_merge_suffixes = 1; // 字符串字面量做后缀合并
+        } else if (strcmp(argv[i], "--dump-ast") == 0) {
+            dump_ast = 1;
+        } else if (strcmp(argv[i], "--dump-ast=compact") == 0) {
+            dump_compact_ast = 1;
+        } else if (strcmp(argv[i], "-O") == 0) {
+            use_ir = 1;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            dump_ir = 1;
+        } else if (strncmp(argv[i], "--peephole-window=", 18) == 0) {
+            peephole_window = atoi(argv[i] + 18); // 0 关闭窥孔优化
+        } else if (strcmp(argv[i], "--peephole-stats") == 0) {
+            peephole_stats = 1;
+        } else if (strncmp(argv[i], "--inline-threshold=", 19) == 0) {
+            inline_threshold = atoi(argv[i] + 19); // 0 关闭内联
+        } else if (strcmp(argv[i], "--inline-report") == 0) {
+            inline_report = 1;
+        } else if (strcmp(argv[i], "--frame-report") == 0) {
+            frame_report = 1; // 打印每个函数的栈帧大小 (变量共用栈空间前后)
+        } else if (strcmp(argv[i], "-fomit-frame-pointer") == 0) {
+            omit_frame_pointer = 1;
+        } else if (strcmp(argv[i], "-fno-omit-frame-pointer") == 0) {
+            omit_frame_pointer = 0; // 保留 rbp 栈帧链，给 profiler 回溯调用栈用
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            return 1;
+        } else {
+            input_file = argv[i];
+        }
+    }
+
+    if (input_file != NULL) {
         // 如果命令行提供了文件名: ./tinyc tests/test.c
-        source_code = read_file(argv[1]);
+        source_code = read_file(input_file);
     } else {
         // 如果没提供，为了方便调试，我们可以给个默认路径，或者报错
         // 这里我们默认读取 tests/test.c，省得你每次都要输参数
@@ -316,12 +291,71 @@ int main(int argc, char** argv) {
     // printf("语法分析完成！\n\n");
 
     // printf("--- 生成的 AST 树 ---\n");
-    // print_ast(root, 0);
+    if (dump_ast) {
+        print_ast(root, 0);
+    }
+    if (dump_compact_ast) {
+        CompactAST compact = {0};
+        NodeRef compact_root = compact_ast_build(&compact, root);
+        compact_ast_print(&compact, compact_root, 0);
+        // 统计信息打到 stderr，保证 stdout 与 --dump-ast 逐字节一致
+        fprintf(stderr, "compact AST: %u nodes, %zu bytes (pointer AST arena: %zu bytes)\n",
+                compact.node_count - 1, compact_ast_bytes(&compact), ast_arena.used);
+        compact_ast_free(&compact);
+    }
+    if (dump_ast || dump_compact_ast) {
+        arena_free(&ast_arena);
+        intern_free();
+        free(source_code);
+        return 0;
+    }
 
-    // printf("--- Generating Assembly Code ---\n");
-    codegen(root);
+    // 常量折叠 / 常量传播 / 删死分支，两条后端都用折叠过的 AST
+    fold_program(root);
+    // 小函数展开到调用点；展开出来的形参是普通局部变量，常量实参再折叠/传播一遍
+    if (inline_program(root) > 0) {
+        fold_program(root);
+    }
+    if (inline_report) {
+        inline_print_report();
+    }
+
+    if (use_ir || dump_ir) {
+        IRProgram* program = ir_lower(root);
+        ir_optimize(program);
+        if (dump_ir) {
+            ir_dump(program);
+            ir_free();
+            strpool_free();
+            arena_free(&ast_arena);
+            intern_free();
+            free(source_code);
+            return 0;
+        }
+        ir_codegen(program);
+        ir_free();
+    } else {
+        // printf("--- Generating Assembly Code ---\n");
+        codegen(root);
+    }
+
+    // 写出之前在汇编文本上做窥孔优化
+    peephole_optimize();
+    if (peephole_stats) {
+        peephole_print_stats();
+    }
+
+    // 整个汇编文本都在 emitter 的缓冲区里，一次 write 写出去
+    if (!write_output(output_file)) {
+        return 1;
+    }
+    emit_free();
 
-    free_ast(root);
+    // 整棵 AST (节点、名字、子节点数组) 都在 arena 里，一次性释放
+    arena_free(&ast_arena);
+    // 所有名字和字符串字面量都在驻留表里，最后统一释放
+    intern_free();
+    free(source_code);
     // printf("内存已释放。\n");
 
     return 0;
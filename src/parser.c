@@ -1,16 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h> // 为了 strcmp 和 strdup
+#include <string.h>
 #include "parser.h"
 #include "lexer.h"
+#include "symtab.h"
+#include "intern.h"
 
 // -----------
 // 模块私有变量和函数声明
 // -----------
 
-static Token* current_token;
+static Token current_token;
 static void eat(TokenType type);
 
+Arena ast_arena;
+
 // 向前声明 (Forward Declaration)
 // 因为函数之间存在相互调用，我们需要提前告诉编译器这些函数的存在。
 ASTNode* parse_statement();
@@ -36,17 +40,40 @@ void parse_struct_definition();
 
 // ===
 
+// 只有当 AST 节点真正需要拥有一份字符串时，才把 token 文本复制到 arena 里。
+// (标识符和字符串不需要复制：直接使用词法分析器驻留好的 current_token.atom)
+static char* copy_token_text(Token* tok) {
+    return arena_strndup(&ast_arena, token_text(tok), tok->length);
+}
+
+// 分配一个 AST 节点 (从 arena 里切，不会单独释放)
+static void* new_node(size_t size) {
+    return arena_alloc(&ast_arena, size);
+}
+
+// 往子节点数组末尾追加一个节点。容量不够时按 2 倍扩容，
+// 所以 n 个元素总共只会拷贝 O(n) 次，而不是每次 realloc。
+static ASTNode** append_node(ASTNode** list, int* count, int* capacity, ASTNode* node) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity == 0 ? 4 : *capacity * 2;
+        list = (ASTNode**)arena_grow(&ast_arena, list, *count, new_capacity, sizeof(ASTNode*));
+        *capacity = new_capacity;
+    }
+    list[(*count)++] = node;
+    return list;
+}
+
 // 解析类型关键字
 DataType parse_type() {
-    if (current_token->type == TOKEN_KEYWORD) {
-        if (strcmp(current_token->value, "int") == 0) {
-            eat(TOKEN_KEYWORD);
+    switch (current_token.type) {
+        case TOKEN_KW_INT:
+            eat(TOKEN_KW_INT);
             return TYPE_INT;
-        }
-        if (strcmp(current_token->value, "char") == 0) {
-            eat(TOKEN_KEYWORD);
+        case TOKEN_KW_CHAR:
+            eat(TOKEN_KW_CHAR);
             return TYPE_CHAR;
-        }
+        default:
+            break;
     }
     fprintf(stderr, "Syntax Error: Expected type specifier (int, char)\n");
     exit(1);
@@ -54,19 +81,12 @@ DataType parse_type() {
 }
 
 static void eat(TokenType type) {
-    if (current_token->type == type) {
-        // 对于需要其值的Token (如INT, IDENTIFIER)，它的value指针已经被AST节点接管，
-        // 我们只需要释放Token结构体本身。
-        // 对于不需要其值的Token，我们也要释放其value（如果它是动态分配的）。
-        // 目前我们的词法分析器对所有动态分配的value都交给了AST，所以这里逻辑简化。
-        if (current_token->value != NULL && (type != TOKEN_INT && type != TOKEN_IDENTIFIER && type != TOKEN_KEYWORD)) {
-             // 对于那些我们没有在AST中保存其value的动态分配的token，需要在这里处理
-             // 但目前的设计下，这个分支暂时不会被走到。
-        }
-        free(current_token); 
+    if (current_token.type == type) {
+        // Token 只是源码缓冲区里的一个视图，没有任何需要释放的东西。
+        // 需要保留文本的地方 (AST 节点) 会在 eat 之前自己调用 token_strdup 复制。
         current_token = get_next_token();
     } else {
-        fprintf(stderr, "Syntax Error: Expected token %d, but got %d\n", type, current_token->type);
+        fprintf(stderr, "Syntax Error: Expected token %d, but got %d\n", type, current_token.type);
         exit(1);
     }
 }
@@ -75,14 +95,36 @@ static void eat(TokenType type) {
 // 解析函数 - 从具体到抽象 (自底向上)
 // -----------
 
+// 语法分析时也维护一份局部变量的作用域 (复用 symtab.h)，
+// 只是为了知道 p.x 里的 p 是哪个结构体，从而在这里就把成员偏移查好
+static void declare_local(char* name, DataType type, char* struct_name) {
+    Symbol* sym = symtab_declare(name);
+    sym->type = type;
+    sym->struct_name = struct_name;
+}
+
+static MemberInfo* resolve_member(char* var_name, char* member_name) {
+    Symbol* sym = find_symbol(var_name);
+    if (!sym || sym->type != TYPE_STRUCT) {
+        fprintf(stderr, "Error: '%s' is not a struct variable.\n", var_name);
+        exit(1);
+    }
+    StructDef* s = find_struct(sym->struct_name);
+    MemberInfo* member = find_struct_member(s, member_name);
+    if (!member) {
+        fprintf(stderr, "Error: struct %s has no member named '%s'.\n", s->name, member_name);
+        exit(1);
+    }
+    return member;
+}
+
 // 新增一个解析 "项" 的函数，目前一个项就是一个数字或变量
 ASTNode* parse_factor() {
     ASTNode* node = NULL;
-    char* value_ptr = current_token->value;
-    TokenType type = current_token->type;
+    TokenType type = current_token.type;
 
     if (type == TOKEN_INT) {
-        node = (ASTNode*)create_numeric_literal(value_ptr);
+        node = (ASTNode*)create_numeric_literal(copy_token_text(&current_token));
         eat(TOKEN_INT);
     } 
     else if (type == TOKEN_LPAREN) {
@@ -104,32 +146,32 @@ ASTNode* parse_factor() {
         // 更好的办法：在 Lexer 里增加 peek() 功能，或者在这里做一个小 trick。
         
         // 这里的 trick：我们先保存名字，eat(ID)，然后看 current_token
-        char* name = current_token->value;
+        char* name = current_token.atom;
         eat(TOKEN_IDENTIFIER);
 
-        if (current_token->type == TOKEN_DOT) {
+        if (current_token.type == TOKEN_DOT) {
             // --- 处理 p.x ---
             eat(TOKEN_DOT);
-            char* member_name = current_token->value;
+            char* member_name = current_token.atom;
             eat(TOKEN_IDENTIFIER);
-            return (ASTNode*)create_member_access_node(name, member_name);
+            // 成员偏移在这里一次查好，记在节点上
+            return (ASTNode*)create_member_access_node(name, member_name, resolve_member(name, member_name));
         }
 
-        if (current_token->type == TOKEN_LPAREN) {
+        if (current_token.type == TOKEN_LPAREN) {
             // --- 这是函数调用 ---
             eat(TOKEN_LPAREN);
             
             ASTNode** args = NULL;
             int arg_count = 0;
+            int arg_capacity = 0;
 
-            if (current_token->type != TOKEN_RPAREN) {
+            if (current_token.type != TOKEN_RPAREN) {
                 while (1) {
                     ASTNode* expr = parse_expression();
-                    arg_count++;
-                    args = realloc(args, sizeof(ASTNode*) * arg_count);
-                    args[arg_count - 1] = expr;
+                    args = append_node(args, &arg_count, &arg_capacity, expr);
 
-                    if (current_token->type == TOKEN_COMMA) {
+                    if (current_token.type == TOKEN_COMMA) {
                         eat(TOKEN_COMMA);
                     } else {
                         break;
@@ -139,7 +181,7 @@ ASTNode* parse_factor() {
             eat(TOKEN_RPAREN);
             return (ASTNode*)create_function_call_node(name, args, arg_count);
         } 
-        else if (current_token->type == TOKEN_LBRACKET) {
+        else if (current_token.type == TOKEN_LBRACKET) {
             eat(TOKEN_LBRACKET);
             ASTNode* index = parse_expression(); // 解析索引 (支持 a[x+1])
             eat(TOKEN_RBRACKET);
@@ -151,13 +193,15 @@ ASTNode* parse_factor() {
         }
     }
     else if (type == TOKEN_STRING) {
-        char* val = current_token->value;
+        char* val = current_token.atom;
         eat(TOKEN_STRING);
         return (ASTNode*)create_string_literal_node(val);
     }
     else if (type == TOKEN_CHAR) {
-        // Lexer 已经把 'A' 变成了 "65"，直接当数字节点创建即可
-        ASTNode* node = (ASTNode*)create_numeric_literal(current_token->value);
+        // 把 'A' 变成 "65"，这样直接当数字节点创建即可
+        char* val = (char*)arena_alloc(&ast_arena, 8);
+        snprintf(val, 8, "%d", token_char_value(&current_token));
+        ASTNode* node = (ASTNode*)create_numeric_literal(val);
         eat(TOKEN_CHAR);
         return node;
     }
@@ -171,13 +215,13 @@ ASTNode* parse_factor() {
 
 ASTNode* parse_unary() {
     // 检查当前是不是一元操作符 (+, -, !)
-    if (current_token->type == TOKEN_PLUS || 
-        current_token->type == TOKEN_MINUS || 
-        current_token->type == TOKEN_BANG || 
-        current_token->type == TOKEN_AMPERSAND ||
-        current_token->type == TOKEN_STAR) {
+    if (current_token.type == TOKEN_PLUS || 
+        current_token.type == TOKEN_MINUS || 
+        current_token.type == TOKEN_BANG || 
+        current_token.type == TOKEN_AMPERSAND ||
+        current_token.type == TOKEN_STAR) {
         
-        TokenType op = current_token->type;
+        TokenType op = current_token.type;
         eat(op);
         
         // 递归调用自己！因为可能出现 - -5 或 ! ! x 这种情况
@@ -197,8 +241,8 @@ ASTNode* parse_term() {
     ASTNode* left = parse_unary();
 
     // 2. 只要后面跟着 * 或 /，就继续吃
-    while (current_token->type == TOKEN_STAR || current_token->type == TOKEN_SLASH) {
-        TokenType op = current_token->type;
+    while (current_token.type == TOKEN_STAR || current_token.type == TOKEN_SLASH) {
+        TokenType op = current_token.type;
         eat(op);
         ASTNode* right = parse_unary();
         left = (ASTNode*)create_binary_op_node(left, op, right);
@@ -212,9 +256,9 @@ ASTNode* parse_additive_expression() {
     ASTNode* left = parse_term();
 
     // 2. 循环检查后面是否跟着 '+' 或 '-'
-    while (current_token->type == TOKEN_PLUS || current_token->type == TOKEN_MINUS) {
+    while (current_token.type == TOKEN_PLUS || current_token.type == TOKEN_MINUS) {
         // a. 获取操作符 token
-        TokenType op = current_token->type;
+        TokenType op = current_token.type;
         // b. 消费掉操作符 token
         eat(op);
         // c. 解析右边的 "term"
@@ -238,11 +282,11 @@ ASTNode* parse_comparison_expression() {
     ASTNode* left = parse_additive_expression();
 
     // 2. 检查是否有比较操作符
-    while (current_token->type == TOKEN_GT || current_token->type == TOKEN_LT ||
-           current_token->type == TOKEN_EQ || current_token->type == TOKEN_NEQ ||
-           current_token->type == TOKEN_LE || current_token->type == TOKEN_GE) {
+    while (current_token.type == TOKEN_GT || current_token.type == TOKEN_LT ||
+           current_token.type == TOKEN_EQ || current_token.type == TOKEN_NEQ ||
+           current_token.type == TOKEN_LE || current_token.type == TOKEN_GE) {
         
-        TokenType op = current_token->type;
+        TokenType op = current_token.type;
         eat(op);
         
         // 3. 解析右侧
@@ -265,8 +309,8 @@ ASTNode* parse_logical_or() {
     // 先解析优先级更高的 &&
     ASTNode* left = parse_logical_and();
 
-    while (current_token->type == TOKEN_LOGIC_OR) {
-        TokenType op = current_token->type;
+    while (current_token.type == TOKEN_LOGIC_OR) {
+        TokenType op = current_token.type;
         eat(TOKEN_LOGIC_OR);
         ASTNode* right = parse_logical_and();
         // 仍然使用 BinaryOpNode，因为结构是一样的，只是 op 不同
@@ -282,8 +326,8 @@ ASTNode* parse_logical_and() {
     // 如果你没有把 == 和 < 分开，那就直接调 parse_comparison_expression
     ASTNode* left = parse_comparison_expression();
 
-    while (current_token->type == TOKEN_LOGIC_AND) {
-        TokenType op = current_token->type;
+    while (current_token.type == TOKEN_LOGIC_AND) {
+        TokenType op = current_token.type;
         eat(TOKEN_LOGIC_AND);
         ASTNode* right = parse_comparison_expression();
         left = (ASTNode*)create_binary_op_node(left, op, right);
@@ -294,11 +338,11 @@ ASTNode* parse_logical_and() {
 // 解析变量声明语句: "int" <identifier> "=" <expression> ";"
 ASTNode* parse_variable_declaration() {
     // 检查是不是 struct 关键字
-    if (current_token->type == TOKEN_KEYWORD && strcmp(current_token->value, "struct") == 0) {
-        eat(TOKEN_KEYWORD);
-        char* struct_name = current_token->value;
+    if (current_token.type == TOKEN_KW_STRUCT) {
+        eat(TOKEN_KW_STRUCT);
+        char* struct_name = current_token.atom;
         eat(TOKEN_IDENTIFIER);
-        char* var_name = current_token->value;
+        char* var_name = current_token.atom;
         eat(TOKEN_IDENTIFIER);
         eat(TOKEN_SEMICOLON);
         
@@ -310,6 +354,7 @@ ASTNode* parse_variable_declaration() {
         // 或者使用上面新增的 array_size 来存总字节数？
         // 这里的技巧是：把结构体当成一个巨大的 int 数组或者 byte 数组处理
         // 传入 struct_name
+        declare_local(var_name, TYPE_STRUCT, struct_name);
         return (ASTNode*)create_var_decl_node(var_name, NULL, s->size / 8, TYPE_STRUCT, struct_name); 
         // 注意：这里我复用了 array_size 字段来告诉 codegen 分配多少个 8字节。
         // 你也可以在 VarDeclNode 里加个 size 字段更清晰。
@@ -317,20 +362,20 @@ ASTNode* parse_variable_declaration() {
 
     DataType var_type = parse_type(); // 吃掉 "int"、"char"
 
-    char* variable_name = current_token->value;
+    char* variable_name = current_token.atom;
     eat(TOKEN_IDENTIFIER);
 
     int array_size = 0;
     ASTNode* expr = NULL;
 
     // 检查是不是数组: int a[10];
-    if (current_token->type == TOKEN_LBRACKET) {
+    if (current_token.type == TOKEN_LBRACKET) {
         eat(TOKEN_LBRACKET);
-        if (current_token->type != TOKEN_INT) {
+        if (current_token.type != TOKEN_INT) {
             fprintf(stderr, "Error: Array size must be a constant integer.\n");
             exit(1);
         }
-        array_size = atoi(current_token->value);
+        array_size = token_to_int(&current_token);
         eat(TOKEN_INT);
         eat(TOKEN_RBRACKET);
         
@@ -338,13 +383,16 @@ ASTNode* parse_variable_declaration() {
         eat(TOKEN_SEMICOLON);
     } else {
         // 普通变量: int a = 10;
-        if (current_token->type == TOKEN_ASSIGN) {
+        if (current_token.type == TOKEN_ASSIGN) {
             eat(TOKEN_ASSIGN);
             expr = parse_expression(); 
         }
         eat(TOKEN_SEMICOLON);
     }
 
+    // 和代码生成一样：初始值表达式求完以后，变量才进入作用域
+    declare_local(variable_name, var_type, NULL);
+
     // 传入 array_size 参数
     return (ASTNode*)create_var_decl_node(variable_name, expr, array_size, var_type, NULL);
 }
@@ -353,7 +401,7 @@ ASTNode* parse_variable_declaration() {
 ASTNode* parse_return_statement() {
     // TODO (1/5): 完成 return 语句的解析
     // 1. 确认当前 token 是 "return" 关键字，然后消费它
-    eat(TOKEN_KEYWORD); // 简化：我们假设这里的KEYWORD一定是return
+    eat(TOKEN_KW_RETURN);
 
     // 2. 解析 return 后面跟着的表达式
     ASTNode* argument = parse_expression();
@@ -367,7 +415,7 @@ ASTNode* parse_return_statement() {
 
 ASTNode* parse_assignment_statement() {
     // 左边是一个已存在的变量
-    char* var_name = current_token->value;
+    char* var_name = current_token.atom;
     ASTNode* left = (ASTNode*)create_identifier_node(var_name);
     eat(TOKEN_IDENTIFIER);
 
@@ -386,54 +434,41 @@ ASTNode* parse_assignment_statement() {
 // 解析一个语句。目前一个语句只能是 "return" 语句。
 ASTNode* parse_statement() {
     // TODO (2/5): 完成语句的解析
-    // 检查当前 token 是否是关键字 "return"
-    if (current_token->type == TOKEN_KEYWORD && strcmp(current_token->value, "return") == 0) {
-        // 如果是，就调用 parse_return_statement()
-        return parse_return_statement();
-    }
-    // 如果是 "int" 关键字，说明这是一个变量声明
-    if (current_token->type == TOKEN_KEYWORD && 
-       (strcmp(current_token->value, "int") == 0 || 
-        strcmp(current_token->value, "char") == 0 ||
-        strcmp(current_token->value, "struct") == 0)) {
-        return parse_variable_declaration();
-    }
-
-    // 如果是 "if" 关键字
-    if (strcmp(current_token->value, "if") == 0) {
-        return parse_if_statement();
-    }
-
-    // 如果是 "while" 关键字
-    if (strcmp(current_token->value, "while") == 0) {
-        return parse_while_statement();
-    }
-
-    // 如果是 "for" 关键字
-    if (strcmp(current_token->value, "for") == 0) {
-        return parse_for_statement();
-    }
-
-    if (strcmp(current_token->value, "break") == 0) {
-        eat(TOKEN_KEYWORD);
-        eat(TOKEN_SEMICOLON);
-        return create_break_node();
-    }
-    
-    if (strcmp(current_token->value, "continue") == 0) {
-        eat(TOKEN_KEYWORD);
-        eat(TOKEN_SEMICOLON);
-        return create_continue_node();
+    // 关键字在词法分析阶段就已经分类好了，这里直接按 token 类型分派
+    switch (current_token.type) {
+        case TOKEN_KW_RETURN:
+            return parse_return_statement();
+        // 如果是 "int"/"char"/"struct" 关键字，说明这是一个变量声明
+        case TOKEN_KW_INT:
+        case TOKEN_KW_CHAR:
+        case TOKEN_KW_STRUCT:
+            return parse_variable_declaration();
+        case TOKEN_KW_IF:
+            return parse_if_statement();
+        case TOKEN_KW_WHILE:
+            return parse_while_statement();
+        case TOKEN_KW_FOR:
+            return parse_for_statement();
+        case TOKEN_KW_BREAK:
+            eat(TOKEN_KW_BREAK);
+            eat(TOKEN_SEMICOLON);
+            return create_break_node();
+        case TOKEN_KW_CONTINUE:
+            eat(TOKEN_KW_CONTINUE);
+            eat(TOKEN_SEMICOLON);
+            return create_continue_node();
+        default:
+            break;
     }
 
     // 注意：赋值语句 (x = 5;) 也是一种语句，我们需要在这里处理
-    if (current_token->type == TOKEN_IDENTIFIER || current_token->type == TOKEN_STAR) {
+    if (current_token.type == TOKEN_IDENTIFIER || current_token.type == TOKEN_STAR) {
         // 1. 先解析左边的部分 (x 或 *p 或 add())
         // parse_expression 会自动处理优先级，解析出 *p 这个节点
         ASTNode* left = parse_expression();
 
         // 2. 检查后面是不是赋值号 '='
-        if (current_token->type == TOKEN_ASSIGN) {
+        if (current_token.type == TOKEN_ASSIGN) {
             // 是赋值语句: x = ... 或 *p = ...
             eat(TOKEN_ASSIGN);
             ASTNode* right = parse_expression();
@@ -450,12 +485,13 @@ ASTNode* parse_statement() {
     }
 
     // 如果是左大括号，说明是一个代码块
-    if (current_token->type == TOKEN_LBRACE) {
+    if (current_token.type == TOKEN_LBRACE) {
         return parse_block_statement();
     }
     
     // 如果不是我们认识的语句，就报错
-    fprintf(stderr, "Syntax Error: Unexpected statement starting with token value '%s'\n", current_token->value);
+    fprintf(stderr, "Syntax Error: Unexpected statement starting with token value '%.*s'\n",
+            current_token.length, token_text(&current_token));
     exit(1);
 }
 
@@ -463,30 +499,32 @@ ASTNode* parse_statement() {
 ASTNode* parse_block_statement() {
     eat(TOKEN_LBRACE);
     BlockStatementNode* block_node = create_block_statement();
+    symtab_push_scope();
     
     // 循环解析块内的所有语句，直到遇到 '}'
-    while (current_token->type != TOKEN_RBRACE) {
+    while (current_token.type != TOKEN_RBRACE) {
         ASTNode* statement = parse_statement();
         add_statement_to_block(block_node, statement);
     }
     
+    symtab_pop_scope();
     eat(TOKEN_RBRACE);
     return (ASTNode*)block_node;
 }
 
 void parse_struct_definition() {
-    eat(TOKEN_KEYWORD); // struct
-    char* struct_name = current_token->value;
+    eat(TOKEN_KW_STRUCT); // struct
+    char* struct_name = current_token.atom;
     eat(TOKEN_IDENTIFIER);
     eat(TOKEN_LBRACE); // {
     
     StructDef* s = define_struct(struct_name);
     
     // 解析成员
-    while (current_token->type != TOKEN_RBRACE) {
+    while (current_token.type != TOKEN_RBRACE) {
         // 简化：成员只能是 int x; 或 char y; 不支持嵌套 struct
         DataType type = parse_type();
-        char* mem_name = current_token->value;
+        char* mem_name = current_token.atom;
         eat(TOKEN_IDENTIFIER);
         eat(TOKEN_SEMICOLON);
         
@@ -500,7 +538,7 @@ void parse_struct_definition() {
 // 新函数：用于解析顶层内容（可能是函数，可能是全局变量）
 ASTNode* parse_top_level() {
     // --- 新增：检查是不是 struct 定义 ---
-    if (current_token->type == TOKEN_KEYWORD && strcmp(current_token->value, "struct") == 0) {
+    if (current_token.type == TOKEN_KW_STRUCT) {
         parse_struct_definition();
         return NULL; // <--- 关键！返回 NULL 表示这只是元数据定义，不是可执行代码
     }
@@ -509,11 +547,11 @@ ASTNode* parse_top_level() {
     DataType type = parse_type();
 
     // 2. 名字
-    char* name = current_token->value;
+    char* name = current_token.atom;
     eat(TOKEN_IDENTIFIER);
 
     // 3. 关键判断：向前看一个 Token
-    if (current_token->type == TOKEN_LPAREN) {
+    if (current_token.type == TOKEN_LPAREN) {
         // --- 情况 A: 是函数声明 ---
         eat(TOKEN_LPAREN);
 
@@ -522,7 +560,15 @@ ASTNode* parse_top_level() {
 
         eat(TOKEN_RPAREN);
 
+        // 每个函数一套新的局部作用域，参数在最外层
+        symtab_reset();
+        symtab_push_scope();
+        for (int i = 0; i < arg_count; i++) {
+            VarDeclNode* param = (VarDeclNode*)args[i];
+            declare_local(param->name, param->var_type, NULL);
+        }
         BlockStatementNode* body = (BlockStatementNode*)parse_block_statement();
+        symtab_pop_scope();
         
         // 创建并返回函数节点
         return (ASTNode*)create_function_declaration_node(name, args, arg_count, body);
@@ -533,14 +579,14 @@ ASTNode* parse_top_level() {
         ASTNode* init_expr = NULL;
 
         // 检查是不是数组声明: int a[10];
-        if (current_token->type == TOKEN_LBRACKET) {
+        if (current_token.type == TOKEN_LBRACKET) {
             eat(TOKEN_LBRACKET);
             // 这里为了简化，我们只支持数字字面量定义大小
-            if (current_token->type != TOKEN_INT) {
+            if (current_token.type != TOKEN_INT) {
                 fprintf(stderr, "Error: Array size must be a constant integer.\n");
                 exit(1);
             }
-            array_size = atoi(current_token->value); // 获取大小
+            array_size = token_to_int(&current_token); // 获取大小
             eat(TOKEN_INT);
             eat(TOKEN_RBRACKET);
             
@@ -548,7 +594,7 @@ ASTNode* parse_top_level() {
             eat(TOKEN_SEMICOLON);
         } else {
             // 普通变量逻辑: int a = 10;
-            if (current_token->type == TOKEN_ASSIGN) {
+            if (current_token.type == TOKEN_ASSIGN) {
                 eat(TOKEN_ASSIGN);
                 init_expr = parse_expression(); 
             }
@@ -564,11 +610,12 @@ ASTNode* parse_top_level() {
 // 返回 VarDeclNode* 的数组，通过指针参数返回 count
 ASTNode** parse_parameter_list(int* count) {
     *count = 0;
-    if (current_token->type == TOKEN_RPAREN) {
+    if (current_token.type == TOKEN_RPAREN) {
         return NULL; // 空参数列表
     }
 
     ASTNode** args = NULL;
+    int capacity = 0;
     
     // 类似于 do-while 结构，处理 "类型 变量名" + ","
     while (1) {
@@ -576,7 +623,7 @@ ASTNode** parse_parameter_list(int* count) {
         DataType type = parse_type();
 
         // 2. 解析参数名
-        char* param_name = current_token->value;
+        char* param_name = current_token.atom;
         eat(TOKEN_IDENTIFIER);
 
         // 3. 创建参数节点 (复用 VarDeclNode，虽然没有初始值，但在 AST 中可以视作声明)
@@ -584,12 +631,10 @@ ASTNode** parse_parameter_list(int* count) {
         VarDeclNode* param = create_var_decl_node(param_name, NULL, 0, type, NULL);
 
         // 4. 添加到数组
-        (*count)++;
-        args = realloc(args, sizeof(ASTNode*) * (*count));
-        args[(*count) - 1] = (ASTNode*)param;
+        args = append_node(args, count, &capacity, (ASTNode*)param);
 
         // 5. 如果是逗号，继续；如果是右括号，结束
-        if (current_token->type == TOKEN_COMMA) {
+        if (current_token.type == TOKEN_COMMA) {
             eat(TOKEN_COMMA);
         } else {
             break;
@@ -602,7 +647,7 @@ ASTNode** parse_parameter_list(int* count) {
 ASTNode* parse_if_statement() {
     // TODO:
     // 消费 "if" 关键字
-    eat(TOKEN_KEYWORD); // 消费 "if"
+    eat(TOKEN_KW_IF); // 消费 "if"
     // 消费 "("
     eat(TOKEN_LPAREN);
     // 解析括号内的条件表达式 (调用 parse_expression())
@@ -617,9 +662,9 @@ ASTNode* parse_if_statement() {
 
     // 此时 current_token 指向 then_body 之后的第一个 token
     // 我们检查它是不是关键字 "else"
-    if (current_token->type == TOKEN_KEYWORD && strcmp(current_token->value, "else") == 0) {
+    if (current_token.type == TOKEN_KW_ELSE) {
         // 既然存在 else，我们就要消费它
-        eat(TOKEN_KEYWORD);
+        eat(TOKEN_KW_ELSE);
         // 然后解析 else 后面的语句
         else_body = parse_statement();
     }
@@ -632,7 +677,7 @@ ASTNode* parse_if_statement() {
 
 // 解析 while 语句
 ASTNode* parse_while_statement() {
-    eat(TOKEN_KEYWORD); // 消费 "while"
+    eat(TOKEN_KW_WHILE); // 消费 "while"
     eat(TOKEN_LPAREN);
     ASTNode* condition = parse_expression();
     eat(TOKEN_RPAREN);
@@ -642,18 +687,19 @@ ASTNode* parse_while_statement() {
 
 // 新增 parse_for_statement
 ASTNode* parse_for_statement() {
-    eat(TOKEN_KEYWORD); // for
+    eat(TOKEN_KW_FOR); // for
     eat(TOKEN_LPAREN);  // (
+    symtab_push_scope(); // for (int i = ...) 里的 i 只在循环内可见
     
     // 1. 初始化部分
     ASTNode* init = NULL;
-    if (current_token->type != TOKEN_SEMICOLON) {
-        if (current_token->type == TOKEN_KEYWORD && strcmp(current_token->value, "int") == 0) {
+    if (current_token.type != TOKEN_SEMICOLON) {
+        if (current_token.type == TOKEN_KW_INT) {
             init = parse_variable_declaration(); 
         } else {
             // 这里为了支持 i=0 这种赋值表达式，我们手动处理一下
             ASTNode* left = parse_expression();
-            if (current_token->type == TOKEN_ASSIGN) {
+            if (current_token.type == TOKEN_ASSIGN) {
                 eat(TOKEN_ASSIGN);
                 ASTNode* right = parse_expression();
                 init = (ASTNode*)create_binary_op_node(left, TOKEN_ASSIGN, right);
@@ -668,22 +714,22 @@ ASTNode* parse_for_statement() {
 
     // 2. 条件部分
     ASTNode* cond = NULL;
-    if (current_token->type != TOKEN_SEMICOLON) {
+    if (current_token.type != TOKEN_SEMICOLON) {
         cond = parse_expression();
     }
     eat(TOKEN_SEMICOLON);
 
     // 3. 递增部分 (i = i + 1)
     ASTNode* inc = NULL;
-    if (current_token->type != TOKEN_RPAREN) {
+    if (current_token.type != TOKEN_RPAREN) {
         // [关键修改]：手动检查是否是赋值操作
         // 因为 parse_expression 目前不包含赋值逻辑
         
         ASTNode* left = parse_expression(); // 先解析 'i'
         
-        if (current_token->type == TOKEN_ASSIGN) {
+        if (current_token.type == TOKEN_ASSIGN) {
             // 如果后面跟的是 '='，说明是赋值
-            TokenType op = current_token->type; // TOKEN_ASSIGN
+            TokenType op = current_token.type; // TOKEN_ASSIGN
             eat(TOKEN_ASSIGN);
             ASTNode* right = parse_expression(); // 解析 'i + 1'
             // 组合成赋值节点
@@ -697,6 +743,7 @@ ASTNode* parse_for_statement() {
 
     // 4. 循环体
     ASTNode* body = parse_statement();
+    symtab_pop_scope();
 
     return (ASTNode*)create_for_statement_node(init, cond, inc, body);
 }
@@ -710,7 +757,7 @@ ASTNode* parse() {
     ProgramNode* prog = create_program_node();
 
     // 循环直到文件结束
-    while (current_token->type != TOKEN_EOF) {
+    while (current_token.type != TOKEN_EOF) {
         // [修改后] 调用新的通用解析函数
         ASTNode* node = parse_top_level();
         if (node != NULL) {
@@ -726,42 +773,37 @@ ASTNode* parse() {
 // AST 节点工厂函数
 // -----------
 NumericLiteralNode* create_numeric_literal(char* value) {
-    NumericLiteralNode* node = (NumericLiteralNode*)malloc(sizeof(NumericLiteralNode));
-    if (!node) { exit(1); }
+    NumericLiteralNode* node = (NumericLiteralNode*)new_node(sizeof(NumericLiteralNode));
     node->type = NODE_NUMERIC_LITERAL;
     node->value = value;
     return node;
 }
 
 BlockStatementNode* create_block_statement() {
-    BlockStatementNode* node = (BlockStatementNode*)malloc(sizeof(BlockStatementNode));
-    if (!node) { exit(1); }
+    BlockStatementNode* node = (BlockStatementNode*)new_node(sizeof(BlockStatementNode));
     node->type = NODE_BLOCK_STATEMENT;
     node->statements = NULL;
     node->count = 0;
+    node->capacity = 0;
     return node;
 }
 
 void add_statement_to_block(BlockStatementNode* block, ASTNode* statement) {
-    block->count++;
-    block->statements = realloc(block->statements, block->count * sizeof(ASTNode*));
-    if (!block->statements) { exit(1); }
-    block->statements[block->count - 1] = statement;
+    block->statements = append_node(block->statements, &block->count, &block->capacity, statement);
 }
 // 创建一个空的 Program 节点
 ProgramNode* create_program_node() {
-    ProgramNode* node = (ProgramNode*)malloc(sizeof(ProgramNode));
-    if (!node) { exit(1); }
+    ProgramNode* node = (ProgramNode*)new_node(sizeof(ProgramNode));
     node->type = NODE_PROGRAM;
     node->declarations = NULL;
     node->count = 0;
+    node->capacity = 0;
     return node;
 }
 
 // 创建一个函数声明节点
 FunctionDeclarationNode* create_function_declaration_node(char* name, struct ASTNode** args, int arg_count, BlockStatementNode* body) {
-    FunctionDeclarationNode* node = (FunctionDeclarationNode*)malloc(sizeof(FunctionDeclarationNode));
-    if (!node) { exit(1); }
+    FunctionDeclarationNode* node = (FunctionDeclarationNode*)new_node(sizeof(FunctionDeclarationNode));
     node->type = NODE_FUNCTION_DECL;
     node->name = name; // 接管 name 指针
     node->body = body; // 接管 body 指针
@@ -771,8 +813,7 @@ FunctionDeclarationNode* create_function_declaration_node(char* name, struct AST
 }
 
 FunctionCallNode* create_function_call_node(char* name, ASTNode** args, int arg_count) {
-    FunctionCallNode* node = (FunctionCallNode*)malloc(sizeof(FunctionCallNode));
-    if (!node) exit(1);
+    FunctionCallNode* node = (FunctionCallNode*)new_node(sizeof(FunctionCallNode));
     node->type = NODE_FUNCTION_CALL;
     node->name = name;
     node->args = args;
@@ -782,8 +823,7 @@ FunctionCallNode* create_function_call_node(char* name, ASTNode** args, int arg_
 
 // 创建一个返回语句节点
 ReturnStatementNode* create_return_statement_node(ASTNode* argument) {
-    ReturnStatementNode* node = (ReturnStatementNode*)malloc(sizeof(ReturnStatementNode));
-    if (!node) { exit(1); }
+    ReturnStatementNode* node = (ReturnStatementNode*)new_node(sizeof(ReturnStatementNode));
     node->type = NODE_RETURN_STATEMENT;
     node->argument = argument; // 接管 argument 指针
     return node;
@@ -791,29 +831,25 @@ ReturnStatementNode* create_return_statement_node(ASTNode* argument) {
 
 // 将一个函数声明添加到 Program 节点的列表中
 void add_declaration_to_program(ProgramNode* prog, struct ASTNode* decl) {
-    prog->count++;
-    prog->declarations = realloc(prog->declarations, prog->count * sizeof(ASTNode*));
-    if (!prog->declarations) { exit(1); }
-    prog->declarations[prog->count - 1] = decl;
+    prog->declarations = append_node(prog->declarations, &prog->count, &prog->capacity, decl);
 }
 
 // 创建一个 “变量声明” 节点
 VarDeclNode* create_var_decl_node(char* name, ASTNode* initial_value, int array_size, DataType var_type, char* struct_name){
-    VarDeclNode* node = (VarDeclNode*)malloc(sizeof(VarDeclNode));
-    if (!node) { exit(1); }
+    VarDeclNode* node = (VarDeclNode*)new_node(sizeof(VarDeclNode));
     node->type = NODE_VAR_DECL;
     node->name = name;                      // 接管 name 指针
     node->initial_value = initial_value;    // 接管 body 指针
     node->array_size = array_size;
     node->var_type = var_type;
     node->struct_name = struct_name;
+    node->stack_offset = 0;
     return node;
 }
 
 // 创建一个 “标识符” 节点
 IdentifierNode* create_identifier_node(char* name){
-    IdentifierNode* node = (IdentifierNode*)malloc(sizeof(IdentifierNode));
-    if (!node) { exit(1); }
+    IdentifierNode* node = (IdentifierNode*)new_node(sizeof(IdentifierNode));
     node->type = NODE_IDENTIFIER;
     node->name = name;
     return node;
@@ -821,8 +857,7 @@ IdentifierNode* create_identifier_node(char* name){
 
 // 创建一个 “二元运算” 节点
 BinaryOpNode* create_binary_op_node(ASTNode* left, TokenType op, ASTNode* right){
-    BinaryOpNode* node = (BinaryOpNode*)malloc(sizeof(BinaryOpNode));
-    if (!node) { exit(1); }
+    BinaryOpNode* node = (BinaryOpNode*)new_node(sizeof(BinaryOpNode));
     node->type = NODE_BINARY_OP;
     node->left = left;
     node->op = op;
@@ -832,8 +867,7 @@ BinaryOpNode* create_binary_op_node(ASTNode* left, TokenType op, ASTNode* right)
 
 // 创建一个 “if” 语句节点
 IfStatementNode* create_if_statement_node(ASTNode* condition, ASTNode* body, ASTNode* else_branch){
-    IfStatementNode* node = (IfStatementNode*)malloc(sizeof(IfStatementNode));
-    if (!node) { exit(1); }
+    IfStatementNode* node = (IfStatementNode*)new_node(sizeof(IfStatementNode));
     node->type = NODE_IF_STATEMENT;
     node->body = body;
     node->condition = condition;
@@ -843,8 +877,7 @@ IfStatementNode* create_if_statement_node(ASTNode* condition, ASTNode* body, AST
 
 // 创建一个 “while” 语句节点
 WhileStatementNode* create_while_statement_node(ASTNode* condition, ASTNode* body){
-    WhileStatementNode* node = (WhileStatementNode*)malloc(sizeof(WhileStatementNode));
-    if (!node) { exit(1); }
+    WhileStatementNode* node = (WhileStatementNode*)new_node(sizeof(WhileStatementNode));
     node->type = NODE_WHILE_STATEMENT;
     node->body = body;
     node->condition = condition;
@@ -853,8 +886,7 @@ WhileStatementNode* create_while_statement_node(ASTNode* condition, ASTNode* bod
 
 // 创建一个 一元操作符 节点
 UnaryOpNode* create_unary_op_node(TokenType op, ASTNode* operand){
-    UnaryOpNode* node = (UnaryOpNode*)malloc(sizeof(UnaryOpNode));
-    if (!node) { exit(1); }
+    UnaryOpNode* node = (UnaryOpNode*)new_node(sizeof(UnaryOpNode));
     node->type = NODE_UNARY_OP;
     node->op = op;
     node->operand = operand;
@@ -862,8 +894,7 @@ UnaryOpNode* create_unary_op_node(TokenType op, ASTNode* operand){
 }
 
 ArrayAccessNode* create_array_access_node(char* name, ASTNode* index) {
-    ArrayAccessNode* node = (ArrayAccessNode*)malloc(sizeof(ArrayAccessNode));
-    if (!node) { exit(1); }
+    ArrayAccessNode* node = (ArrayAccessNode*)new_node(sizeof(ArrayAccessNode));
     node->type = NODE_ARRAY_ACCESS;
     node->array_name = name;
     node->index = index;
@@ -871,8 +902,7 @@ ArrayAccessNode* create_array_access_node(char* name, ASTNode* index) {
 }
 
 StringLiteralNode* create_string_literal_node(char* value) {
-    StringLiteralNode* node = (StringLiteralNode*)malloc(sizeof(StringLiteralNode));
-    if (!node) exit(1);
+    StringLiteralNode* node = (StringLiteralNode*)new_node(sizeof(StringLiteralNode));
     node->type = NODE_STRING_LITERAL;
     node->value = value;
     node->original_id = -1; // 初始化为 -1，生成代码时再分配
@@ -880,8 +910,7 @@ StringLiteralNode* create_string_literal_node(char* value) {
 }
 
 ForStatementNode* create_for_statement_node(ASTNode* init, ASTNode* cond, ASTNode* inc, ASTNode* body) {
-    ForStatementNode* node = malloc(sizeof(ForStatementNode));
-    if (!node) exit(1);
+    ForStatementNode* node = new_node(sizeof(ForStatementNode));
     node->type = NODE_FOR_STATEMENT;
     node->init = init;
     node->condition = cond;
@@ -891,41 +920,107 @@ ForStatementNode* create_for_statement_node(ASTNode* init, ASTNode* cond, ASTNod
 }
 
 ASTNode* create_break_node() {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    if (!node) exit(1);
+    ASTNode* node = new_node(sizeof(ASTNode));
     node->type = NODE_BREAK;
     return node;
 }
 ASTNode* create_continue_node() {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    if (!node) exit(1);
+    ASTNode* node = new_node(sizeof(ASTNode));
     node->type = NODE_CONTINUE;
     return node;
 }
 
-StructDef struct_table[MAX_STRUCTS];
-int struct_count = 0;
+// --- 结构体表 ---
+// 按结构体名 (驻留指针) 哈希的开放寻址表，槽位里存 StructDef 指针，NULL 表示空
+static StructDef** struct_slots = NULL;
+static int struct_capacity = 0; // 总是 2 的幂
+static int struct_count = 0;
+
+static StructDef** lookup_struct_slot(StructDef** slots, int capacity, char* name) {
+    unsigned mask = (unsigned)capacity - 1;
+    unsigned i = hash_atom(name) & mask;
+    while (slots[i] != NULL && slots[i]->name != name) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+// 负载因子超过 3/4 时容量翻倍 (旧表留在 arena 里，最后一起释放)
+static void grow_struct_table() {
+    int new_capacity = struct_capacity == 0 ? 64 : struct_capacity * 2;
+    StructDef** fresh = (StructDef**)arena_alloc(&ast_arena, new_capacity * sizeof(StructDef*));
+    memset(fresh, 0, new_capacity * sizeof(StructDef*));
+    for (int i = 0; i < struct_capacity; i++) {
+        if (struct_slots[i] != NULL) {
+            *lookup_struct_slot(fresh, new_capacity, struct_slots[i]->name) = struct_slots[i];
+        }
+    }
+    struct_slots = fresh;
+    struct_capacity = new_capacity;
+}
 
 // 定义一个新的结构体
 StructDef* define_struct(char* name) {
-    if (struct_count >= MAX_STRUCTS) {
-        fprintf(stderr, "Error: Too many structs defined.\n");
+    if ((struct_count + 1) * 4 > struct_capacity * 3) {
+        grow_struct_table();
+    }
+    StructDef** slot = lookup_struct_slot(struct_slots, struct_capacity, name);
+    if (*slot != NULL) {
+        fprintf(stderr, "Error: Redefinition of struct %s.\n", name);
         exit(1);
     }
-    StructDef* s = &struct_table[struct_count++];
+    StructDef* s = (StructDef*)new_node(sizeof(StructDef));
     s->name = name;
+    s->members = NULL;
     s->member_count = 0;
+    s->member_capacity = 0;
+    s->member_index = NULL;
+    s->member_index_capacity = 0;
     s->size = 0;
+    *slot = s;
+    struct_count++;
     return s;
 }
 
+// 在 index 里找到 member_name 所在的槽位；不存在时返回它应该插入的空槽位
+static int* lookup_member_slot(StructDef* s, int* index, int capacity, char* member_name) {
+    unsigned mask = (unsigned)capacity - 1;
+    unsigned i = hash_atom(member_name) & mask;
+    while (index[i] != 0 && s->members[index[i] - 1].name != member_name) {
+        i = (i + 1) & mask;
+    }
+    return &index[i];
+}
+
+static void grow_member_index(StructDef* s) {
+    int new_capacity = s->member_index_capacity == 0 ? 16 : s->member_index_capacity * 2;
+    int* fresh = (int*)arena_alloc(&ast_arena, new_capacity * sizeof(int));
+    memset(fresh, 0, new_capacity * sizeof(int));
+    for (int i = 0; i < s->member_count; i++) {
+        *lookup_member_slot(s, fresh, new_capacity, s->members[i].name) = i + 1;
+    }
+    s->member_index = fresh;
+    s->member_index_capacity = new_capacity;
+}
+
 // 向结构体添加成员
 void add_struct_member(StructDef* s, char* member_name, DataType type) {
-    if (s->member_count >= MAX_MEMBERS) {
-        fprintf(stderr, "Error: Too many members in struct %s.\n", s->name);
+    if ((s->member_count + 1) * 4 > s->member_index_capacity * 3) {
+        grow_member_index(s);
+    }
+    int* slot = lookup_member_slot(s, s->member_index, s->member_index_capacity, member_name);
+    if (*slot != 0) {
+        fprintf(stderr, "Error: Duplicate member %s in struct %s.\n", member_name, s->name);
         exit(1);
     }
-    MemberInfo* m = &s->members[s->member_count++];
+    if (s->member_count == s->member_capacity) {
+        int new_capacity = s->member_capacity == 0 ? 8 : s->member_capacity * 2;
+        s->members = (MemberInfo*)arena_grow(&ast_arena, s->members, s->member_capacity,
+                                             new_capacity, sizeof(MemberInfo));
+        s->member_capacity = new_capacity;
+    }
+    MemberInfo* m = &s->members[s->member_count];
+    *slot = ++s->member_count;
     m->name = member_name;
     m->type = type;
     
@@ -937,29 +1032,23 @@ void add_struct_member(StructDef* s, char* member_name, DataType type) {
 
 // 查找结构体定义
 StructDef* find_struct(char* name) {
-    for(int i=0; i<struct_count; i++) {
-        if(strcmp(struct_table[i].name, name) == 0) {
-            return &struct_table[i];
-        }
-    }
-    return NULL;
+    if (struct_capacity == 0) return NULL;
+    return *lookup_struct_slot(struct_slots, struct_capacity, name);
 }
 
 // 查找结构体成员
 MemberInfo* find_struct_member(StructDef* s, char* member_name) {
-    for(int i=0; i<s->member_count; i++) {
-        if(strcmp(s->members[i].name, member_name) == 0) {
-            return &s->members[i];
-        }
-    }
-    return NULL;
+    if (s->member_index_capacity == 0) return NULL;
+    int slot = *lookup_member_slot(s, s->member_index, s->member_index_capacity, member_name);
+    return slot == 0 ? NULL : &s->members[slot - 1];
 }
 
-MemberAccessNode* create_member_access_node(char* var_name, char* member_name) {
-    MemberAccessNode* node = (MemberAccessNode*)malloc(sizeof(MemberAccessNode));
-    if (!node) { exit(1); }
+MemberAccessNode* create_member_access_node(char* var_name, char* member_name, MemberInfo* member) {
+    MemberAccessNode* node = (MemberAccessNode*)new_node(sizeof(MemberAccessNode));
     node->type = NODE_MEMBER_ACCESS;
     node->struct_var_name = var_name;
     node->member_name = member_name;
+    node->member_offset = member->offset;
+    node->member_type = member->type;
     return node;
 }
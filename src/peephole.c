@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "peephole.h"
+#include "emit.h"
+#include "arena.h"
+
+int peephole_window = 4;
+
+// 汇编的一行。指令行拆成助记符和 (最多两个) 操作数，改写时重新拼出 text
+typedef enum {
+    LINE_INSTR,     // "  add rax, 1"
+    LINE_LABEL,     // ".L_end_0:"
+    LINE_OTHER,     // 伪指令、空行等，规则从不跨过它们
+} LineKind;
+
+typedef struct {
+    LineKind kind;
+    int deleted;
+    char* text;     // 整行 (不含换行符)
+    char* op;       // 指令：助记符；标签：标签名 (不含冒号)
+    char* a;        // 第一个操作数，没有为 NULL
+    char* b;        // 第二个操作数，没有为 NULL
+} Line;
+
+static Line* lines;
+static int line_count;
+static Arena strings;   // 改写产生的新文本、拆出来的操作数
+
+// --- 小工具 ---
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static char* copy_trimmed(const char* start, const char* end) {
+    while (start < end && is_space(*start)) start++;
+    while (end > start && is_space(end[-1])) end--;
+    return arena_strndup(&strings, start, end - start);
+}
+
+static int same(const char* x, const char* y) {
+    return x && y && strcmp(x, y) == 0;
+}
+
+static const char* reg64_names[] = {
+    "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+static const char* reg8_names[] = {
+    "al", "bl", "cl", "dl", "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b",
+};
+#define NUM_REGS ((int)(sizeof(reg64_names) / sizeof(reg64_names[0])))
+
+// 是 64 位通用寄存器就返回编号，否则 -1
+static int reg64_index(const char* s) {
+    for (int i = 0; s && i < NUM_REGS; i++) {
+        if (strcmp(s, reg64_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int is_register(const char* s) {
+    if (reg64_index(s) != -1) return 1;
+    for (int i = 0; s && i < NUM_REGS; i++) {
+        if (strcmp(s, reg8_names[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// 条件码和它的反面：e <-> ne, l <-> ge ...
+static const char* condition_pairs[][2] = {
+    {"e", "ne"}, {"z", "nz"}, {"l", "ge"}, {"le", "g"}, {"b", "ae"}, {"be", "a"},
+};
+
+static const char* invert_condition(const char* cc) {
+    for (int i = 0; i < (int)(sizeof(condition_pairs) / sizeof(condition_pairs[0])); i++) {
+        if (strcmp(cc, condition_pairs[i][0]) == 0) return condition_pairs[i][1];
+        if (strcmp(cc, condition_pairs[i][1]) == 0) return condition_pairs[i][0];
+    }
+    return NULL;
+}
+
+// op 是 prefix + 条件码 (比如 "jge"、"setl")，返回条件码，否则 NULL
+static const char* condition_of(const char* op, const char* prefix) {
+    size_t n = strlen(prefix);
+    if (strncmp(op, prefix, n) != 0) return NULL;
+    return invert_condition(op + n) ? op + n : NULL;
+}
+
+static int is_instr(Line* line, const char* op) {
+    return line->kind == LINE_INSTR && strcmp(line->op, op) == 0;
+}
+
+static int is_conditional_jump(Line* line) {
+    return line->kind == LINE_INSTR && condition_of(line->op, "j") != NULL;
+}
+
+// 把一行改写成新指令 (b 可以为 NULL)
+static void set_instr(Line* line, const char* op, const char* a, const char* b) {
+    size_t size = strlen(op) + strlen(a) + (b ? strlen(b) : 0) + 8;
+    char* text = (char*)arena_alloc(&strings, size);
+    if (b) snprintf(text, size, "  %s %s, %s", op, a, b);
+    else snprintf(text, size, "  %s %s", op, a);
+    line->text = text;
+    line->op = arena_strndup(&strings, op, strlen(op));
+    line->a = arena_strndup(&strings, a, strlen(a));
+    line->b = b ? arena_strndup(&strings, b, strlen(b)) : NULL;
+}
+
+// --- 规则 ---
+// 每条规则拿到从当前行开始的 n 行 (已删除的行跳过)，匹配上就改写并返回 1。
+// 规则可以认为 flags 不会跨过跳转活着 (两个后端生成的代码在读 flags 之前总会重新比较)。
+
+// mov rax, rax
+static int rule_self_move(Line** w, int n) {
+    (void)n;
+    if (!is_instr(w[0], "mov") || !same(w[0]->a, w[0]->b) || !is_register(w[0]->a)) return 0;
+    w[0]->deleted = 1;
+    return 1;
+}
+
+// push X; pop Y -> mov Y, X (X、Y 至少有一个是寄存器，mov 不能从内存搬到内存)
+static int rule_push_pop(Line** w, int n) {
+    (void)n;
+    if (!is_instr(w[0], "push") || !is_instr(w[1], "pop")) return 0;
+    int same_operand = same(w[0]->a, w[1]->a);
+    if (!same_operand && !is_register(w[0]->a) && !is_register(w[1]->a)) return 0;
+    if (same_operand) {
+        w[0]->deleted = 1;
+    } else {
+        set_instr(w[0], "mov", w[1]->a, w[0]->a);
+    }
+    w[1]->deleted = 1;
+    return 1;
+}
+
+// mov X, R; mov R, X -> 第二条多余 (R 里的值已经等于 X)
+static int rule_store_reload(Line** w, int n) {
+    (void)n;
+    if (!is_instr(w[0], "mov") || !is_instr(w[1], "mov")) return 0;
+    if (!is_register(w[0]->b) || !same(w[0]->a, w[1]->b) || !same(w[0]->b, w[1]->a)) return 0;
+    w[1]->deleted = 1;
+    return 1;
+}
+
+// setCC al; movzx rax, al; cmp rax, 0 (或 test rax, rax); je L -> setCC al; movzx rax, al; jNCC L
+// setCC 和 movzx 不改 flags，所以原来那次比较的结果可以直接拿来跳转
+static int rule_setcc_branch(Line** w, int n) {
+    (void)n;
+    const char* cc = w[0]->kind == LINE_INSTR ? condition_of(w[0]->op, "set") : NULL;
+    if (!cc || !is_instr(w[1], "movzx")) return 0;
+    int tests_zero = (is_instr(w[2], "cmp") && same(w[2]->b, "0")) ||
+                     (is_instr(w[2], "test") && same(w[2]->b, w[2]->a));
+    if (!tests_zero || !same(w[1]->b, w[0]->a) || !same(w[2]->a, w[1]->a)) return 0;
+    int r = reg64_index(w[1]->a);
+    if (r == -1 || strcmp(w[1]->b, reg8_names[r]) != 0) return 0;
+
+    const char* branch_cc;
+    if (is_instr(w[3], "je")) branch_cc = invert_condition(cc); // 结果为 0 时跳 = 条件不成立时跳
+    else if (is_instr(w[3], "jne")) branch_cc = cc;
+    else return 0;
+
+    char op[8];
+    snprintf(op, sizeof(op), "j%s", branch_cc);
+    set_instr(w[3], op, w[3]->a, NULL);
+    w[2]->deleted = 1;
+    return 1;
+}
+
+// jmp L 后面紧跟着 (若干标签里有) L: -> 删掉 jmp
+static int rule_jump_to_next(Line** w, int n) {
+    if (!is_instr(w[0], "jmp")) return 0;
+    for (int i = 1; i < n && w[i]->kind == LINE_LABEL; i++) {
+        if (strcmp(w[i]->op, w[0]->a) == 0) {
+            w[0]->deleted = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// jCC L1; jmp L2; L1: -> jNCC L2; L1:
+static int rule_branch_over_jump(Line** w, int n) {
+    (void)n;
+    if (!is_conditional_jump(w[0]) || !is_instr(w[1], "jmp")) return 0;
+    if (w[2]->kind != LINE_LABEL || strcmp(w[2]->op, w[0]->a) != 0) return 0;
+    char op[8];
+    snprintf(op, sizeof(op), "j%s", invert_condition(w[0]->op + 1));
+    set_instr(w[0], op, w[1]->a, NULL);
+    w[1]->deleted = 1;
+    return 1;
+}
+
+// jmp / ret 后面、下一个标签之前的指令永远执行不到
+static int rule_unreachable(Line** w, int n) {
+    (void)n;
+    if (!is_instr(w[0], "jmp") && !is_instr(w[0], "ret")) return 0;
+    if (w[1]->kind != LINE_INSTR) return 0;
+    w[1]->deleted = 1;
+    return 1;
+}
+
+typedef struct {
+    const char* name;
+    int size;                       // 至少需要窗口里有几行
+    int (*apply)(Line** w, int n);
+    long count;                     // 改写次数 (统计用)
+} PeepholeRule;
+
+static PeepholeRule rules[] = {
+    {"self-move",          1, rule_self_move,        0},
+    {"push-pop",           2, rule_push_pop,         0},
+    {"store-reload",       2, rule_store_reload,     0},
+    {"setcc-branch",       4, rule_setcc_branch,     0},
+    {"jump-to-next",       2, rule_jump_to_next,     0},
+    {"branch-over-jump",   3, rule_branch_over_jump, 0},
+    {"unreachable",        2, rule_unreachable,      0},
+};
+#define NUM_RULES ((int)(sizeof(rules) / sizeof(rules[0])))
+
+// --- 驱动 ---
+
+// 把缓冲区 (会被就地切开) 拆成行
+static void split_lines(char* text, size_t length) {
+    int capacity = 1024;
+    lines = (Line*)malloc(capacity * sizeof(Line));
+    line_count = 0;
+    char* end = text + length;
+    while (text < end) {
+        char* newline = memchr(text, '\n', end - text);
+        if (!newline) newline = end;
+        *newline = '\0';
+
+        if (line_count == capacity) {
+            capacity *= 2;
+            lines = (Line*)realloc(lines, capacity * sizeof(Line));
+        }
+        if (!lines) {
+            fprintf(stderr, "Error: Out of memory (peephole)\n");
+            exit(1);
+        }
+        Line* line = &lines[line_count++];
+        memset(line, 0, sizeof(Line));
+        line->text = text;
+        line->kind = LINE_OTHER;
+
+        size_t len = newline - text;
+        if (len > 0 && is_space(text[0])) {
+            char* p = text;
+            while (is_space(*p)) p++;
+            char* op_end = p;
+            while (*op_end && !is_space(*op_end)) op_end++;
+            if (op_end > p && *p != '.') { // ".string" 这类缩进的伪指令不算指令
+                line->kind = LINE_INSTR;
+                line->op = copy_trimmed(p, op_end);
+                char* comma = NULL;
+                int depth = 0;
+                for (char* q = op_end; *q; q++) {
+                    if (*q == '[') depth++;
+                    else if (*q == ']') depth--;
+                    else if (*q == ',' && depth == 0) { comma = q; break; }
+                }
+                char* operands_end = text + len;
+                if (comma) {
+                    line->a = copy_trimmed(op_end, comma);
+                    line->b = copy_trimmed(comma + 1, operands_end);
+                } else {
+                    line->a = copy_trimmed(op_end, operands_end);
+                    if (line->a[0] == '\0') line->a = NULL;
+                }
+            }
+        } else if (len > 1 && text[len - 1] == ':') {
+            line->kind = LINE_LABEL;
+            line->op = copy_trimmed(text, text + len - 1);
+        }
+        text = newline + 1;
+    }
+}
+
+void peephole_optimize() {
+    if (peephole_window <= 0) return;
+
+    size_t length;
+    const char* buffer = emit_buffer(&length);
+    char* text = (char*)malloc(length + 1);
+    if (!text) {
+        fprintf(stderr, "Error: Out of memory (peephole)\n");
+        exit(1);
+    }
+    memcpy(text, buffer, length + 1);
+    split_lines(text, length);
+
+    Line** window = (Line**)malloc(peephole_window * sizeof(Line*));
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < line_count; i++) {
+            if (lines[i].deleted) continue;
+            int n = 0;
+            for (int j = i; j < line_count && n < peephole_window; j++) {
+                if (!lines[j].deleted) window[n++] = &lines[j];
+            }
+            for (int r = 0; r < NUM_RULES; r++) {
+                if (rules[r].size > n) continue;
+                if (rules[r].apply(window, n)) {
+                    rules[r].count++;
+                    changed = 1;
+                    break;
+                }
+            }
+        }
+    }
+    free(window);
+
+    emit_reset();
+    for (int i = 0; i < line_count; i++) {
+        if (lines[i].deleted) continue;
+        emit_str(lines[i].text);
+        emit_str("\n");
+    }
+
+    free(lines);
+    free(text);
+    lines = NULL;
+    arena_free(&strings);
+}
+
+void peephole_print_stats() {
+    long total = 0;
+    fprintf(stderr, "peephole (window %d):\n", peephole_window);
+    for (int r = 0; r < NUM_RULES; r++) {
+        fprintf(stderr, "  %-18s %ld\n", rules[r].name, rules[r].count);
+        total += rules[r].count;
+    }
+    fprintf(stderr, "  %-18s %ld\n", "total", total);
+}
@@ -0,0 +1,19 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+// --- 窥孔优化 (Peephole Optimizer) ---
+// 代码生成结束后、写出之前，对 emitter 缓冲区里的汇编文本做指令级的局部改写：
+// 在一个最多 peephole_window 行的滑动窗口里按规则表逐条匹配，
+// 匹配上就改写 (删掉或替换几行)，一直扫到没有规则能再匹配为止。
+// 规则只看窗口里的文本，不依赖是哪个后端生成的。
+
+// 窗口大小 (一次最多看几行，标签也算一行)，0 表示关闭窥孔优化。
+// 需要的行数比窗口大的规则不会生效。
+extern int peephole_window;
+
+// 改写 emitter 缓冲区里的汇编
+void peephole_optimize();
+// 把每条规则改写了多少次打印到 stderr
+void peephole_print_stats();
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+
+// --- 寄存器分配：线性扫描 (linear scan) ---
+//   1. 按块的布局顺序给指令编号：第 k 条指令在 2k 读操作数，在 2k+1 写结果；
+//   2. 活跃性分析 (live-in / live-out 位集合，迭代到不动点)；
+//   3. 每个 vreg 的活跃区间取所有出现位置和活跃块的 "外包" [start, end] (不记空洞)；
+//   4. 按 start 扫描，区间结束就归还寄存器；不够时溢出结束得最晚的那个。
+// 跨过 call 的区间只能用被调用者保存的寄存器 (rbx, r12-r15)，call 不会破坏它们；
+// 不跨 call 的优先用调用者保存的寄存器 (rdi, rsi, rcx, r8, r9)，不用在序言里保存。
+
+const char* preg_names[NUM_PREGS] = {
+    "rbx", "r12", "r13", "r14", "r15", "rdi", "rsi", "rcx", "r8", "r9"
+};
+const char* preg_names8[NUM_PREGS] = {
+    "bl", "r12b", "r13b", "r14b", "r15b", "dil", "sil", "cl", "r8b", "r9b"
+};
+
+typedef struct {
+    int vreg;
+    int start;
+    int end;
+    int crosses_call;
+} Interval;
+
+static IRFunction* fn;
+static int words;           // 一个位集合有几个 64 位字
+
+static void* xmalloc(size_t size) {
+    void* p = calloc(1, size > 0 ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Error: Out of memory (register allocation)\n");
+        exit(1);
+    }
+    return p;
+}
+
+#define BIT_SET(set, v) ((set)[(v) >> 6] |= 1ull << ((v) & 63))
+#define BIT_GET(set, v) (((set)[(v) >> 6] >> ((v) & 63)) & 1)
+
+// 对指令的每个操作数 vreg 调用 visit(v, ctx)
+static void for_each_use(IRInstr* in, void (*visit)(int, void*), void* ctx) {
+    if (in->a != -1) visit(in->a, ctx);
+    if (in->b != -1) visit(in->b, ctx);
+    for (int i = 0; i < in->nargs; i++) visit(in->args[i], ctx);
+}
+
+typedef struct {
+    unsigned long long* use;
+    unsigned long long* def;
+} UseDef;
+
+static void record_use(int v, void* ctx) {
+    UseDef* ud = (UseDef*)ctx;
+    if (!BIT_GET(ud->def, v)) BIT_SET(ud->use, v); // 块里先用后定义的才算 "向上暴露"
+}
+
+// live_in = use ∪ (live_out - def)，live_out = ∪ 后继的 live_in
+static void compute_liveness(unsigned long long* live_in, unsigned long long* live_out) {
+    int n = fn->nblocks;
+    unsigned long long* use = (unsigned long long*)xmalloc((size_t)n * words * 8);
+    unsigned long long* def = (unsigned long long*)xmalloc((size_t)n * words * 8);
+
+    for (int b = 0; b < n; b++) {
+        UseDef ud = {use + (size_t)b * words, def + (size_t)b * words};
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            for_each_use(in, record_use, &ud);
+            if (in->dst != -1) BIT_SET(ud.def, in->dst);
+        }
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = n - 1; b >= 0; b--) {
+            BasicBlock* block = fn->blocks[b];
+            unsigned long long* out = live_out + (size_t)b * words;
+            unsigned long long* in = live_in + (size_t)b * words;
+            for (int s = 0; s < block->nsucc; s++) {
+                unsigned long long* succ_in = live_in + (size_t)block->succ[s]->id * words;
+                for (int w = 0; w < words; w++) out[w] |= succ_in[w];
+            }
+            for (int w = 0; w < words; w++) {
+                unsigned long long value = use[(size_t)b * words + w] | (out[w] & ~def[(size_t)b * words + w]);
+                if (value != in[w]) {
+                    in[w] = value;
+                    changed = 1;
+                }
+            }
+        }
+    }
+    free(use);
+    free(def);
+}
+
+static Interval* intervals;     // 按 vreg 编号
+static int* call_positions;     // 所有 call 的位置 (升序)
+static int call_count;
+
+static void extend(int v, int pos) {
+    Interval* it = &intervals[v];
+    if (it->start == -1 || pos < it->start) it->start = pos;
+    if (pos > it->end) it->end = pos;
+}
+
+static void extend_use(int v, void* ctx) {
+    extend(v, *(int*)ctx);
+}
+
+static void build_intervals() {
+    int n = fn->nblocks;
+    unsigned long long* live_in = (unsigned long long*)xmalloc((size_t)n * words * 8);
+    unsigned long long* live_out = (unsigned long long*)xmalloc((size_t)n * words * 8);
+    compute_liveness(live_in, live_out);
+
+    int ninstrs = 0;
+    for (int b = 0; b < n; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) ninstrs++;
+    }
+    call_positions = (int*)xmalloc(ninstrs * sizeof(int));
+    call_count = 0;
+
+    for (int v = 0; v < fn->nvregs; v++) {
+        intervals[v].vreg = v;
+        intervals[v].start = intervals[v].end = -1;
+    }
+
+    int k = 0;
+    for (int b = 0; b < n; b++) {
+        int first = k;
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next, k++) {
+            int use_pos = 2 * k;
+            for_each_use(in, extend_use, &use_pos);
+            if (in->dst != -1) extend(in->dst, 2 * k + 1);
+            if (in->op == IR_CALL) call_positions[call_count++] = 2 * k;
+        }
+        int last = k - 1;
+        for (int w = 0; w < words; w++) {
+            unsigned long long in_bits = live_in[(size_t)b * words + w];
+            unsigned long long out_bits = live_out[(size_t)b * words + w];
+            while (in_bits) {
+                extend(w * 64 + __builtin_ctzll(in_bits), 2 * first);
+                in_bits &= in_bits - 1;
+            }
+            while (out_bits) {
+                extend(w * 64 + __builtin_ctzll(out_bits), 2 * last + 1);
+                out_bits &= out_bits - 1;
+            }
+        }
+    }
+
+    // 区间严格包住某个 call (在 call 之前就活着，call 之后还要用)
+    for (int v = 0; v < fn->nvregs; v++) {
+        Interval* it = &intervals[v];
+        it->crosses_call = 0;
+        for (int c = 0; c < call_count && it->start != -1; c++) {
+            if (it->start < call_positions[c] && it->end > call_positions[c] + 1) {
+                it->crosses_call = 1;
+                break;
+            }
+        }
+    }
+
+    free(live_in);
+    free(live_out);
+    free(call_positions);
+}
+
+static int compare_start(const void* x, const void* y) {
+    const Interval* a = *(const Interval* const*)x;
+    const Interval* b = *(const Interval* const*)y;
+    if (a->start != b->start) return a->start - b->start;
+    return a->vreg - b->vreg;
+}
+
+// 区间 it 能不能放进寄存器 r
+static int usable(Interval* it, int r) {
+    return !it->crosses_call || r < NUM_CALLEE_SAVED;
+}
+
+void regalloc(IRFunction* f, RegAllocation* out) {
+    fn = f;
+    words = (fn->nvregs + 63) / 64;
+    if (words == 0) words = 1;
+    intervals = (Interval*)xmalloc(fn->nvregs * sizeof(Interval));
+    build_intervals();
+
+    out->reg = (int*)xmalloc(fn->nvregs * sizeof(int));
+    out->nspilled = 0;
+    out->callee_saved_used = 0;
+
+    // copy 的结果尽量和源操作数用同一个寄存器，这样 copy 就消失了
+    int* copy_source = (int*)xmalloc(fn->nvregs * sizeof(int));
+    for (int v = 0; v < fn->nvregs; v++) copy_source[v] = -1;
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (in->op == IR_COPY) copy_source[in->dst] = in->a;
+        }
+    }
+
+    Interval** sorted = (Interval**)xmalloc(fn->nvregs * sizeof(Interval*));
+    int count = 0;
+    for (int v = 0; v < fn->nvregs; v++) {
+        out->reg[v] = REG_NONE;
+        if (intervals[v].start != -1) sorted[count++] = &intervals[v];
+    }
+    qsort(sorted, count, sizeof(Interval*), compare_start);
+
+    Interval* active[NUM_PREGS] = {0}; // 每个寄存器当前被哪个区间占着
+
+    for (int i = 0; i < count; i++) {
+        Interval* cur = sorted[i];
+
+        // 1. 结束在 cur 开始之前的区间把寄存器还回来
+        for (int r = 0; r < NUM_PREGS; r++) {
+            if (active[r] && active[r]->end < cur->start) active[r] = NULL;
+        }
+
+        // 2. 找一个空闲的寄存器：先看提示，再看调用者保存的，最后被调用者保存的
+        int chosen = -1;
+        int src = copy_source[cur->vreg];
+        if (src != -1 && out->reg[src] >= 0 && !active[out->reg[src]] && usable(cur, out->reg[src])) {
+            chosen = out->reg[src];
+        }
+        for (int r = NUM_CALLEE_SAVED; r < NUM_PREGS && chosen == -1; r++) {
+            if (!active[r] && usable(cur, r)) chosen = r;
+        }
+        for (int r = 0; r < NUM_CALLEE_SAVED && chosen == -1; r++) {
+            if (!active[r]) chosen = r;
+        }
+
+        // 3. 没有空闲的：在能用的寄存器里找结束得最晚的区间，比 cur 晚就把它溢出，否则溢出 cur
+        if (chosen == -1) {
+            int victim = -1;
+            for (int r = 0; r < NUM_PREGS; r++) {
+                if (!usable(cur, r) || !active[r]) continue;
+                if (victim == -1 || active[r]->end > active[victim]->end) victim = r;
+            }
+            if (victim != -1 && active[victim]->end > cur->end) {
+                out->reg[active[victim]->vreg] = REG_SPILLED;
+                out->nspilled++;
+                chosen = victim;
+            } else {
+                out->reg[cur->vreg] = REG_SPILLED;
+                out->nspilled++;
+                continue;
+            }
+        }
+
+        active[chosen] = cur;
+        out->reg[cur->vreg] = chosen;
+        if (chosen < NUM_CALLEE_SAVED) out->callee_saved_used |= 1u << chosen;
+    }
+
+    free(sorted);
+    free(copy_source);
+    free(intervals);
+}
+
+void regalloc_free(RegAllocation* alloc) {
+    free(alloc->reg);
+    alloc->reg = NULL;
+}
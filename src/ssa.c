@@ -0,0 +1,521 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+
+// --- SSA 构造 (mem2reg) 与消除 ---
+// 构造用的是经典做法：
+//   1. 支配树 (Cooper-Harvey-Kennedy 迭代算法，按逆后序)；
+//   2. 支配边界 (dominance frontier)；
+//   3. 每个被提升的变量在它的 "写入块" 的迭代支配边界上放 phi；
+//   4. 沿支配树做一次重命名：loadvar 换成当前的值，storevar 压入新值。
+// 之后删掉平凡的 phi (所有输入都相同) 和没人用的纯计算。
+
+static void* xmalloc(size_t size) {
+    void* p = calloc(1, size > 0 ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Error: Out of memory (SSA)\n");
+        exit(1);
+    }
+    return p;
+}
+
+static IRFunction* fn;
+static int* rpo;            // 逆后序排列的块编号
+static int* rpo_index;      // 块编号 -> 在 rpo 里的位置
+static int* idom;           // 直接支配者 (入口块的是它自己)
+static int rpo_count;
+
+static void postorder(BasicBlock* block, char* visited) {
+    visited[block->id] = 1;
+    for (int i = 0; i < block->nsucc; i++) {
+        if (!visited[block->succ[i]->id]) postorder(block->succ[i], visited);
+    }
+    rpo[rpo_count++] = block->id;
+}
+
+static int intersect(int a, int b) {
+    while (a != b) {
+        while (rpo_index[a] > rpo_index[b]) a = idom[a];
+        while (rpo_index[b] > rpo_index[a]) b = idom[b];
+    }
+    return a;
+}
+
+static void compute_dominators() {
+    int n = fn->nblocks;
+    char* visited = (char*)xmalloc(n);
+    rpo = (int*)xmalloc(n * sizeof(int));
+    rpo_index = (int*)xmalloc(n * sizeof(int));
+    idom = (int*)xmalloc(n * sizeof(int));
+    rpo_count = 0;
+    postorder(fn->blocks[0], visited);
+    free(visited);
+    for (int i = 0; i < rpo_count / 2; i++) {
+        int t = rpo[i];
+        rpo[i] = rpo[rpo_count - 1 - i];
+        rpo[rpo_count - 1 - i] = t;
+    }
+    for (int i = 0; i < n; i++) {
+        rpo_index[rpo[i]] = i;
+        idom[i] = -1;
+    }
+
+    idom[0] = 0;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < n; i++) {
+            BasicBlock* block = fn->blocks[rpo[i]];
+            int new_idom = -1;
+            for (int p = 0; p < block->npreds; p++) {
+                int pred = block->preds[p]->id;
+                if (idom[pred] == -1) continue; // 还没处理到的前驱 (回边)
+                new_idom = new_idom == -1 ? pred : intersect(pred, new_idom);
+            }
+            if (idom[block->id] != new_idom) {
+                idom[block->id] = new_idom;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// 支配边界：每个块一个可增长的编号数组
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} IntList;
+
+static void list_add(IntList* list, int value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 4 : list->capacity * 2;
+        list->items = (int*)realloc(list->items, list->capacity * sizeof(int));
+        if (!list->items) {
+            fprintf(stderr, "Error: Out of memory (SSA)\n");
+            exit(1);
+        }
+    }
+    list->items[list->count++] = value;
+}
+
+static IntList* compute_frontiers() {
+    IntList* df = (IntList*)xmalloc(fn->nblocks * sizeof(IntList));
+    for (int b = 0; b < fn->nblocks; b++) {
+        BasicBlock* block = fn->blocks[b];
+        if (block->npreds < 2) continue;
+        for (int p = 0; p < block->npreds; p++) {
+            int runner = block->preds[p]->id;
+            while (runner != idom[b]) {
+                // 同一个 b 的各个前驱是连着处理的，所以只要看最后一个就能去重
+                IntList* list = &df[runner];
+                if (list->count == 0 || list->items[list->count - 1] != b) list_add(list, b);
+                runner = idom[runner];
+            }
+        }
+    }
+    return df;
+}
+
+// --- phi 的放置 ---
+
+static int promotable(int slot) {
+    IRSlot* s = &fn->slots[slot];
+    return s->is_scalar && !s->address_taken;
+}
+
+static void place_phis(IntList* df) {
+    int n = fn->nblocks;
+    int* has_phi = (int*)xmalloc(n * sizeof(int));   // 记录放过 phi 的变量编号+1
+    int* queued = (int*)xmalloc(n * sizeof(int));
+    int* worklist = (int*)xmalloc(n * sizeof(int));
+
+    for (int slot = 0; slot < fn->nslots; slot++) {
+        if (!promotable(slot)) continue;
+        int count = 0;
+        for (int b = 0; b < n; b++) {
+            for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+                if (in->op == IR_STOREVAR && in->slot == slot) {
+                    worklist[count++] = b;
+                    queued[b] = slot + 1;
+                    break;
+                }
+            }
+        }
+        while (count > 0) {
+            int b = worklist[--count];
+            for (int i = 0; i < df[b].count; i++) {
+                int target = df[b].items[i];
+                if (has_phi[target] == slot + 1) continue;
+                has_phi[target] = slot + 1;
+
+                BasicBlock* block = fn->blocks[target];
+                IRInstr* phi = ir_insert(block, block->head, IR_PHI);
+                phi->dst = ir_new_vreg(fn);
+                phi->slot = slot;
+                phi->nargs = block->npreds;
+                phi->args = (int*)ir_alloc(block->npreds * sizeof(int));
+                if (queued[target] != slot + 1) {
+                    queued[target] = slot + 1;
+                    worklist[count++] = target;
+                }
+            }
+        }
+    }
+    free(has_phi);
+    free(queued);
+    free(worklist);
+}
+
+// --- 重命名 ---
+
+static int* alias;          // loadvar 的结果 -> 它实际代表的值
+static IntList* stacks;     // 每个变量当前的值 (栈顶)
+static int* undef_value;    // 变量在写入之前被读时用的 0
+static int** children;      // 支配树的孩子
+static int* child_count;
+
+static int resolve(int v) {
+    return (v != -1 && alias[v] != -1) ? alias[v] : v;
+}
+
+// 读一个还没写过的变量 (C 里是未定义行为)：给它一个 0，放在入口块开头 (参数之后)
+static int undefined(int slot) {
+    if (undef_value[slot] == -1) {
+        BasicBlock* entry = fn->blocks[0];
+        IRInstr* pos = entry->head;
+        while (pos->op == IR_ARG) pos = pos->next;
+        IRInstr* zero = ir_insert(entry, pos, IR_CONST);
+        zero->dst = ir_new_vreg(fn);
+        zero->imm = 0;
+        undef_value[slot] = zero->dst;
+    }
+    return undef_value[slot];
+}
+
+static int current_value(int slot) {
+    IntList* stack = &stacks[slot];
+    return stack->count > 0 ? stack->items[stack->count - 1] : undefined(slot);
+}
+
+static void rename_block(BasicBlock* block) {
+    int* pushed = (int*)xmalloc((fn->nslots + 1) * sizeof(int));
+
+    IRInstr* in = block->head;
+    while (in) {
+        IRInstr* next = in->next;
+        if (in->op == IR_PHI) {
+            if (in->slot != -1 && promotable(in->slot)) {
+                list_add(&stacks[in->slot], in->dst);
+                pushed[in->slot]++;
+            }
+        } else {
+            in->a = resolve(in->a);
+            in->b = resolve(in->b);
+            if (in->op == IR_CALL) {
+                for (int i = 0; i < in->nargs; i++) in->args[i] = resolve(in->args[i]);
+            }
+
+            if (in->op == IR_LOADVAR && promotable(in->slot)) {
+                alias[in->dst] = current_value(in->slot);
+                ir_remove(block, in);
+            } else if (in->op == IR_STOREVAR && promotable(in->slot)) {
+                int value = in->a;
+                if (fn->slots[in->slot].is_char) {
+                    // char 变量只存 1 字节：提升以后要显式截断
+                    IRInstr* zext = ir_insert(block, in, IR_ZEXT8);
+                    zext->dst = ir_new_vreg(fn);
+                    zext->a = value;
+                    value = zext->dst;
+                }
+                list_add(&stacks[in->slot], value);
+                pushed[in->slot]++;
+                ir_remove(block, in);
+            }
+        }
+        in = next;
+    }
+
+    // 填后继里 phi 的输入
+    for (int s = 0; s < block->nsucc; s++) {
+        BasicBlock* succ = block->succ[s];
+        int index = 0;
+        while (succ->preds[index] != block) index++;
+        for (IRInstr* phi = succ->head; phi && phi->op == IR_PHI; phi = phi->next) {
+            phi->args[index] = current_value(phi->slot);
+        }
+    }
+
+    for (int i = 0; i < child_count[block->id]; i++) {
+        rename_block(fn->blocks[children[block->id][i]]);
+    }
+
+    for (int slot = 0; slot < fn->nslots; slot++) {
+        stacks[slot].count -= pushed[slot];
+    }
+    free(pushed);
+}
+
+static void rename_variables() {
+    int n = fn->nblocks;
+    // rename 过程中新建的 vreg (zext8 / undef) 只会被压进栈里，不会被 resolve，下标不用覆盖它们
+    alias = (int*)xmalloc(fn->nvregs * sizeof(int));
+    for (int i = 0; i < fn->nvregs; i++) alias[i] = -1;
+    stacks = (IntList*)xmalloc(fn->nslots * sizeof(IntList));
+    undef_value = (int*)xmalloc(fn->nslots * sizeof(int));
+    for (int i = 0; i < fn->nslots; i++) undef_value[i] = -1;
+
+    child_count = (int*)xmalloc(n * sizeof(int));
+    children = (int**)xmalloc(n * sizeof(int*));
+    for (int b = 1; b < n; b++) child_count[idom[b]]++;
+    for (int b = 0; b < n; b++) children[b] = (int*)xmalloc(child_count[b] * sizeof(int));
+    memset(child_count, 0, n * sizeof(int));
+    // 按逆后序加孩子，让重命名的顺序和块的顺序一致 (dump 出来的编号更好读)
+    for (int i = 1; i < n; i++) {
+        int b = rpo[i];
+        children[idom[b]][child_count[idom[b]]++] = b;
+    }
+
+    rename_block(fn->blocks[0]);
+
+    for (int b = 0; b < n; b++) free(children[b]);
+    for (int i = 0; i < fn->nslots; i++) free(stacks[i].items);
+    free(children);
+    free(child_count);
+    free(stacks);
+    free(undef_value);
+    free(alias);
+}
+
+// --- 清理 ---
+
+// 所有 vreg 的使用都换成 replace[v] (为 -1 的不变)
+static void replace_uses(int* replace) {
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (in->a != -1 && replace[in->a] != -1) in->a = replace[in->a];
+            if (in->b != -1 && replace[in->b] != -1) in->b = replace[in->b];
+            for (int i = 0; i < in->nargs; i++) {
+                if (replace[in->args[i]] != -1) in->args[i] = replace[in->args[i]];
+            }
+        }
+    }
+}
+
+// phi 的输入除了它自己以外只有一个值 v：它就是 v
+static void remove_trivial_phis() {
+    int* replace = (int*)xmalloc(fn->nvregs * sizeof(int));
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < fn->nvregs; i++) replace[i] = -1;
+        for (int b = 0; b < fn->nblocks; b++) {
+            BasicBlock* block = fn->blocks[b];
+            IRInstr* in = block->head;
+            while (in && in->op == IR_PHI) {
+                IRInstr* next = in->next;
+                int same = -1, trivial = 1;
+                for (int i = 0; i < in->nargs; i++) {
+                    int arg = replace[in->args[i]] != -1 ? replace[in->args[i]] : in->args[i];
+                    if (arg == in->dst || arg == same) continue;
+                    if (same != -1) { trivial = 0; break; }
+                    same = arg;
+                }
+                if (trivial && same != -1) {
+                    replace[in->dst] = same;
+                    ir_remove(block, in);
+                    changed = 1;
+                }
+                in = next;
+            }
+        }
+        if (changed) {
+            // 链式替换 (a -> b -> c) 压平成一步
+            for (int i = 0; i < fn->nvregs; i++) {
+                while (replace[i] != -1 && replace[replace[i]] != -1) replace[i] = replace[replace[i]];
+            }
+            replace_uses(replace);
+        }
+    }
+    free(replace);
+}
+
+static int has_side_effect(IROp op) {
+    switch (op) {
+        case IR_CALL:
+        case IR_STORE:
+        case IR_STORE8:
+        case IR_STOREVAR:
+        case IR_JMP:
+        case IR_BR:
+        case IR_RET:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// 标记-清除式的死代码删除：从有副作用的指令出发标记用到的值，没被标记的纯计算都删掉
+// (互相引用但没人用的 phi 环也能删掉)
+static void remove_dead_code() {
+    IRInstr** def = (IRInstr**)xmalloc(fn->nvregs * sizeof(IRInstr*));
+    char* live = (char*)xmalloc(fn->nvregs);
+    int* worklist = (int*)xmalloc(fn->nvregs * sizeof(int));
+    int count = 0;
+
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (in->dst != -1) def[in->dst] = in;
+        }
+    }
+
+#define MARK(v) do { int v_ = (v); if (v_ != -1 && !live[v_]) { live[v_] = 1; worklist[count++] = v_; } } while (0)
+    for (int b = 0; b < fn->nblocks; b++) {
+        for (IRInstr* in = fn->blocks[b]->head; in; in = in->next) {
+            if (!has_side_effect(in->op)) continue;
+            if (in->dst != -1) MARK(in->dst);
+            MARK(in->a);
+            MARK(in->b);
+            for (int i = 0; i < in->nargs; i++) MARK(in->args[i]);
+        }
+    }
+    while (count > 0) {
+        IRInstr* in = def[worklist[--count]];
+        if (!in) continue;
+        MARK(in->a);
+        MARK(in->b);
+        for (int i = 0; i < in->nargs; i++) MARK(in->args[i]);
+    }
+#undef MARK
+
+    for (int b = 0; b < fn->nblocks; b++) {
+        BasicBlock* block = fn->blocks[b];
+        IRInstr* in = block->head;
+        while (in) {
+            IRInstr* next = in->next;
+            if (!has_side_effect(in->op) && in->dst != -1 && !live[in->dst]) {
+                ir_remove(block, in);
+            }
+            in = next;
+        }
+    }
+    free(def);
+    free(live);
+    free(worklist);
+}
+
+void ssa_mem2reg(IRFunction* f) {
+    fn = f;
+    int any = 0;
+    for (int slot = 0; slot < fn->nslots; slot++) {
+        if (promotable(slot)) any = 1;
+    }
+    if (!any) return;
+
+    compute_dominators();
+    IntList* df = compute_frontiers();
+    place_phis(df);
+    for (int b = 0; b < fn->nblocks; b++) free(df[b].items);
+    free(df);
+
+    rename_variables();
+    for (int slot = 0; slot < fn->nslots; slot++) {
+        if (promotable(slot)) fn->slots[slot].promoted = 1;
+    }
+    remove_trivial_phis();
+    remove_dead_code();
+
+    free(rpo);
+    free(rpo_index);
+    free(idom);
+}
+
+// --- 离开 SSA ---
+// phi 在块的入口 "同时" 取值：从第 p 个前驱进来，等于在这条边上做一次并行赋值
+// (dst_1, dst_2, ...) = (args_1[p], args_2[p], ...)。
+// 前驱有多个后继时 (关键边)，先拆出一个只通向这个块的边块，赋值放在那里，不影响另一条路径。
+// 并行赋值按顺序展开成 copy：先做目标不再被别人读的；只剩环的时候 (交换) 借一个临时值拆开。
+// 这样 phi 的结果和输入在寄存器分配时通常能分到同一个寄存器，copy 就没了。
+
+static BasicBlock* split_edge(BasicBlock* pred, BasicBlock* block) {
+    BasicBlock* edge = ir_new_block(fn);
+    IRInstr* jump = ir_insert(edge, NULL, IR_JMP);
+    jump->target[0] = block;
+    IRInstr* term = pred->tail;
+    for (int i = 0; i < 2; i++) {
+        if (term->target[i] == block) term->target[i] = edge;
+    }
+    return edge;
+}
+
+static void emit_copy(BasicBlock* block, int dst, int src) {
+    IRInstr* copy = ir_insert(block, block->tail, IR_COPY);
+    copy->dst = dst;
+    copy->a = src;
+}
+
+static void sequentialize(BasicBlock* block, int* dst, int* src, int n) {
+    for (;;) {
+        int pending = 0, progress = 0;
+        for (int i = 0; i < n; i++) {
+            if (dst[i] == src[i]) continue;
+            pending++;
+            int blocked = 0;
+            for (int j = 0; j < n; j++) {
+                if (j != i && dst[j] != src[j] && src[j] == dst[i]) { blocked = 1; break; }
+            }
+            if (!blocked) {
+                emit_copy(block, dst[i], src[i]);
+                src[i] = dst[i];
+                progress = 1;
+            }
+        }
+        if (pending == 0) return;
+        if (progress) continue;
+        // 全都在环上：把其中一个目标的旧值先存进临时值，读它的都改成读临时值
+        for (int i = 0; i < n; i++) {
+            if (dst[i] == src[i]) continue;
+            int temp = ir_new_vreg(fn);
+            emit_copy(block, temp, dst[i]);
+            for (int j = 0; j < n; j++) {
+                if (dst[j] != src[j] && src[j] == dst[i]) src[j] = temp;
+            }
+            break;
+        }
+    }
+}
+
+void ssa_destruct(IRFunction* f) {
+    fn = f;
+    int nblocks = fn->nblocks; // 拆出来的边块追加在后面，不用处理
+    int changed = 0;
+    for (int b = 0; b < nblocks; b++) {
+        BasicBlock* block = fn->blocks[b];
+        if (!block->head || block->head->op != IR_PHI) continue;
+        changed = 1;
+
+        int nphis = 0;
+        for (IRInstr* phi = block->head; phi && phi->op == IR_PHI; phi = phi->next) nphis++;
+        int* dst = (int*)xmalloc(nphis * sizeof(int));
+        int* src = (int*)xmalloc(nphis * sizeof(int));
+
+        for (int p = 0; p < block->npreds; p++) {
+            BasicBlock* pred = block->preds[p];
+            BasicBlock* from = pred->nsucc > 1 ? split_edge(pred, block) : pred;
+            int n = 0;
+            for (IRInstr* phi = block->head; phi && phi->op == IR_PHI; phi = phi->next) {
+                dst[n] = phi->dst;
+                src[n] = phi->args[p];
+                n++;
+            }
+            sequentialize(from, dst, src, n);
+        }
+        while (block->head->op == IR_PHI) {
+            ir_remove(block, block->head);
+        }
+        free(dst);
+        free(src);
+    }
+    if (changed) ir_rebuild_cfg(fn);
+}
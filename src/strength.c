@@ -0,0 +1,120 @@
+#include "strength.h"
+#include "emit.h"
+#include "isel.h"
+
+// |c|，按无符号算 (LONG_MIN 也不会溢出)
+static unsigned long magnitude(long c) {
+    return c < 0 ? 0ul - (unsigned long)c : (unsigned long)c;
+}
+
+static int is_pow2(unsigned long u) {
+    return u != 0 && (u & (u - 1)) == 0;
+}
+
+static int log2_of(unsigned long u) {
+    return __builtin_ctzl(u);
+}
+
+// lea 一条指令能乘的因子：x*3 = x + x*2，x*5 = x + x*4，x*9 = x + x*8
+static int is_lea_factor(unsigned long m) {
+    return m == 3 || m == 5 || m == 9;
+}
+
+// --- 乘法 ---
+// |c| = m * 2^k，m 是 1、3/5/9、或者两个 3/5/9 的乘积 (15、25、27、45、81)：
+// 至多两条 lea 加一条 shl，负数最后再 neg
+
+int can_mul_by_constant(long c) {
+    unsigned long u = magnitude(c);
+    if (u == 0) return 1;
+    unsigned long m = u >> log2_of(u);
+    if (m == 1 || is_lea_factor(m)) return 1;
+    return (m % 3 == 0 && is_lea_factor(m / 3)) ||
+           (m % 5 == 0 && is_lea_factor(m / 5)) ||
+           (m % 9 == 0 && is_lea_factor(m / 9));
+}
+
+static void emit_lea_factor(const char* reg, unsigned long m) {
+    emit("  lea %s, [%s+%s*%d]\n", reg, reg, reg, (int)(m - 1));
+}
+
+void emit_mul_by_constant(const char* reg, long c) {
+    unsigned long u = magnitude(c);
+    if (u == 0) {
+        emit_load_constant(reg, 0);
+        return;
+    }
+    int k = log2_of(u);
+    unsigned long m = u >> k;
+    if (m != 1) {
+        unsigned long first = m;
+        for (unsigned long f = 3; !is_lea_factor(first); f = f == 3 ? 5 : 9) {
+            if (m % f == 0 && is_lea_factor(m / f)) first = f;
+        }
+        emit_lea_factor(reg, first);
+        if (m != first) emit_lea_factor(reg, m / first);
+    }
+    if (k > 0) emit("  shl %s, %d\n", reg, k);
+    if (c < 0) emit("  neg %s\n", reg);
+}
+
+// --- 除法 ---
+
+int can_div_by_constant(long c) {
+    return c != 0;
+}
+
+int div_needs_magic(long c) {
+    return !is_pow2(magnitude(c));
+}
+
+// 有符号除法向 0 取整，直接 sar 是向负无穷取整：
+// 被除数是负数时先加上 2^k - 1 (偏置)，再算术右移 k 位
+void emit_div_by_pow2(const char* reg, long c, const char* tmp) {
+    int k = log2_of(magnitude(c));
+    if (k > 0) {
+        emit("  mov %s, %s\n", tmp, reg);
+        if (k > 1) emit("  sar %s, 63\n", tmp);      // 负数: 全 1，非负数: 0
+        emit("  shr %s, %d\n", tmp, 64 - k);         // 负数: 2^k - 1，非负数: 0
+        emit("  add %s, %s\n", reg, tmp);
+        emit("  sar %s, %d\n", reg, k);
+    }
+    if (c < 0) emit("  neg %s\n", reg);
+}
+
+// 有符号除以常数 d (d >= 2，不是 2 的幂) 的魔数 M 和移位 s：
+//   q = (n * M) 的高 64 位 (M 是负数时再加上 n)，q >>= s，负数再加 1
+// (Granlund & Montgomery / Hacker's Delight 10-1)
+static void magic_for(unsigned long d, long* multiplier, int* shift) {
+    const unsigned long two63 = 1ul << 63;
+    unsigned long anc = two63 - 1 - two63 % d; // |nc|
+    int p = 63;
+    unsigned long q1 = two63 / anc, r1 = two63 - q1 * anc;
+    unsigned long q2 = two63 / d, r2 = two63 - q2 * d;
+    unsigned long delta;
+    do {
+        p++;
+        q1 *= 2; r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if (r2 >= d) { q2++; r2 -= d; }
+        delta = d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    *multiplier = (long)(q2 + 1);
+    *shift = p - 64;
+}
+
+void emit_div_by_magic(const char* n, long c) {
+    long multiplier;
+    int shift;
+    magic_for(magnitude(c), &multiplier, &shift);
+
+    emit("  mov rax, %ld\n", multiplier);
+    emit("  imul %s\n", n);                 // rdx:rax = n * M
+    if (multiplier < 0) emit("  add rdx, %s\n", n);
+    if (shift > 0) emit("  sar rdx, %d\n", shift);
+    emit("  mov rax, rdx\n");
+    emit("  shr rax, 63\n");                // 商是负数时加 1，向 0 取整
+    emit("  add rdx, rax\n");
+    if (c < 0) emit("  neg rdx\n");
+}
@@ -0,0 +1,23 @@
+#ifndef STRENGTH_H
+#define STRENGTH_H
+
+// --- 强度削弱：乘除常数的指令选择 (两个后端共用) ---
+// imul 要 3 个周期，idiv 要 20-40 个周期。乘以常数改成 shl / lea 的组合，
+// 除以常数改成移位 (2 的幂) 或者 "乘以魔数取高 64 位" (其它常数)。
+// 生成的指令直接写进 emitter，寄存器用名字 ("rax"、"r12") 传进来。
+
+// 乘以 c 能不能不用 imul
+int can_mul_by_constant(long c);
+// reg = reg * c，只用 reg 自己 (shl / lea / neg)。can_mul_by_constant(c) 为真时才能调用
+void emit_mul_by_constant(const char* reg, long c);
+
+// 除以 c 能不能不用 idiv (c 为 0 时不行，留给运行时报错)
+int can_div_by_constant(long c);
+// 除以 c 要不要走 emit_div_by_magic (否则走 emit_div_by_pow2)
+int div_needs_magic(long c);
+// reg = reg / c，c 是 ±1 或 ±2^k。tmp 是一个可以随便覆盖的寄存器 (不能是 reg)
+void emit_div_by_pow2(const char* reg, long c, const char* tmp);
+// rdx = n / c，会覆盖 rax 和 rdx，n 不能是 rax 或 rdx
+void emit_div_by_magic(const char* n, long c);
+
+#endif // STRENGTH_H
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strpool.h"
+#include "emit.h"
+#include "intern.h"
+
+int strpool_merge_suffixes = 0;
+
+// 池里的一个字符串。content 是源码里引号之间的原始文本 (转义序列原样保留，
+// 交给汇编器的 .string 去解释)，编号就是它在 entries 里的下标。
+typedef struct {
+    char* content;
+    int len;
+} StringEntry;
+
+static StringEntry* entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+
+// 按指针哈希的索引：槽位里存 编号+1，0 表示空槽位。容量总是 2 的幂
+static int* index_slots = NULL;
+static int index_capacity = 0;
+
+static void out_of_memory() {
+    fprintf(stderr, "Error: Out of memory (string pool)\n");
+    exit(1);
+}
+
+// 找到 content 所在的槽位；不存在时返回它应该插入的空槽位
+static int* lookup_slot(const char* content) {
+    unsigned mask = (unsigned)index_capacity - 1;
+    unsigned i = hash_atom(content) & mask;
+    while (index_slots[i] != 0 && entries[index_slots[i] - 1].content != content) {
+        i = (i + 1) & mask;
+    }
+    return &index_slots[i];
+}
+
+static void grow_index() {
+    int* old = index_slots;
+    int old_capacity = index_capacity;
+
+    index_capacity = old_capacity == 0 ? 256 : old_capacity * 2;
+    index_slots = (int*)calloc(index_capacity, sizeof(int));
+    if (!index_slots) out_of_memory();
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i] != 0) {
+            *lookup_slot(entries[old[i] - 1].content) = old[i];
+        }
+    }
+    free(old);
+}
+
+int strpool_add(char* content) {
+    if ((entry_count + 1) * 4 > index_capacity * 3) {
+        grow_index();
+    }
+
+    int* slot = lookup_slot(content);
+    if (*slot != 0) {
+        return *slot - 1; // 同一个字面量已经登记过了
+    }
+
+    if (entry_count == entry_capacity) {
+        entry_capacity = entry_capacity == 0 ? 256 : entry_capacity * 2;
+        entries = (StringEntry*)realloc(entries, entry_capacity * sizeof(StringEntry));
+        if (!entries) out_of_memory();
+    }
+    int id = entry_count++;
+    entries[id].content = content;
+    entries[id].len = (int)strlen(content);
+    *slot = id + 1;
+    return id;
+}
+
+// --- 后缀合并 ---
+
+// 从尾部往前比较两个字符串 (即比较它们的逆序串)。
+// 排好序以后，如果 a 是 b 的后缀，a 的逆序串就是 b 的逆序串的前缀，a 一定紧挨在 b 前面
+static int compare_reversed(const void* x, const void* y) {
+    const StringEntry* a = &entries[*(const int*)x];
+    const StringEntry* b = &entries[*(const int*)y];
+    int i = a->len - 1, j = b->len - 1;
+    while (i >= 0 && j >= 0) {
+        unsigned char ca = (unsigned char)a->content[i--];
+        unsigned char cb = (unsigned char)b->content[j--];
+        if (ca != cb) return ca < cb ? -1 : 1;
+    }
+    return (i >= 0) - (j >= 0); // 短的 (后缀) 排在前面
+}
+
+// content 是原始文本，里面可能有转义序列。只有当 pos 恰好落在两个字符之间
+// (而不是 "\n" 或 "\101" 这样的转义序列中间) 时，才能从这里切开
+static int is_char_boundary(const char* content, int len, int pos) {
+    int i = 0;
+    while (i < pos) {
+        if (content[i] != '\\' || i + 1 >= len) {
+            i++;
+        } else if (content[i + 1] >= '0' && content[i + 1] <= '7') {
+            // 八进制转义: 最多 3 位
+            int j = i + 1;
+            while (j < len && j < i + 4 && content[j] >= '0' && content[j] <= '7') j++;
+            i = j;
+        } else if (content[i + 1] == 'x') {
+            // 十六进制转义: 汇编器会吃掉后面所有的十六进制数字
+            int j = i + 2;
+            while (j < len && ((content[j] >= '0' && content[j] <= '9') ||
+                               (content[j] >= 'a' && content[j] <= 'f') ||
+                               (content[j] >= 'A' && content[j] <= 'F'))) j++;
+            i = j;
+        } else {
+            i += 2;
+        }
+    }
+    return i == pos;
+}
+
+// 按长度从长到短
+static int compare_length_desc(const void* x, const void* y) {
+    return entries[*(const int*)y].len - entries[*(const int*)x].len;
+}
+
+static void emit_plain() {
+    for (int i = 0; i < entry_count; i++) {
+        emit(".LC%d:\n", i);
+        emit("  .string \"%s\"\n", entries[i].content);
+    }
+}
+
+static void emit_merged() {
+    int n = entry_count;
+    if (n == 0) return;
+    int* order = (int*)malloc(n * sizeof(int));
+    int* parent = (int*)malloc(n * sizeof(int));   // 直接包含它的那个更长的字符串，没有则为 -1
+    int* root_of = (int*)malloc(n * sizeof(int));  // 它最终落在哪个要输出的字符串里
+    int* members = (int*)malloc(n * sizeof(int));  // 按所属的根分组后的编号
+    int* group_start = (int*)calloc(n + 1, sizeof(int));
+    if (!order || !parent || !root_of || !members || !group_start) out_of_memory();
+
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+        parent[i] = -1;
+    }
+    qsort(order, n, sizeof(int), compare_reversed);
+    for (int k = 0; k + 1 < n; k++) {
+        StringEntry* a = &entries[order[k]];
+        StringEntry* b = &entries[order[k + 1]];
+        int cut = b->len - a->len;
+        if (cut > 0 && memcmp(b->content + cut, a->content, a->len) == 0 &&
+            is_char_boundary(b->content, b->len, cut)) {
+            parent[order[k]] = order[k + 1];
+        }
+    }
+
+    // 顺着 parent 找到每个字符串的根 (真正要输出的那个)，按根分组 (计数排序)
+    for (int i = 0; i < n; i++) {
+        int root = i;
+        while (parent[root] != -1) root = parent[root];
+        root_of[i] = root;
+        group_start[root + 1]++;
+    }
+    for (int i = 0; i < n; i++) group_start[i + 1] += group_start[i];
+    int* fill = order; // order 已经用完了，拿来当写指针
+    for (int i = 0; i < n; i++) fill[i] = group_start[i];
+    for (int i = 0; i < n; i++) members[fill[root_of[i]]++] = i;
+
+    // 每个根输出一次：从长到短，在每个后缀开始的位置插入它的标签
+    for (int root = 0; root < n; root++) {
+        int count = group_start[root + 1] - group_start[root];
+        if (count == 0) continue;
+        int* group = members + group_start[root];
+        qsort(group, count, sizeof(int), compare_length_desc);
+
+        StringEntry* r = &entries[root];
+        int pos = 0;
+        emit(".LC%d:\n", root);
+        for (int k = 1; k < count; k++) {
+            int start = r->len - entries[group[k]].len;
+            if (start > pos) {
+                emit("  .ascii \"");
+                emit_strn(r->content + pos, start - pos);
+                emit("\"\n");
+            }
+            emit(".LC%d:\n", group[k]);
+            pos = start;
+        }
+        emit("  .string \"%s\"\n", r->content + pos);
+    }
+
+    free(order);
+    free(parent);
+    free(root_of);
+    free(members);
+    free(group_start);
+}
+
+void strpool_emit() {
+    // 可合并的字符串段：元素大小 1，内容是以 '\0' 结尾的字符串，
+    // 链接器会把所有目标文件里相同的字符串合并成一份
+    emit("\n.section .rodata.str1.1,\"aMS\",@progbits,1\n");
+    if (strpool_merge_suffixes) {
+        emit_merged();
+    } else {
+        emit_plain();
+    }
+}
+
+void strpool_free() {
+    free(entries);
+    free(index_slots);
+    entries = NULL;
+    index_slots = NULL;
+    entry_count = entry_capacity = index_capacity = 0;
+}
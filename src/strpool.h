@@ -0,0 +1,23 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+// --- 字符串字面量池 ---
+// 代码生成时遇到字符串字面量就登记到这里，拿到一个编号 N (汇编里的标签 .LCN)，
+// 所有函数生成完以后再把整个池子输出到只读数据段。
+//   * 字面量都是驻留过的指针 (intern.h)，按指针哈希去重，O(1)；
+//   * 容量按需增长，没有固定上限；
+//   * 输出到可合并的字符串段 .rodata.str1.1 ("aMS")，链接器可以跨目标文件去重；
+//   * 可选的后缀合并：一个字面量如果是另一个的后缀 ("world" 和 "hello world")，
+//     就不单独存放，它的标签直接指向长字符串的尾部。
+
+// 为 1 时 strpool_emit() 做后缀合并 (命令行 --merge-strings)
+extern int strpool_merge_suffixes;
+
+// 登记一个 (驻留过的) 字符串字面量，返回它的编号；同一个字面量总是返回同一个编号
+int strpool_add(char* content);
+// 把整个池子输出到 emitter (见 emit.h)
+void strpool_emit();
+// 清空池子并释放内存
+void strpool_free();
+
+#endif // STRPOOL_H
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtab.h"
+#include "arena.h"
+#include "intern.h"
+
+// 哈希表的一个槽位。key 一旦放进来，在本函数内就不会被删除：
+// 离开作用域时只是把 symbol 改回被遮蔽的外层符号 (可能是 NULL)，
+// 所以线性探测永远不需要 "墓碑"。
+typedef struct {
+    char* key;
+    Symbol* symbol; // 当前可见的、名字为 key 的最内层符号
+} Slot;
+
+static Slot* slots = NULL;
+static int slot_capacity = 0;  // 总是 2 的幂
+static int slot_used = 0;      // 已占用的槽位 (key 不为 NULL)
+
+// 所有符号按声明顺序压在这个栈上；作用域栈记录每个作用域开始时的栈高度
+static Symbol** symbols = NULL;
+static int symbol_count = 0;
+static int symbol_capacity = 0;
+
+static int* scopes = NULL;
+static int scope_count = 0;
+static int scope_capacity = 0;
+
+// 符号本身从 arena 分配，保证指针稳定；每个函数结束后整体释放
+static Arena symbol_arena;
+
+static void* grow(void* array, int* capacity, size_t elem_size) {
+    *capacity = *capacity == 0 ? 64 : *capacity * 2;
+    array = realloc(array, *capacity * elem_size);
+    if (!array) {
+        fprintf(stderr, "Error: Out of memory (symbol table)\n");
+        exit(1);
+    }
+    return array;
+}
+
+// 找到 name 所在的槽位；不存在时返回它应该插入的空槽位。
+// 同名 <=> 同一个驻留指针，所以比较指针即可
+static Slot* lookup_slot(const char* name) {
+    unsigned mask = (unsigned)slot_capacity - 1;
+    unsigned i = hash_atom(name) & mask;
+    while (slots[i].key != NULL && slots[i].key != name) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+// 负载因子超过 3/4 时容量翻倍，并把所有 key 重新放一遍
+static void grow_slots() {
+    Slot* old = slots;
+    int old_capacity = slot_capacity;
+
+    slot_capacity = old_capacity == 0 ? 64 : old_capacity * 2;
+    slots = (Slot*)calloc(slot_capacity, sizeof(Slot));
+    if (!slots) {
+        fprintf(stderr, "Error: Out of memory (symbol table)\n");
+        exit(1);
+    }
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].key != NULL) {
+            *lookup_slot(old[i].key) = old[i];
+        }
+    }
+    free(old);
+}
+
+void symtab_reset() {
+    if (slot_capacity == 0) grow_slots();
+    memset(slots, 0, slot_capacity * sizeof(Slot));
+    slot_used = 0;
+    symbol_count = 0;
+    scope_count = 0;
+    arena_free(&symbol_arena);
+}
+
+void symtab_push_scope() {
+    if (scope_count == scope_capacity) {
+        scopes = (int*)grow(scopes, &scope_capacity, sizeof(int));
+    }
+    scopes[scope_count++] = symbol_count;
+}
+
+void symtab_pop_scope() {
+    if (scope_count == 0) return;
+    int mark = scopes[--scope_count];
+    // 倒序撤销本作用域的声明，恢复被它们遮蔽的外层符号
+    while (symbol_count > mark) {
+        Symbol* sym = symbols[--symbol_count];
+        lookup_slot(sym->name)->symbol = sym->shadowed;
+    }
+}
+
+Symbol* symtab_declare(char* name) {
+    if (slot_capacity == 0 || (slot_used + 1) * 4 > slot_capacity * 3) {
+        grow_slots();
+    }
+
+    Symbol* sym = (Symbol*)arena_alloc(&symbol_arena, sizeof(Symbol));
+    sym->name = name;
+    sym->stack_offset = 0;
+    sym->type = 0;
+    sym->struct_name = NULL;
+    sym->slot = -1;
+
+    Slot* slot = lookup_slot(name);
+    if (slot->key == NULL) {
+        slot->key = name;
+        slot_used++;
+    }
+    sym->shadowed = slot->symbol;
+    slot->symbol = sym;
+
+    if (symbol_count == symbol_capacity) {
+        symbols = (Symbol**)grow(symbols, &symbol_capacity, sizeof(Symbol*));
+    }
+    symbols[symbol_count++] = sym;
+    return sym;
+}
+
+Symbol* find_symbol(char* name) {
+    if (slot_capacity == 0) return NULL;
+    return lookup_slot(name)->symbol;
+}
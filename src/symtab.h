@@ -0,0 +1,33 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+// --- 局部变量符号表 ---
+// 开放寻址 (线性探测) 的哈希表 + 作用域栈：
+//   * 查找是 O(1) 期望时间，不再线性扫描；
+//   * 容量按需翻倍，没有固定上限；
+//   * 进入代码块时 symtab_push_scope()，离开时 symtab_pop_scope()，
+//     内层声明会遮蔽 (shadow) 外层的同名变量，离开作用域后自动恢复。
+// 传进来的名字必须是驻留过的指针 (intern.h)，表里只比较指针。
+
+typedef struct Symbol {
+    char* name;
+    int stack_offset;   // 变量在栈上的偏移量 ([rbp-N] 中的 N)
+    int type;           // DataType: TYPE_INT / TYPE_CHAR / TYPE_STRUCT
+    char* struct_name;  // 结构体变量对应的结构体名
+    int slot;           // 给各个 pass 用的变量编号：IR 降低时是局部变量槽位 (见 ir.h)，
+                        // 常量传播时是 fold.c 里变量表的下标
+    struct Symbol* shadowed; // 被本符号遮蔽的外层同名符号 (没有则为 NULL)
+} Symbol;
+
+// 开始一个新函数：清空所有符号和作用域
+void symtab_reset();
+// 进入 / 离开一个作用域
+void symtab_push_scope();
+void symtab_pop_scope();
+// 在当前作用域中声明一个变量，返回新符号 (由调用方填写 offset/type 等字段)。
+// 返回的指针在下一次 symtab_reset() 之前一直有效。
+Symbol* symtab_declare(char* name);
+// 由内向外查找变量，找不到返回 NULL (调用方把它当作全局变量)
+Symbol* find_symbol(char* name);
+
+#endif // SYMTAB_H
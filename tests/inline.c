@@ -0,0 +1,89 @@
+// 函数内联：每种改写都至少有一个调用点 (make test 会按默认阈值和 --inline-threshold=0 各跑一遍，输出必须一样)
+int g;
+int x;
+int calls;
+
+// 表达式内联：函数体只有一条 return
+int add(int a, int b) { return a + b; }
+int sq(int v) { return v * v; }
+int twice(int v) { return v + v; }
+// 有副作用的实参只能求值一次
+int side(int v) { calls = calls + 1; return v; }
+// char 形参：实参按 1 字节截断
+int trunc(char c) { return c; }
+
+// 语句内联：提前 return 改成给结果变量赋值，后面的语句挪进另一个分支
+// (early 和 both 的 return 后面还有外层块的语句，改写不了，不内联)
+int early(int n) { int r = 0; if (n > 5) { r = 1; if (n > 10) return 2; } return r; }
+int blk(int n) { if (n > 0) { if (n > 5) return 1; } else { return 2; } return 3; }
+int both(int a) { int t = 0; if (a > 3) { int t = 5; if (a > 4) return t; } return t + a; }
+int pick(int n) { if (n < 0) return 0; int r = n * 2; if (r > 10) return 10; return r; }
+int loopy(int n) { int s = 0; for (int i = 0; i < n; i = i + 1) { s = s + i; } return s; }
+int countdown(int n) { int s = 0; while (n > 0) { s = s + n; n = n - 1; } return s; }
+int bump(int k) { g = g + k; return g; }
+
+// 被调函数读全局变量 x，调用者有同名局部变量：不能内联 (展开以后 x 会指向局部变量)
+int readx(int k) { return x + k; }
+int shadow(int k) { int x = 100; int r = readx(k); return r + x; }
+
+// 递归 (包括互相递归) 的函数不内联
+int fact(int n) { if (n <= 1) return 1; return n * fact(n - 1); }
+int ping(int n) { if (n <= 0) return 0; return 1 + pong(n - 1); }
+int pong(int n) { if (n <= 0) return 0; return 2 + ping(n - 1); }
+
+// 被调函数自己的调用先内联好，再整个展开到调用者里
+int sum3(int a, int b, int c) { int t = add(a, b); return add(t, c); }
+
+int main() {
+    int s = 0;
+    int i = 0;
+    while (i < 10) {
+        s = s + add(i, sq(i));
+        i = i + 1;
+    }
+    printf("%d\n", s);
+
+    int y = 0;
+    y = twice(side(3));
+    printf("%d %d\n", y, calls);
+    printf("%d %d\n", trunc(300), trunc(65));
+    int tv = trunc(s - 30);
+    printf("%d\n", tv);
+
+    // 循环里的调用点允许展开更大的函数 (阈值 * (1 + 循环深度))，语句内联的几种改写都在这里
+    for (int k = 0; k < 2; k = k + 1) {
+        int e1 = early(3 + k);
+        int e2 = early(7 + k);
+        int e3 = early(12 + k);
+        printf("%d %d %d\n", e1, e2, e3);
+        int b1 = blk(3 - k);
+        int b2 = blk(7 - k);
+        int b3 = blk(0 - k);
+        printf("%d %d %d\n", b1, b2, b3);
+        int t1 = both(2 + k);
+        int t2 = both(4 + k);
+        int t3 = both(5 + k);
+        printf("%d %d %d\n", t1, t2, t3);
+        int p1 = pick(0 - k);
+        int p2 = pick(3 + k);
+        int p3 = pick(9 - k);
+        printf("%d %d %d\n", p1, p2, p3);
+        int l = loopy(5 + k);
+        int c = 0;
+        c = countdown(4 + k);
+        printf("%d %d\n", l, c);
+    }
+
+    bump(1);
+    int m = bump(2);
+    m = bump(3);
+    printf("%d %d\n", m, g);
+
+    x = 7;
+    int sh = shadow(1);
+    printf("%d\n", sh);
+    printf("%d %d\n", fact(6), ping(5));
+    int s3 = sum3(1, 2, 3);
+    printf("%d\n", s3);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// 寄存器分配：跨调用活着的值只能放被调用者保存的寄存器，活值太多时要溢出，
+// 6 个参数的调用要把实参按任意排列搬进参数寄存器
+
+// 6 个参数，返回值能看出每个参数的位置
+int rot(int a, int b, int c, int d, int e, int f) {
+    return a * 100000 + b * 10000 + c * 1000 + d * 100 + e * 10 + f;
+}
+// 破坏所有调用者保存的寄存器 (它自己也有不少活值)
+int clobber(int n) {
+    int a = n + 1; int b = n + 2; int c = n + 3; int d = n + 4;
+    int e = n + 5; int f = n + 6; int g = n + 7; int h = n + 8;
+    return a * b - c * d + e * f - g * h;
+}
+int id(int v) { return v; }
+
+// char 参数夹在其它参数中间：每个参数都要从自己的参数寄存器搬过来 (char 还要截断成 1 字节)
+int f2(char a, char b, char c) { if ((!b + c) * 24) return 0; return 48; }
+int mixed(char a, int b, char c, int d, char e, int f) {
+    return a * 100000 + b * 10000 + c * 1000 + d * 100 + e * 10 + f;
+}
+int mixed_rev(int a, char b, int c, char d, int e, char f) {
+    return a + b * 10 + c * 10000 + d * 100000 + e * 100000000 - f;
+}
+
+// 十几个值跨过调用一直活着：被调用者保存的寄存器不够用，剩下的要溢出到栈上
+int many_live(int n) {
+    int v1 = n + 1; int v2 = n + 2; int v3 = n + 3; int v4 = n + 4;
+    int v5 = n + 5; int v6 = n + 6; int v7 = n + 7; int v8 = n + 8;
+    int v9 = n + 9; int v10 = n + 10; int v11 = n + 11; int v12 = n + 12;
+    int v13 = n + 13; int v14 = n + 14;
+    int k = clobber(n);
+    int m = id(k + v1);
+    return v1 + v2 * 2 + v3 * 3 + v4 * 4 + v5 * 5 + v6 * 6 + v7 * 7 + v8 * 8 +
+           v9 * 9 + v10 * 10 + v11 * 11 + v12 * 12 + v13 * 13 + v14 * 14 + k + m;
+}
+
+// 循环里有调用，循环变量和累加器跨调用活着
+int loop_calls(int n) {
+    int s = 0;
+    int p = 1;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s + clobber(i) + p;
+        p = p + id(i) * 2;
+    }
+    return s * 1000 + p;
+}
+
+// 实参是形参的各种排列：参数寄存器之间的并行赋值
+int permute(int a, int b, int c, int d, int e, int f) {
+    int r1 = rot(f, e, d, c, b, a);
+    int r2 = rot(b, a, d, c, f, e);
+    int r3 = rot(b, c, d, e, f, a);
+    int r4 = rot(a, a, b, b, c, c);
+    return r1 + r2 + r3 + r4;
+}
+
+// 递归：每一层都保存、恢复被调用者保存的寄存器；值跨过递归调用活着
+int tree(int depth, int seed) {
+    if (depth == 0) return seed;
+    int x = seed * 3 + 1;
+    int y = seed * 5 + 2;
+    int left = tree(depth - 1, x - x / 97 * 97);
+    int right = tree(depth - 1, y - y / 89 * 89);
+    return left + right + x - y + depth;
+}
+
+int main() {
+    printf("%d\n", rot(1, 2, 3, 4, 5, 6));
+    printf("%d %d\n", many_live(0), many_live(10));
+    printf("%d\n", loop_calls(20));
+    printf("%d\n", permute(1, 2, 3, 4, 5, 6));
+    printf("%d\n", tree(10, 7));
+    printf("%d %d\n", f2(1, 2, 0), f2(1, 0, 0));
+    printf("%d %d\n", mixed(1, 2, 3, 4, 5, 6), mixed(257, 2, 259, 4, 261, 6));
+    printf("%d %d\n", mixed_rev(1, 2, 3, 4, 5, 6), mixed_rev(7, 300, 9, 511, 11, 256));
+    int a = 1; int b = 2; int c = 3; int d = 4; int e = 5; int f = 6;
+    int g = 7; int h = 8; int i = 9; int j = 10; int k = 11; int l = 12;
+    int r = rot(l, k, j, i, h, g);
+    printf("%d %d %d %d %d\n", a, b, c, d, e);
+    printf("%d %d %d %d %d\n", f, g, h, i, j);
+    printf("%d %d %d\n", k, l, r);
+    return 0;
+}
@@ -0,0 +1,98 @@
+// mem2reg / SSA：循环里的变量变成 phi，出 SSA 时要拆关键边、把成环的并行复制排成顺序
+
+// 循环携带的两个变量每轮交换：phi 之间成环 (a <- b, b <- a)
+int fib(int n) {
+    int a = 0;
+    int b = 1;
+    int i = 0;
+    while (i < n) {
+        int t = a + b;
+        a = b;
+        b = t;
+        i = i + 1;
+    }
+    return a;
+}
+int swap_loop(int n) {
+    int x = 1;
+    int y = 2;
+    int z = 3;
+    for (int i = 0; i < n; i = i + 1) {
+        int t = x;
+        x = y;
+        y = z;
+        z = t;
+    }
+    return x * 100 + y * 10 + z;
+}
+
+// break / continue：循环出口和循环头都有多个前驱
+int breaks(int n) {
+    int s = 0;
+    int i = 0;
+    while (1) {
+        i = i + 1;
+        if (i > n) break;
+        if (i - i / 3 * 3 == 0) continue;
+        if (s > 1000) break;
+        s = s + i;
+    }
+    return s * 1000 + i;
+}
+int nested(int n) {
+    int total = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        int j = 0;
+        while (j < i) {
+            j = j + 1;
+            if (j == 3) continue;
+            if (j > 6) break;
+            total = total + i * j;
+        }
+    }
+    return total;
+}
+
+// char 局部变量：提升成 SSA 值以后，每次写入仍然要截断成 1 字节
+int chars(int n) {
+    char c = 250;
+    char d = 0;
+    int i = 0;
+    while (i < n) {
+        c = c + 3;
+        d = d + c;
+        i = i + 1;
+    }
+    return c * 1000 + d;
+}
+
+// 条件里更新变量：分支汇合处的 phi，else 分支为空 (关键边)
+int collatz(int n) {
+    int steps = 0;
+    while (n != 1) {
+        if (n - n / 2 * 2 == 0) n = n / 2;
+        else n = 3 * n + 1;
+        steps = steps + 1;
+    }
+    return steps;
+}
+int max_run(int n) {
+    int best = 0;
+    int run = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        if (i - i / 5 * 5 != 0) run = run + 1;
+        else run = 0;
+        if (run > best) best = run;
+    }
+    return best;
+}
+
+int main() {
+    printf("%d %d\n", fib(10), fib(40));
+    printf("%d %d %d\n", swap_loop(0), swap_loop(1), swap_loop(5));
+    printf("%d %d\n", breaks(10), breaks(200));
+    printf("%d\n", nested(10));
+    printf("%d %d\n", chars(1), chars(100));
+    printf("%d %d\n", collatz(27), max_run(23));
+    return 0;
+}
@@ -0,0 +1,112 @@
+// 栈槽共用：作用域不重叠的局部变量共用同一段栈空间。
+// 外层还活着的变量、取过地址的变量 (-O 下也一直在栈上) 都不能被兄弟作用域里的变量覆盖
+struct Pair {
+    int a;
+    int b;
+};
+
+int g;
+int keep(int p) { g = p; return 0; }
+
+// if 和 else 两边共用栈槽；外层的 x 取过地址，整个函数里都要保持原值
+int branches(int n) {
+    int x = n * 3;
+    keep(&x);
+    int r = 0;
+    if (n > 5) {
+        int a[4];
+        a[0] = n;
+        a[1] = n + 1;
+        a[2] = n + 2;
+        a[3] = n + 3;
+        r = a[0] + a[3];
+    } else {
+        char c = 200;
+        int b[3];
+        b[0] = 7;
+        b[1] = 8;
+        b[2] = 9;
+        r = c + b[2];
+    }
+    return r * 1000 + x;
+}
+
+// 先后两个循环体共用栈槽；外层的 y 取过地址，total 跨两个循环一直活着
+int loops(int n) {
+    int total = 0;
+    int y = 5;
+    keep(&y);
+    for (int i = 0; i < n; i = i + 1) {
+        int t[3];
+        t[0] = i;
+        t[1] = i * 2;
+        t[2] = i * 3;
+        total = total + t[0] + t[1] + t[2];
+    }
+    for (int k = 0; k < n; k = k + 1) {
+        struct Pair p;
+        p.a = k;
+        p.b = y;
+        int u = p.a * p.b;
+        keep(&u);
+        total = total + u;
+    }
+    return total * 10 + y;
+}
+
+// 嵌套的兄弟块：内层两个块共用栈槽，外层块里的 a 和 arr 在两个内层块之后还要用
+int nested(int n) {
+    int out = 0;
+    {
+        int a = n + 1;
+        int arr[2];
+        arr[0] = a;
+        arr[1] = a * 2;
+        keep(&a);
+        {
+            int b[3];
+            b[0] = 1;
+            b[1] = 2;
+            b[2] = 3;
+            out = out + b[0] + b[1] + b[2];
+        }
+        {
+            int c[3];
+            c[0] = 40;
+            c[1] = 50;
+            c[2] = 60;
+            keep(&c[1]);
+            out = out + c[0] + c[1] + c[2];
+        }
+        out = out + a * 1000 + arr[0] * 10000 + arr[1] * 100000;
+    }
+    {
+        int d = 9;
+        keep(&d);
+        out = out + d * 10000000;
+    }
+    return out;
+}
+
+// 内联展开出来的块也共用栈槽：sum3 展开两次，调用者的 v 取过地址
+int sum3(int v) {
+    int w[3];
+    w[0] = v;
+    w[1] = v * 2;
+    w[2] = v * 3;
+    return w[0] + w[1] + w[2];
+}
+int inlined(int n) {
+    int v = n;
+    keep(&v);
+    int s = sum3(n) + sum3(n + 1);
+    return s * 100 + v;
+}
+
+int main() {
+    printf("%d %d\n", branches(3), branches(8));
+    printf("%d %d\n", loops(0), loops(4));
+    printf("%d\n", nested(4));
+    printf("%d\n", inlined(7));
+    return 0;
+}
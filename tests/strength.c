@@ -0,0 +1,45 @@
+// 强度削弱：乘除常数换成 shl / lea / 魔数乘法，结果要和真正的 imul / idiv 一模一样。
+// 除法向零取整：负的被除数、负的除数、INT64_MIN 都要对。
+// TinyC 的 int 是 64 位的，所以用 %ld 打印；期望输出是在 stdio.h 之后 #define int long 再用 gcc 编出来的
+int div2(int x) { return x / 2; }
+int div4(int x) { return x / 4; }
+int div3(int x) { return x / 3; }
+int div7(int x) { return x / 7; }
+int div10(int x) { return x / 10; }
+int div_m3(int x) { return x / -3; }
+int div_m7(int x) { return x / -7; }
+
+int mul9(int x) { return x * 9; }
+int mul10(int x) { return 10 * x; }
+int mul15(int x) { return x * 15; }
+int mul_m3(int x) { return x * -3; }
+int mul_m10(int x) { return x * -10; }
+
+int main() {
+    // 放进数组里在运行时读出来，常量折叠和内联都没法提前算掉
+    int v[12];
+    v[0] = 0;
+    v[1] = 1;
+    v[2] = -1;
+    v[3] = 7;
+    v[4] = -7;
+    v[5] = 20;
+    v[6] = -20;
+    v[7] = 123456789012;
+    v[8] = -123456789012;
+    v[9] = 9223372036854775807;
+    v[10] = -9223372036854775807 - 1;
+    v[11] = -9223372036854775807;
+    for (int i = 0; i < 12; i = i + 1) {
+        int x = v[i];
+        printf("%ld: %ld %ld %ld", x, div2(x), div4(x), div3(x));
+        printf(" %ld %ld %ld %ld\n", div7(x), div10(x), div_m3(x), div_m7(x));
+    }
+    // 乘法只用不会溢出的值
+    for (int i = 0; i < 9; i = i + 1) {
+        int x = v[i];
+        printf("%ld: %ld %ld %ld", x, mul9(x), mul10(x), mul15(x));
+        printf(" %ld %ld\n", mul_m3(x), mul_m10(x));
+    }
+    return 0;
+}
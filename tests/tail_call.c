@@ -0,0 +1,49 @@
+// 尾调用：下面的递归都在尾部，深度 1000 万，不变成跳转的话栈早就溢出了
+struct Pair {
+    int a;
+    int b;
+};
+
+// 调用自己：变成跳回函数开头的循环
+int deep(int n, int acc) { if (n == 0) return acc; return deep(n - 1, acc + 1); }
+// 实参是形参交换了位置：放进参数寄存器时要并行赋值 (xchg 拆环)
+int swp(int a, int b, int n) { if (n == 0) return a * 10 + b; return swp(b, a, n - 1); }
+int rot(int a, int b, int c, int n) { if (n == 0) return a * 100 + b * 10 + c; return rot(c, a, b, n - 1); }
+// char 形参：跳回去以后照样按 1 字节存
+int wrap(int n, char c) { if (n == 0) return c; return wrap(n - 1, c + 1); }
+
+// 调用别的函数：拆掉栈帧以后 jmp 过去 (互相递归也不会让栈增长)
+int is_even(int n) { if (n == 0) return 1; return is_odd(n - 1); }
+int is_odd(int n) { if (n == 0) return 0; return is_even(n - 1); }
+int twice(int v) { return v + v; }
+int forward(int v) { return twice(v + 1); }
+
+// 栈帧里的地址可能被被调函数用到时不做尾调用：取过地址、有数组、有结构体
+int g;
+int keep(int p) { g = p; return 1; }
+int addr(int n, int acc) { int x = n; if (n == 0) return acc + keep(&x) - 1; return addr(n - 1, acc + x); }
+int sum_array(int n, int acc) {
+    int a[4];
+    a[0] = n;
+    if (n == 0) return acc;
+    return sum_array(n - 1, acc + a[0]);
+}
+int sum_pair(int n, int acc) {
+    struct Pair p;
+    p.a = n;
+    p.b = acc;
+    if (n == 0) return p.b;
+    return sum_pair(n - 1, p.a + p.b);
+}
+
+int main() {
+    printf("%d\n", deep(10000000, 0));
+    printf("%d %d\n", swp(1, 2, 10000000), swp(1, 2, 10000001));
+    printf("%d %d\n", rot(1, 2, 3, 10000000), rot(1, 2, 3, 10000001));
+    printf("%d\n", wrap(9999972, 0));
+    printf("%d %d\n", is_even(10000000), is_odd(10000001));
+    printf("%d\n", forward(20));
+    printf("%d\n", addr(1000, 0));
+    printf("%d %d\n", sum_array(1000, 0), sum_pair(1000, 0));
+    return 0;
+}